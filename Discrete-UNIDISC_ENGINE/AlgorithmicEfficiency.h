@@ -1,5 +1,9 @@
 #pragma once
 #include "Core.h"
+#include "RegistrationEngine.h"
+#include "DatasetGenerator.h"
+#include "Set.h"
+#include "Relation.h"
 #include <vector>
 #include <iostream>
 #include <string>
@@ -8,11 +12,15 @@
 #include <algorithm>
 #include <functional>
 #include <chrono>
+#include <thread>
+#include <random>
+#include <atomic>
+#include <cmath>
 using namespace std::chrono;
 
 class EfficiencyModule {
 private:
-    DataManager* dm;
+    const DataManager* dm;
     map<string, vector<string>> memoizedPaths;
 
     vector<string> getPrerequisitePath(const string& courseID) {
@@ -21,7 +29,7 @@ private:
         }
 
         vector<string> path;
-        Course* course = dm->getCourse(courseID);
+        const Course* course = dm->getCourse(courseID);
 
         if (!course) return path;
 
@@ -37,8 +45,8 @@ private:
     }
 
 public:
-    EfficiencyModule() {
-        dm = DataManager::getInstance();
+    explicit EfficiencyModule(DataManager* manager) {
+        dm = manager;
     }
 
     void benchmarkPrerequisitePaths() {
@@ -52,11 +60,11 @@ public:
         auto start = high_resolution_clock::now();
 
         for (int i = 0; i < 100; i++) {
-            for (auto& pair : dm->getAllCourses()) {
+            for (const Course& c : dm->getAllCourses()) {
                 vector<string> path;
-                Course* course = dm->getCourse(pair.first);
+                const Course* course = dm->getCourse(c.getID());
                 if (course) {
-                    path.push_back(pair.first);
+                    path.push_back(c.getID());
                 }
             }
         }
@@ -70,8 +78,8 @@ public:
         start = high_resolution_clock::now();
 
         for (int i = 0; i < 100; i++) {
-            for (auto& pair : dm->getAllCourses()) {
-                getPrerequisitePath(pair.first);
+            for (const Course& course : dm->getAllCourses()) {
+                getPrerequisitePath(course.getID());
             }
         }
 
@@ -140,6 +148,760 @@ public:
         cout << "Speedup: " << (double)duration1.count() / duration2.count() << "x" << endl;
     }
 
+    // Registration-day stress test on a scratch catalog: every thread fires
+    // random enroll/drop/lab-seat requests, skewed towards a few popular
+    // courses, first on one thread and then on `threadCount`. Returns whether
+    // the lab capacity and roster invariants still hold afterwards.
+    bool benchmarkConcurrentRegistration(int threadCount = 0, int requestsPerThread = 50000) {
+        cout << "\n--- Benchmarking Concurrent Registration ---" << endl;
+        if (threadCount <= 0) threadCount = max(1, (int)thread::hardware_concurrency());
+
+        const int STUDENTS = 20000;
+        const int COURSES = 200;
+        const int HOT_COURSES = 10;
+        const int LABS_PER_COURSE = 2;
+        const int LAB_CAPACITY = 25;
+
+        DataManager scratch;
+        vector<Course> courses;
+        for (int c = 0; c < COURSES; c++) {
+            courses.push_back(Course("BENCH-C" + to_string(c), "Benchmark Course", 3));
+        }
+        scratch.addCourses(courses);
+        vector<Student> students;
+        for (int s = 0; s < STUDENTS; s++) {
+            students.push_back(Student("BENCH-S" + to_string(s), "Benchmark Student"));
+        }
+        scratch.addStudents(students);
+        vector<vector<Handle>> labsOfCourse(COURSES);
+        for (int c = 0; c < COURSES; c++) {
+            for (int l = 0; l < LABS_PER_COURSE; l++) {
+                Lab lab("BENCH-L" + to_string(c) + "-" + to_string(l), courses[c].getID(), LAB_CAPACITY);
+                scratch.addLab(lab);
+                labsOfCourse[c].push_back(lab.getHandle());
+            }
+        }
+
+        RegistrationEngine engine(scratch);
+        atomic<long long> accepted(0);
+
+        auto runRound = [&](int threads, unsigned seed) -> double {
+            auto worker = [&](unsigned workerSeed) {
+                mt19937 rng(workerSeed);
+                long long ok = 0;
+                for (int i = 0; i < requestsPerThread; i++) {
+                    Handle student = students[rng() % STUDENTS].getHandle();
+                    int c = (rng() % 2) ? (int)(rng() % HOT_COURSES) : (int)(rng() % COURSES);
+                    Handle course = courses[c].getHandle();
+                    unsigned op = rng() % 10;
+                    RegistrationEngine::Status status;
+                    if (op < 6) status = engine.enroll(student, course);
+                    else if (op < 8) status = engine.drop(student, course);
+                    else status = engine.joinLab(student, labsOfCourse[c][rng() % LABS_PER_COURSE]);
+                    if (status == RegistrationEngine::OK) ok++;
+                }
+                accepted += ok;
+            };
+
+            auto start = high_resolution_clock::now();
+            vector<thread> pool;
+            for (int t = 0; t < threads; t++) pool.push_back(thread(worker, seed + t));
+            for (thread& t : pool) t.join();
+            return duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+        };
+
+        double single = runRound(1, 1);
+        double parallel = runRound(threadCount, 100);
+        double singleRate = requestsPerThread / single;
+        double parallelRate = (double)requestsPerThread * threadCount / parallel;
+
+        cout << "Catalog: " << STUDENTS << " students, " << COURSES << " courses, "
+            << COURSES * LABS_PER_COURSE << " labs of " << LAB_CAPACITY << " seats" << endl;
+        cout << "1 thread:  " << (long long)singleRate << " requests/sec" << endl;
+        cout << threadCount << " threads: " << (long long)parallelRate << " requests/sec ("
+            << parallelRate / singleRate << "x)" << endl;
+        cout << "Accepted requests: " << accepted.load() << endl;
+
+        string failure;
+        bool ok = engine.verifyInvariants(failure);
+        cout << "Invariants: " << (ok ? "hold" : "VIOLATED - " + failure) << endl;
+        return ok;
+    }
+
+    // Batch job over several terms that share one course catalog: each term
+    // gets its own DataManager, students and enrollments, then reports the
+    // co-enrollment of the first courses. Runs the terms one after another and
+    // then on one thread each, and checks that both runs agree.
+    bool benchmarkConcurrentTerms(int termCount = 4, int studentsPerTerm = 20000) {
+        cout << "\n--- Benchmarking Concurrent Terms ---" << endl;
+
+        const int COURSES = 200;
+        const int REPORTED = 20;
+        vector<Course> courses;
+        for (int c = 0; c < COURSES; c++) {
+            courses.push_back(Course("TERM-C" + to_string(c), "Catalog Course", 3));
+            if (c % 10) courses.back().addPrerequisite("TERM-C" + to_string(c - 1));
+        }
+        shared_ptr<const CourseCatalog> catalog = make_shared<const CourseCatalog>(courses);
+
+        auto populate = [&](DataManager& data, const string& prefix, int term, int studentCount) {
+            vector<Student> students;
+            for (int s = 0; s < studentCount; s++) {
+                students.push_back(Student(prefix + to_string(term) + "-S" + to_string(s), "Term Student"));
+            }
+            data.addStudents(students);
+
+            mt19937 rng(term + 1);
+            vector<DataManager::EnrollmentChange> changes;
+            for (const Student& student : students) {
+                for (int k = 0; k < 5; k++) {
+                    changes.push_back(DataManager::EnrollmentChange(student.getHandle(),
+                        courses[rng() % COURSES].getHandle(), 3, DataManager::EnrollmentChange::ENROLL));
+                }
+            }
+            data.applyEnrollments(changes);
+        };
+
+        auto runTerm = [&](int term) -> size_t {
+            DataManager data(catalog);
+            populate(data, "TERM", term, studentsPerTerm);
+
+            const EnrollmentBits& bits = data.getEnrollmentBits();
+            size_t overlap = 0;
+            for (int a = 0; a < REPORTED; a++) {
+                for (int b = a + 1; b < REPORTED; b++) {
+                    overlap += BitOps::andCount(bits.enrolledStudents(courses[a].getHandle()),
+                        bits.enrolledStudents(courses[b].getHandle()), bits.studentWords());
+                }
+            }
+            return overlap;
+        };
+
+        vector<size_t> sequential(termCount), concurrent(termCount);
+        auto start = high_resolution_clock::now();
+        for (int t = 0; t < termCount; t++) sequential[t] = runTerm(t);
+        double sequentialTime = duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+
+        start = high_resolution_clock::now();
+        vector<thread> pool;
+        for (int t = 0; t < termCount; t++) {
+            pool.push_back(thread([&, t]() { concurrent[t] = runTerm(t); }));
+        }
+        for (thread& t : pool) t.join();
+        double concurrentTime = duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+
+        cout << termCount << " terms x " << studentsPerTerm << " students, one shared catalog of "
+            << catalog->size() << " courses" << endl;
+        cout << "One after another: " << (long long)(sequentialTime * 1000) << " ms" << endl;
+        cout << "Concurrently:      " << (long long)(concurrentTime * 1000) << " ms ("
+            << sequentialTime / concurrentTime << "x)" << endl;
+
+        bool match = sequential == concurrent;
+        cout << "Per-term results " << (match ? "match" : "DIFFER") << endl;
+
+        // Student handles are process-wide, so every term interns past all
+        // the others; its bit matrices must still only grow with its own.
+        const int LIVE_TERMS = 32;
+        const int LIVE_STUDENTS = 2000;
+        vector<unique_ptr<DataManager>> live;
+        size_t firstBytes = 0, lastBytes = 0;
+        for (int t = 0; t < LIVE_TERMS; t++) {
+            live.push_back(unique_ptr<DataManager>(new DataManager(catalog)));
+            populate(*live.back(), "LIVE", t, LIVE_STUDENTS);
+            lastBytes = live.back()->getEnrollmentBits().bytes();
+            if (t == 0) firstBytes = lastBytes;
+        }
+        bool flat = lastBytes <= firstBytes + firstBytes / 4;
+        cout << LIVE_TERMS << " live terms x " << LIVE_STUDENTS << " students: bit matrices take "
+            << firstBytes / 1024 << " KB in the first term, " << lastBytes / 1024 << " KB in the last ("
+            << (flat ? "flat" : "GROWING") << ")" << endl;
+        return match && flat;
+    }
+
+    // Generates catalogs of 10^3 students up to `maxStudents` (ten times
+    // larger each step) and times the core kernels on each: publishing a
+    // catalog version, auditing every enrollment against its prerequisites,
+    // and pairwise co-enrollment of the 20 largest courses.
+    void benchmarkGeneratedDatasets(int maxStudents = 100000) {
+        cout << "\n--- Benchmarking Generated Datasets ---" << endl;
+
+        for (int students = 1000; students <= maxStudents; students *= 10) {
+            DataManager scratch;
+            DatasetGenerator::Summary summary = DatasetGenerator(&scratch).generate(DatasetSpec::forStudents(students));
+
+            auto start = high_resolution_clock::now();
+            shared_ptr<const CatalogVersion> version = scratch.publish();
+            double publishMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+
+            const EnrollmentBits& bits = version->bits;
+            start = high_resolution_clock::now();
+            size_t violations = 0;
+            for (const Student& student : scratch.getAllStudents()) {
+                const uint64_t* completed = bits.completedCourses(student.getHandle());
+                for (Handle course : student.getEnrolledHandles()) {
+                    if (!BitOps::isSubset(bits.prerequisitesOf(course), completed, bits.courseWords())) violations++;
+                }
+            }
+            double auditMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+
+            vector<pair<size_t, Handle>> bySize;
+            for (const Course& course : scratch.getAllCourses()) {
+                bySize.push_back(make_pair(scratch.getEnrolledStudents(course.getHandle()).size(), course.getHandle()));
+            }
+            sort(bySize.rbegin(), bySize.rend());
+            bySize.resize(min(bySize.size(), (size_t)20));
+
+            start = high_resolution_clock::now();
+            size_t overlap = 0;
+            for (size_t a = 0; a < bySize.size(); a++) {
+                for (size_t b = a + 1; b < bySize.size(); b++) {
+                    overlap += BitOps::andCount(bits.enrolledStudents(bySize[a].second),
+                        bits.enrolledStudents(bySize[b].second), bits.studentWords());
+                }
+            }
+            double overlapMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+
+            cout << "\n" << summary.students << " students, " << summary.courses << " courses, "
+                << summary.enrollments << " enrollments (generated in " << (long long)(summary.seconds * 1000) << " ms)" << endl;
+            cout << "  Publish catalog version: " << publishMs << " ms" << endl;
+            cout << "  Prerequisite audit:      " << auditMs << " ms (" << violations << " violations)" << endl;
+            cout << "  Top-20 co-enrollment:    " << overlapMs << " ms (" << overlap << " shared seats)" << endl;
+        }
+    }
+
+    // Co-enrollment of every pair of courses in a generated catalog, four
+    // ways: std::set<string> intersections (timed on a sample of pairs and
+    // scaled up), dense bit rows, compressed roaring rosters, and one sparse
+    // E^T x E product. Returns whether all but the sampled totals agree.
+    bool benchmarkOverlapReport(int students = 100000) {
+        cout << "\n--- Benchmarking Course Overlap Report ---" << endl;
+
+        DataManager scratch;
+        DatasetGenerator(&scratch).generate(DatasetSpec::forStudents(students));
+        vector<string> courseIDs;
+        for (const Course& course : scratch.getAllCourses()) courseIDs.push_back(course.getID());
+        size_t pairs = courseIDs.size() * (courseIDs.size() - 1) / 2;
+
+        const size_t SAMPLE = 2000;
+        auto start = high_resolution_clock::now();
+        size_t sampled = 0;
+        for (size_t a = 0; a < courseIDs.size() && sampled < SAMPLE; a++) {
+            set<string> rosterA = toNameSet(scratch.getEnrolledStudents(courseIDs[a]), Symbols::students());
+            for (size_t b = a + 1; b < courseIDs.size() && sampled < SAMPLE; b++, sampled++) {
+                set<string> rosterB = toNameSet(scratch.getEnrolledStudents(courseIDs[b]), Symbols::students());
+                set<string> both;
+                set_intersection(rosterA.begin(), rosterA.end(), rosterB.begin(), rosterB.end(), inserter(both, both.begin()));
+            }
+        }
+        double setSeconds = duration_cast<duration<double>>(high_resolution_clock::now() - start).count() * pairs / sampled;
+
+        const EnrollmentBits& bits = scratch.getEnrollmentBits();
+        vector<Handle> handles;
+        for (const string& id : courseIDs) handles.push_back(Symbols::courses().find(id));
+        start = high_resolution_clock::now();
+        size_t denseTotal = 0;
+        for (size_t a = 0; a < handles.size(); a++) {
+            for (size_t b = a + 1; b < handles.size(); b++) {
+                denseTotal += BitOps::andCount(bits.enrolledStudents(handles[a]), bits.enrolledStudents(handles[b]), bits.studentWords());
+            }
+        }
+        double denseSeconds = duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+
+        SetOperationsModule sets(&scratch);
+        start = high_resolution_clock::now();
+        vector<SetOperationsModule::CourseOverlap> report = sets.overlapReport(courseIDs);
+        double roaringSeconds = duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+        size_t roaringTotal = 0;
+        for (const SetOperationsModule::CourseOverlap& pair : report) roaringTotal += pair.shared;
+
+        size_t roaringBytes = 0;
+        for (const string& id : courseIDs) roaringBytes += sets.studentsOf(id).bytes();
+
+        CoEnrollmentMatrix matrix(&scratch);
+        scratch.snapshot();
+        start = high_resolution_clock::now();
+        matrix.build(1);
+        double sparseSeconds = duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+        start = high_resolution_clock::now();
+        matrix.build();
+        double parallelSeconds = duration_cast<duration<double>>(high_resolution_clock::now() - start).count();
+        size_t sparseTotal = 0;
+        for (const CoursePair& pair : matrix.pairsAtLeast(1)) sparseTotal += pair.shared;
+
+        cout << courseIDs.size() << " courses, " << pairs << " pairs, " << students << " students" << endl;
+        cout << "std::set<string> (estimated): " << setSeconds << " s" << endl;
+        cout << "Dense bit rows:               " << denseSeconds << " s ("
+            << handles.size() * bits.studentWords() * 8 / 1024 << " KB of rosters)" << endl;
+        cout << "Roaring bitmaps:              " << roaringSeconds << " s ("
+            << roaringBytes / 1024 << " KB of rosters)" << endl;
+        cout << "Sparse E^T x E, 1 thread:     " << sparseSeconds << " s" << endl;
+        cout << "Sparse E^T x E, " << max(1u, thread::hardware_concurrency()) << " threads:    " << parallelSeconds << " s ("
+            << matrix.pairCount() << " non-zero pairs)" << endl;
+        cout << report.size() << " pairs share students, " << roaringTotal << " shared seats in total" << endl;
+
+        bool agree = denseTotal == roaringTotal && roaringTotal == sparseTotal && report.size() == matrix.pairCount();
+        cout << "Bit-row, roaring and sparse totals " << (agree ? "agree" : "DIFFER") << endl;
+        return agree;
+    }
+
+    // "Students taking all of these courses" on a generated catalog: a
+    // mid-sized course, listed last, and the courses sharing the most students
+    // with it. Pairwise intersection in input order over compressed rosters
+    // versus galloping k-way intersection over the sorted rosters.
+    void benchmarkMultiWayIntersection(int students = 100000, int ways = 4) {
+        cout << "\n--- Benchmarking Multi-Way Intersection ---" << endl;
+
+        DataManager scratch;
+        DatasetGenerator(&scratch).generate(DatasetSpec::forStudents(students));
+        vector<pair<size_t, string>> bySize;
+        for (const Course& course : scratch.getAllCourses()) {
+            bySize.push_back(make_pair(scratch.getEnrolledStudents(course.getHandle()).size(), course.getID()));
+        }
+        sort(bySize.rbegin(), bySize.rend());
+
+        SetOperationsModule sets(&scratch);
+        string anchor = bySize[bySize.size() / 2].second;
+        vector<pair<size_t, string>> byOverlap;
+        for (const pair<size_t, string>& course : bySize) {
+            if (course.second != anchor) byOverlap.push_back(make_pair(sets.overlapCount(anchor, course.second), course.second));
+        }
+        sort(byOverlap.rbegin(), byOverlap.rend());
+
+        vector<string> courseIDs;
+        for (int i = 0; i < ways - 1 && i < (int)byOverlap.size(); i++) courseIDs.push_back(byOverlap[i].second);
+        courseIDs.push_back(anchor);
+        size_t smallest = bySize[0].first, largest = 0;
+        for (const string& id : courseIDs) {
+            smallest = min(smallest, scratch.getEnrolledStudents(id).size());
+            largest = max(largest, scratch.getEnrolledStudents(id).size());
+        }
+
+        const int ROUNDS = 200;
+        auto start = high_resolution_clock::now();
+        size_t pairwise = 0;
+        for (int r = 0; r < ROUNDS; r++) {
+            RoaringBitmap result = sets.studentsOf(courseIDs[0]);
+            for (size_t i = 1; i < courseIDs.size(); i++) result = result & sets.studentsOf(courseIDs[i]);
+            pairwise = result.size();
+        }
+        double pairwiseUs = duration_cast<duration<double, micro>>(high_resolution_clock::now() - start).count() / ROUNDS;
+
+        start = high_resolution_clock::now();
+        size_t galloping = 0;
+        for (int r = 0; r < ROUNDS; r++) galloping = sets.intersectionCount(courseIDs);
+        double gallopingUs = duration_cast<duration<double, micro>>(high_resolution_clock::now() - start).count() / ROUNDS;
+
+        cout << courseIDs.size() << " courses, rosters from " << smallest << " to " << largest << " students" << endl;
+        cout << "Pairwise, input order:       " << pairwiseUs << " us per query" << endl;
+        cout << "Galloping, smallest first:   " << gallopingUs << " us per query" << endl;
+        cout << galloping << " students in all " << courseIDs.size() << " courses ("
+            << (pairwise == galloping ? "results agree" : "results DIFFER") << ")" << endl;
+    }
+
+    // Evaluates ((A | B) & C) \ D \ E, with A and B the largest rosters and D
+    // and E the most-completed courses, once by building every intermediate
+    // bitmap and once as a planned, fused SetQuery.
+    void benchmarkSetExpression(int students = 100000) {
+        cout << "\n--- Benchmarking Set Expression Evaluation ---" << endl;
+
+        DataManager scratch;
+        DatasetGenerator(&scratch).generate(DatasetSpec::forStudents(students));
+        vector<pair<size_t, string>> byEnrolled, byCompleted;
+        for (const Course& course : scratch.getAllCourses()) {
+            byEnrolled.push_back(make_pair(scratch.getEnrolledStudents(course.getHandle()).size(), course.getID()));
+            byCompleted.push_back(make_pair(scratch.getCompletedStudents(course.getHandle()).size(), course.getID()));
+        }
+        sort(byEnrolled.rbegin(), byEnrolled.rend());
+        sort(byCompleted.rbegin(), byCompleted.rend());
+
+        string a = byEnrolled[0].second, b = byEnrolled[1].second, c = byEnrolled[byEnrolled.size() / 4].second;
+        string d = byCompleted[0].second, e = byCompleted[1].second;
+        string expression = "((enrolled(" + a + ") | enrolled(" + b + ")) & enrolled(" + c + ")) \\ completed(" + d + ") \\ completed(" + e + ")";
+
+        auto bitmapOf = [&](const HandleSet& roster) { return RoaringBitmap::fromSorted(roster.begin(), roster.end()); };
+
+        const int ROUNDS = 200;
+        auto start = high_resolution_clock::now();
+        size_t materialized = 0;
+        for (int r = 0; r < ROUNDS; r++) {
+            RoaringBitmap either = bitmapOf(scratch.getEnrolledStudents(a)) | bitmapOf(scratch.getEnrolledStudents(b));
+            RoaringBitmap both = either & bitmapOf(scratch.getEnrolledStudents(c));
+            RoaringBitmap result = both - bitmapOf(scratch.getCompletedStudents(d)) - bitmapOf(scratch.getCompletedStudents(e));
+            materialized = result.size();
+        }
+        double materializedUs = duration_cast<duration<double, micro>>(high_resolution_clock::now() - start).count() / ROUNDS;
+
+        SetQuery query(&scratch);
+        query.compile(expression);
+        start = high_resolution_clock::now();
+        size_t fused = 0;
+        for (int r = 0; r < ROUNDS; r++) fused = query.count();
+        double fusedUs = duration_cast<duration<double, micro>>(high_resolution_clock::now() - start).count() / ROUNDS;
+
+        cout << "Expression: " << expression << endl;
+        cout << "Plan:       " << query.plan() << endl;
+        cout << "Materialized intermediates: " << materializedUs << " us per query" << endl;
+        cout << "Fused, planned:             " << fusedUs << " us per query" << endl;
+        cout << fused << " matching students (" << (materialized == fused ? "results agree" : "results DIFFER") << ")" << endl;
+    }
+
+    // Jaccard similarity of every pair among the 40 largest courses and
+    // distinct students over groups of 20 of them, exactly from the rosters
+    // and approximately from the per-course sketches, with the worst errors.
+    void benchmarkSketches(int students = 100000) {
+        cout << "\n--- Benchmarking Approximate Overlap (Sketches) ---" << endl;
+
+        DataManager scratch;
+        DatasetGenerator(&scratch).generate(DatasetSpec::forStudents(students));
+        vector<pair<size_t, string>> bySize;
+        for (const Course& course : scratch.getAllCourses()) {
+            bySize.push_back(make_pair(scratch.getEnrolledStudents(course.getHandle()).size(), course.getID()));
+        }
+        sort(bySize.rbegin(), bySize.rend());
+        vector<string> courseIDs;
+        for (size_t i = 0; i < bySize.size() && i < 40; i++) courseIDs.push_back(bySize[i].second);
+
+        SetOperationsModule sets(&scratch);
+        auto start = high_resolution_clock::now();
+        sets.approximateDistinctStudents(courseIDs);
+        double buildMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+
+        vector<double> exactJaccard, approximateJaccard;
+        start = high_resolution_clock::now();
+        for (size_t a = 0; a < courseIDs.size(); a++) {
+            for (size_t b = a + 1; b < courseIDs.size(); b++) {
+                size_t either = sets.unionCount({ courseIDs[a], courseIDs[b] });
+                exactJaccard.push_back(either ? (double)sets.overlapCount(courseIDs[a], courseIDs[b]) / either : 0.0);
+            }
+        }
+        double exactPairUs = duration_cast<duration<double, micro>>(high_resolution_clock::now() - start).count() / exactJaccard.size();
+
+        start = high_resolution_clock::now();
+        for (size_t a = 0; a < courseIDs.size(); a++) {
+            for (size_t b = a + 1; b < courseIDs.size(); b++) {
+                approximateJaccard.push_back(sets.approximateJaccard(courseIDs[a], courseIDs[b]));
+            }
+        }
+        double sketchPairUs = duration_cast<duration<double, micro>>(high_resolution_clock::now() - start).count() / approximateJaccard.size();
+
+        double worstJaccard = 0;
+        for (size_t i = 0; i < exactJaccard.size(); i++) worstJaccard = max(worstJaccard, fabs(exactJaccard[i] - approximateJaccard[i]));
+
+        const int GROUPS = 20;
+        vector<vector<string>> groups(GROUPS);
+        mt19937 rng(7);
+        for (vector<string>& group : groups) {
+            for (int i = 0; i < 20; i++) group.push_back(courseIDs[rng() % courseIDs.size()]);
+        }
+
+        vector<size_t> exactDistinct;
+        start = high_resolution_clock::now();
+        for (const vector<string>& group : groups) exactDistinct.push_back(sets.unionCount(group));
+        double exactUnionUs = duration_cast<duration<double, micro>>(high_resolution_clock::now() - start).count() / GROUPS;
+
+        vector<double> approximateDistinct;
+        start = high_resolution_clock::now();
+        for (const vector<string>& group : groups) approximateDistinct.push_back(sets.approximateDistinctStudents(group));
+        double sketchUnionUs = duration_cast<duration<double, micro>>(high_resolution_clock::now() - start).count() / GROUPS;
+
+        double worstDistinct = 0;
+        for (int i = 0; i < GROUPS; i++) {
+            worstDistinct = max(worstDistinct, fabs(approximateDistinct[i] - exactDistinct[i]) / max((size_t)1, exactDistinct[i]));
+        }
+
+        cout << courseIDs.size() << " courses, " << exactJaccard.size() << " pairs, " << students << " students" << endl;
+        cout << "Sketch build (first query):   " << buildMs << " ms" << endl;
+        cout << "Jaccard, exact:               " << exactPairUs << " us per pair" << endl;
+        cout << "Jaccard, MinHash:             " << sketchPairUs << " us per pair (worst error " << worstJaccard << ")" << endl;
+        cout << "Distinct over 20, exact:      " << exactUnionUs << " us per query" << endl;
+        cout << "Distinct over 20, HLL:        " << sketchUnionUs << " us per query (worst error "
+            << worstDistinct * 100 << "%)" << endl;
+    }
+
+    // Transitive closure of the prerequisite relation of a `courses`-course
+    // catalog: semi-naive over (course, prerequisite) name pairs, as the
+    // relations module used to, then EnrollmentBits::closePrerequisites() on
+    // one and on all hardware threads, then the DataManager's incremental
+    // upkeep of the closure as single prerequisites are added and removed.
+    void benchmarkPrerequisiteClosure(int courses = 3000) {
+        cout << "\n--- Benchmarking Prerequisite Closure ---" << endl;
+
+        DatasetSpec spec;
+        spec.departments = 20;
+        spec.coursesPerDepartment = max(1, courses / spec.departments);
+        spec.levels = 8;
+        spec.students = 1000;
+        DataManager scratch;
+        DatasetGenerator(&scratch).generate(spec);
+        shared_ptr<const CatalogVersion> version = scratch.snapshot();
+        const CatalogColumns& columns = version->columns;
+
+        typedef pair<string, string> NamePair;
+        auto start = high_resolution_clock::now();
+        set<NamePair> edges, closure;
+        for (size_t row = 0; row < columns.courseCount(); row++) {
+            for (Handle prereq : columns.prerequisites(row)) edges.insert(NamePair(columns.courseID(row), Symbols::courses().name(prereq)));
+        }
+        vector<NamePair> frontier(edges.begin(), edges.end()), next;
+        closure.insert(edges.begin(), edges.end());
+        while (!frontier.empty()) {
+            next.clear();
+            for (const NamePair& p : frontier) {
+                for (auto it = edges.lower_bound(NamePair(p.second, string())); it != edges.end() && it->first == p.second; ++it) {
+                    if (closure.insert(NamePair(p.first, it->second)).second) next.push_back(NamePair(p.first, it->second));
+                }
+            }
+            frontier.swap(next);
+        }
+        double pairsMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+
+        EnrollmentBits bits;
+        for (size_t row = 0; row < columns.courseCount(); row++) {
+            HandleSet prereqs;
+            for (Handle prereq : columns.prerequisites(row)) prereqs.appendSorted(prereq);
+            bits.setPrerequisites(columns.courseHandle(row), prereqs, false);
+        }
+        start = high_resolution_clock::now();
+        bits.closePrerequisites(1);
+        double serialMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+        start = high_resolution_clock::now();
+        bits.closePrerequisites();
+        double parallelMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+
+        size_t bitPairs = 0;
+        for (size_t row = 0; row < columns.courseCount(); row++) {
+            bitPairs += BitOps::count(bits.allPrerequisitesOf(columns.courseHandle(row)), bits.courseWords());
+        }
+
+        cout << columns.courseCount() << " courses, " << edges.size() << " prerequisite edges, "
+            << closure.size() << " pairs in the closure" << endl;
+        cout << "Semi-naive over name pairs:  " << pairsMs << " ms" << endl;
+        cout << "Bit rows, 1 thread:          " << serialMs << " ms (ancestors and descendants)" << endl;
+        cout << "Bit rows, " << max(1u, thread::hardware_concurrency()) << " threads:         " << parallelMs << " ms" << endl;
+        cout << "Closures " << (bitPairs == closure.size() ? "agree" : "DIFFER") << endl;
+
+        // Random edits, each undone straight away; cycle-closing ones are rejected.
+        mt19937 rng(17);
+        size_t edits = 0, rejected = 0;
+        scratch.holdPublishing(); // time the closure upkeep alone
+        start = high_resolution_clock::now();
+        for (int i = 0; i < 200; i++) {
+            Course* course = scratch.getCourse(columns.courseHandle(rng() % columns.courseCount()));
+            const string& prereq = columns.courseID(rng() % columns.courseCount());
+            if (course->requiresCourse(prereq)) continue;
+            if (!course->addPrerequisite(prereq)) {
+                rejected++;
+                continue;
+            }
+            course->removePrerequisite(prereq);
+            edits += 2;
+        }
+        double editUs = duration_cast<duration<double, micro>>(high_resolution_clock::now() - start).count();
+        scratch.releasePublishing();
+
+        const EnrollmentBits& live = scratch.getEnrollmentBits();
+        size_t livePairs = 0;
+        for (size_t row = 0; row < columns.courseCount(); row++) {
+            livePairs += BitOps::count(live.allPrerequisitesOf(columns.courseHandle(row)), live.courseWords());
+        }
+        cout << "Incremental upkeep:          " << (edits ? editUs / edits : 0.0) << " us per edit over " << edits
+            << " edits (" << rejected << " cycle-closing edits rejected)" << endl;
+        cout << "Maintained closure " << (livePairs == closure.size() ? "agrees" : "DIFFERS") << " after the edits" << endl;
+    }
+
+    // Student -> course -> faculty on a generated catalog of `students`
+    // students: an index join over name pairs, composeRelations (names mapped
+    // to IDs, then the sparse product), and the sparse product alone on one
+    // and on all hardware threads.
+    void benchmarkRelationComposition(int students = 40000) {
+        cout << "\n--- Benchmarking Relation Composition ---" << endl;
+
+        DataManager scratch;
+        DatasetGenerator(&scratch).generate(DatasetSpec::forStudents(students));
+        shared_ptr<const CatalogVersion> version = scratch.snapshot();
+        const CatalogColumns& columns = version->columns;
+
+        typedef pair<string, string> NamePair;
+        set<NamePair> studentCourse, courseFaculty;
+        for (size_t row = 0; row < columns.studentCount(); row++) {
+            for (Handle course : columns.enrolled(row)) studentCourse.insert(NamePair(columns.studentID(row), Symbols::courses().name(course)));
+        }
+        for (size_t row = 0; row < columns.facultyCount(); row++) {
+            for (Handle course : columns.assigned(row)) courseFaculty.insert(NamePair(Symbols::courses().name(course), columns.facultyID(row)));
+        }
+
+        auto start = high_resolution_clock::now();
+        set<NamePair> joined;
+        for (const NamePair& p : studentCourse) {
+            for (auto it = courseFaculty.lower_bound(NamePair(p.second, string())); it != courseFaculty.end() && it->first == p.second; ++it) {
+                joined.insert(NamePair(p.first, it->second));
+            }
+        }
+        double pairsMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+
+        RelationsModule relations(&scratch);
+        start = high_resolution_clock::now();
+        set<NamePair> composed = relations.composeRelations(studentCourse, courseFaculty);
+        double namedMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+
+        start = high_resolution_clock::now();
+        SparseRelation enrolled = RelationsModule::studentCourseMatrix(columns);
+        SparseRelation taughtBy = RelationsModule::facultyCourseMatrix(columns).transpose();
+        double buildMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+        start = high_resolution_clock::now();
+        SparseRelation serial = enrolled.compose(taughtBy, 1);
+        double serialMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+        start = high_resolution_clock::now();
+        SparseRelation parallel = enrolled.compose(taughtBy);
+        double parallelMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+
+        bool agree = composed == joined && serial.pairCount() == joined.size() && parallel.pairCount() == joined.size();
+        for (size_t row = 0; agree && row < serial.rows(); row++) {
+            agree = equal(serial.rowBegin(row), serial.rowEnd(row), parallel.rowBegin(row));
+        }
+
+        cout << columns.studentCount() << " students, " << studentCourse.size() << " enrollments, "
+            << courseFaculty.size() << " assignments, " << joined.size() << " student-faculty pairs" << endl;
+        cout << "Index join over name pairs:   " << pairsMs << " ms" << endl;
+        cout << "composeRelations (by name):   " << namedMs << " ms" << endl;
+        cout << "CSR build and transpose:      " << buildMs << " ms" << endl;
+        cout << "CSR product, 1 thread:        " << serialMs << " ms" << endl;
+        cout << "CSR product, " << max(1u, thread::hardware_concurrency()) << " threads:       " << parallelMs << " ms" << endl;
+        cout << "Compositions " << (agree ? "agree" : "DIFFER") << endl;
+    }
+
+    // Property checks on relations of a few hundred thousand pairs: "same
+    // group" over `elements` elements in groups of 50 (an equivalence), and
+    // divisibility on 1..`divisors` (a partial order), with and without one
+    // pair removed. The pair-of-pairs transitivity check the relations module
+    // used to run is timed on a 2000-pair slice only.
+    void benchmarkRelationProperties(int elements = 10000, int divisors = 20000) {
+        cout << "\n--- Benchmarking Relation Property Checks ---" << endl;
+        typedef pair<string, string> NamePair;
+        typedef RelationsModule::Counterexample Counterexample;
+        DataManager scratch;
+        RelationsModule relations(&scratch);
+
+        set<NamePair> sameGroup;
+        for (int a = 0; a < elements; a++) {
+            for (int b = a / 50 * 50; b < min(elements, a / 50 * 50 + 50); b++) sameGroup.insert(NamePair(to_string(a), to_string(b)));
+        }
+
+        auto start = high_resolution_clock::now();
+        bool treeSymmetric = true;
+        for (const NamePair& p : sameGroup) {
+            if (sameGroup.find(NamePair(p.second, p.first)) == sameGroup.end()) treeSymmetric = false;
+        }
+        double treeMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+
+        set<NamePair> slice;
+        for (auto it = sameGroup.begin(); it != sameGroup.end() && slice.size() < 2000; ++it) slice.insert(*it);
+        start = high_resolution_clock::now();
+        bool sliceTransitive = true;
+        for (const NamePair& p1 : slice) {
+            for (const NamePair& p2 : slice) {
+                if (p1.second == p2.first && slice.find(NamePair(p1.first, p2.second)) == slice.end()) sliceTransitive = false;
+            }
+        }
+        double sliceMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+        double scale = (double)sameGroup.size() / slice.size();
+
+        start = high_resolution_clock::now();
+        Counterexample symmetric = relations.findNonSymmetric(sameGroup);
+        double symmetricMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+        start = high_resolution_clock::now();
+        Counterexample transitive = relations.findNonTransitive(sameGroup, 1);
+        double serialMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+        start = high_resolution_clock::now();
+        relations.findNonTransitive(sameGroup);
+        double parallelMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+
+        cout << "Same group: " << elements << " elements, " << sameGroup.size() << " pairs" << endl;
+        cout << "  Tree lookup per pair, symmetry:      " << treeMs << " ms" << endl;
+        cout << "  Pair of pairs, transitivity:         " << sliceMs << " ms on " << slice.size()
+            << " pairs, about " << sliceMs * scale * scale / 1000 << " s for all" << endl;
+        cout << "  Sorted transpose, symmetry:          " << symmetricMs << " ms" << endl;
+        cout << "  Successor bitsets, transitivity:     " << serialMs << " ms on 1 thread, "
+            << parallelMs << " ms on " << max(1u, thread::hardware_concurrency()) << endl;
+        cout << "  Symmetric: " << (symmetric.found() || !treeSymmetric ? "No" : "Yes")
+            << ", transitive: " << (transitive.found() || !sliceTransitive ? "No" : "Yes") << endl;
+
+        set<NamePair> divides;
+        set<string> numbers;
+        for (int a = 1; a <= divisors; a++) {
+            numbers.insert(to_string(a));
+            for (int b = a; b <= divisors; b += a) divides.insert(NamePair(to_string(a), to_string(b)));
+        }
+        start = high_resolution_clock::now();
+        Counterexample order = relations.findNonPartialOrder(divides, numbers);
+        double orderMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+        divides.erase(NamePair("3", "12"));
+        Counterexample broken = relations.findNonPartialOrder(divides, numbers);
+
+        cout << "Divisibility on 1.." << divisors << ": " << divides.size() + 1 << " pairs" << endl;
+        cout << "  Partial order check:                 " << orderMs << " ms, "
+            << (order.found() ? "No: " + order.describe() : string("holds")) << endl;
+        cout << "  Without (3, 12):                     " << (broken.found() ? broken.describe() : string("holds")) << endl;
+    }
+
+    // Sums the weights of every subset of `elements` items: rebuilding each
+    // subset from its bit pattern, then walking them in Gray-code order with
+    // one add or subtract per subset, then splitting that walk across threads.
+    void benchmarkSubsetWalk(int elements = 24) {
+        cout << "\n--- Benchmarking Subset Enumeration ---" << endl;
+
+        vector<long long> weight(elements);
+        for (int i = 0; i < elements; i++) weight[i] = i * 7 + 3;
+        uint64_t subsets = (uint64_t)1 << elements;
+
+        auto start = high_resolution_clock::now();
+        long long rebuilt = 0;
+        for (uint64_t k = 0; k < subsets; k++) {
+            long long sum = 0;
+            for (int i = 0; i < elements; i++) {
+                if ((k >> i) & 1) sum += weight[i];
+            }
+            rebuilt += sum;
+        }
+        double rebuildMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+
+        GraySubsets walker(elements);
+        start = high_resolution_clock::now();
+        long long running = 0, streamed = 0;
+        walker.walk([&](const SubsetStep& step) {
+            if (step.changed != SubsetStep::NONE) running += step.added ? weight[step.changed] : -weight[step.changed];
+            streamed += running;
+            return true;
+        });
+        double grayMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+
+        unsigned threads = max(1u, thread::hardware_concurrency());
+        vector<long long> runningBy(threads, 0), totalBy(threads, 0);
+        start = high_resolution_clock::now();
+        walker.walkParallel(threads, [&](const SubsetStep& step, unsigned w) {
+            if (step.changed == SubsetStep::NONE) {
+                runningBy[w] = 0;
+                for (int i = 0; i < elements; i++) {
+                    if (step.contains(i)) runningBy[w] += weight[i];
+                }
+            }
+            else {
+                runningBy[w] += step.added ? weight[step.changed] : -weight[step.changed];
+            }
+            totalBy[w] += runningBy[w];
+            return true;
+        });
+        double parallelMs = duration_cast<duration<double, milli>>(high_resolution_clock::now() - start).count();
+        long long parallel = 0;
+        for (long long t : totalBy) parallel += t;
+
+        cout << subsets << " subsets of " << elements << " elements" << endl;
+        cout << "Rebuilding each subset:    " << rebuildMs << " ms" << endl;
+        cout << "Gray-code walk:            " << grayMs << " ms" << endl;
+        cout << "Gray-code walk (" << threads << " thread(s)): " << parallelMs << " ms" << endl;
+        cout << "Weight totals " << (rebuilt == streamed && streamed == parallel ? "agree" : "DIFFER") << endl;
+    }
+
     void demonstrate() {
         cout << "\n========================================" << endl;
         cout << "MODULE 10: ALGORITHMIC EFFICIENCY & BENCHMARKING DEMONSTRATION" << endl;
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+#include <set>
+#include <map>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+using namespace std;
+
+// Bump allocator for short-lived query temporaries. Memory comes from a chain
+// of growing blocks and is only given back all at once, by release() or when
+// the arena goes out of scope, so per-node container frees cost nothing.
+class MonotonicArena {
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+    };
+
+    Block* head;
+    char* cursor;
+    char* limit;
+    size_t nextSize;
+    size_t used;
+
+    MonotonicArena(const MonotonicArena&);
+    MonotonicArena& operator=(const MonotonicArena&);
+
+    void grow(size_t minimum) {
+        size_t size = nextSize;
+        while (size < minimum + sizeof(Block)) size *= 2;
+        nextSize = size * 2;
+
+        Block* block = (Block*)::operator new(size);
+        block->next = head;
+        block->size = size;
+        head = block;
+        cursor = (char*)block + sizeof(Block);
+        limit = (char*)block + size;
+    }
+
+public:
+    explicit MonotonicArena(size_t initialBlock = 4096)
+        : head(nullptr), cursor(nullptr), limit(nullptr), nextSize(initialBlock), used(0) {}
+
+    ~MonotonicArena() { release(); }
+
+    void* allocate(size_t bytes, size_t alignment) {
+        uintptr_t p = ((uintptr_t)cursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        if (!cursor || p + bytes > (uintptr_t)limit) {
+            grow(bytes + alignment);
+            p = ((uintptr_t)cursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        }
+        cursor = (char*)(p + bytes);
+        used += bytes;
+        return (void*)p;
+    }
+
+    template<typename T>
+    T* allocateArray(size_t count) { return (T*)allocate(count * sizeof(T), alignof(T)); }
+
+    void release() {
+        while (head) {
+            Block* next = head->next;
+            ::operator delete(head);
+            head = next;
+        }
+        cursor = nullptr;
+        limit = nullptr;
+        used = 0;
+    }
+
+    size_t bytesAllocated() const { return used; }
+};
+
+// Standard allocator adaptor over a MonotonicArena; deallocate is a no-op.
+template<typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    MonotonicArena* arena;
+
+    explicit ArenaAllocator(MonotonicArena& a) : arena(&a) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t n) { return arena->allocateArray<T>(n); }
+    void deallocate(T*, size_t) {}
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+template<typename T>
+using ArenaVector = vector<T, ArenaAllocator<T>>;
+
+template<typename T, typename Less = less<T>>
+using ArenaSet = set<T, Less, ArenaAllocator<T>>;
+
+template<typename K, typename V, typename Less = less<K>>
+using ArenaMap = map<K, V, Less, ArenaAllocator<pair<const K, V>>>;
@@ -13,15 +13,15 @@ using namespace std::chrono;
 
 class ProofModule {
 private:
-    DataManager* dm;
+    const DataManager* dm;
 
     void printProofStep(int step, const string& statement) {
         cout << "  Step " << step << ": " << statement << endl;
     }
 
 public:
-    ProofModule() {
-        dm = DataManager::getInstance();
+    explicit ProofModule(DataManager* manager) {
+        dm = manager;
     }
 
     // Generate step-by-step proof for prerequisite satisfaction
@@ -30,10 +30,13 @@ public:
         cout << "Theorem: Student " << studentID << " can enroll in " << courseID << endl;
         cout << "\nProof:" << endl;
 
-        Student* student = dm->getStudent(studentID);
-        Course* course = dm->getCourse(courseID);
+        // The whole proof is checked against one pinned catalog version.
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
+        const CatalogColumns& columns = version->columns;
+        size_t student = columns.studentRow(Symbols::students().find(studentID));
+        size_t course = columns.courseRow(Symbols::courses().find(courseID));
 
-        if (!student || !course) {
+        if (student == CatalogColumns::NO_ROW || course == CatalogColumns::NO_ROW) {
             printProofStep(1, "Invalid student or course - Proof fails ✗");
             return false;
         }
@@ -42,7 +45,7 @@ public:
         printProofStep(step++, "Let S = " + studentID + " (student)");
         printProofStep(step++, "Let C = " + courseID + " (target course)");
 
-        set<string> prerequisites = course->getPrerequisites();
+        HandleRange prerequisites = columns.prerequisites(course);
 
         if (prerequisites.empty()) {
             printProofStep(step++, "Prerequisites(C) = {}(empty set)");
@@ -55,9 +58,9 @@ public:
             [&]() {
                 string result;
                 bool first = true;
-                for (const string& p : prerequisites) {
+                for (Handle p : prerequisites) {
                     if (!first) result += ", ";
-                    result += p;
+                    result += Symbols::courses().name(p);
                     first = false;
                 }
                 return result;
@@ -65,13 +68,13 @@ public:
 
         printProofStep(step++, "Must verify: ∀p in Prerequisites(C), p in Completed(S)");
 
-        set<string> completed = student->getCompletedCourses();
+        HandleRange completed = columns.completed(student);
 
         bool allSatisfied = true;
-        for (const string& prereq : prerequisites) {
-            bool hasCompleted = completed.find(prereq) != completed.end();
+        for (Handle prereq : prerequisites) {
+            bool hasCompleted = completed.contains(prereq);
 
-            printProofStep(step++, prereq + (hasCompleted ? " in Completed(S)" : " not in Completed(S)"));
+            printProofStep(step++, Symbols::courses().name(prereq) + (hasCompleted ? " in Completed(S)" : " not in Completed(S)"));
 
             if (!hasCompleted) allSatisfied = false;
         }
@@ -97,20 +100,22 @@ public:
         }
         cout << "\n" << endl;
 
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
         set<string> completed;
 
         for (size_t i = 0; i < courseSequence.size(); i++) {
             const string& courseID = courseSequence[i];
-            Course* course = dm->getCourse(courseID);
+            size_t course = version->columns.courseRow(Symbols::courses().find(courseID));
 
-            if (!course) {
+            if (course == CatalogColumns::NO_ROW) {
                 cout << "Position " << (i + 1) << ": Course " << courseID << " not found" << endl;
                 return false;
             }
 
             cout << "Position " << (i + 1) << ": " << courseID << endl;
 
-            for (const string& prereq : course->getPrerequisites()) {
+            for (Handle prereqHandle : version->columns.prerequisites(course)) {
+                const string& prereq = Symbols::courses().name(prereqHandle);
                 if (completed.find(prereq) == completed.end()) {
                     cout << "  ERROR: Prerequisite " << prereq << " not completed" << endl;
                     return false;
@@ -128,21 +133,22 @@ public:
     bool validateLogicRules() {
         cout << "\n=== LOGIC RULES VALIDATION ===" << endl;
 
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
+        const CatalogColumns& columns = version->columns;
         bool valid = true;
         int ruleCount = 0;
 
-        for (auto& pair : dm->getAllCourses()) {
-            Course& course = pair.second;
-            set<string> visited;
+        for (size_t row = 0; row < columns.courseCount(); row++) {
+            set<Handle> visited;
 
-            function<bool(const string&)> hasCycle = [&](const string& cid) -> bool {
+            function<bool(Handle)> hasCycle = [&](Handle cid) -> bool {
                 if (visited.find(cid) != visited.end()) return true;
                 visited.insert(cid);
 
-                Course* c = dm->getCourse(cid);
-                if (!c) return false;
+                size_t c = columns.courseRow(cid);
+                if (c == CatalogColumns::NO_ROW) return false;
 
-                for (const string& prereq : c->getPrerequisites()) {
+                for (Handle prereq : columns.prerequisites(c)) {
                     if (hasCycle(prereq)) return true;
                 }
 
@@ -150,8 +156,8 @@ public:
                 return false;
                 };
 
-            if (hasCycle(course.getID())) {
-                cout << "CYCLE DETECTED in prerequisites for " << course.getID()  << endl;
+            if (hasCycle(columns.courseHandle(row))) {
+                cout << "CYCLE DETECTED in prerequisites for " << columns.courseID(row)  << endl;
                 valid = false;
             }
             else {
@@ -171,8 +177,8 @@ public:
         cout << "========================================\n" << endl;
 
         if (!dm->getAllStudents().empty() && !dm->getAllCourses().empty()) {
-            string studentID = dm->getAllStudents().begin()->first;
-            string courseID = dm->getAllCourses().begin()->first;
+            string studentID = dm->getAllStudents().begin()->getID();
+            string courseID = dm->getAllCourses().begin()->getID();
 
             generatePrerequisiteProof(studentID, courseID);
         }
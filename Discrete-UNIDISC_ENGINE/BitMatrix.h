@@ -0,0 +1,813 @@
+#pragma once
+
+#include "SymbolTable.h"
+#include "Persistent.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+// Word-parallel kernels over 64-bit bit rows. The AVX2 paths handle four words
+// per instruction; the scalar tails (and non-AVX2 builds) are simple loops the
+// compiler can vectorize on its own.
+struct BitOps {
+    static inline int popcount(uint64_t w) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return (int)__popcnt64(w);
+#elif defined(__GNUC__)
+        return __builtin_popcountll(w);
+#else
+        w = w - ((w >> 1) & 0x5555555555555555ULL);
+        w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+        w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (int)((w * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    static inline int lowestBit(uint64_t w) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, w);
+        return (int)index;
+#elif defined(__GNUC__)
+        return __builtin_ctzll(w);
+#else
+        int index = 0;
+        while (!(w & 1)) { w >>= 1; index++; }
+        return index;
+#endif
+    }
+
+    static size_t wordsFor(size_t bits) { return (bits + 63) / 64; }
+
+    static size_t count(const uint64_t* a, size_t words) {
+        size_t total = 0;
+        for (size_t i = 0; i < words; i++) total += popcount(a[i]);
+        return total;
+    }
+
+    static size_t andCount(const uint64_t* a, const uint64_t* b, size_t words) {
+        size_t total = 0;
+        for (size_t i = 0; i < words; i++) total += popcount(a[i] & b[i]);
+        return total;
+    }
+
+    static size_t orCount(const uint64_t* a, const uint64_t* b, size_t words) {
+        size_t total = 0;
+        for (size_t i = 0; i < words; i++) total += popcount(a[i] | b[i]);
+        return total;
+    }
+
+    static size_t andNotCount(const uint64_t* a, const uint64_t* b, size_t words) {
+        size_t total = 0;
+        for (size_t i = 0; i < words; i++) total += popcount(a[i] & ~b[i]);
+        return total;
+    }
+
+    static void andInto(uint64_t* dst, const uint64_t* src, size_t words) {
+        size_t i = 0;
+#if defined(__AVX2__)
+        for (; i + 4 <= words; i += 4) {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+            __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+            _mm256_storeu_si256((__m256i*)(dst + i), _mm256_and_si256(d, s));
+        }
+#endif
+        for (; i < words; i++) dst[i] &= src[i];
+    }
+
+    static void orInto(uint64_t* dst, const uint64_t* src, size_t words) {
+        size_t i = 0;
+#if defined(__AVX2__)
+        for (; i + 4 <= words; i += 4) {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+            __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+            _mm256_storeu_si256((__m256i*)(dst + i), _mm256_or_si256(d, s));
+        }
+#endif
+        for (; i < words; i++) dst[i] |= src[i];
+    }
+
+    // dst &= ~src
+    static void andNotInto(uint64_t* dst, const uint64_t* src, size_t words) {
+        size_t i = 0;
+#if defined(__AVX2__)
+        for (; i + 4 <= words; i += 4) {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+            __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+            _mm256_storeu_si256((__m256i*)(dst + i), _mm256_andnot_si256(s, d));
+        }
+#endif
+        for (; i < words; i++) dst[i] &= ~src[i];
+    }
+
+    static bool any(const uint64_t* a, size_t words) {
+        for (size_t i = 0; i < words; i++) {
+            if (a[i]) return true;
+        }
+        return false;
+    }
+
+    // a is a subset of b
+    static bool isSubset(const uint64_t* a, const uint64_t* b, size_t words) {
+        for (size_t i = 0; i < words; i++) {
+            if (a[i] & ~b[i]) return false;
+        }
+        return true;
+    }
+
+    // a is a subset of (b | c)
+    static bool isSubsetOfUnion(const uint64_t* a, const uint64_t* b, const uint64_t* c, size_t words) {
+        for (size_t i = 0; i < words; i++) {
+            if (a[i] & ~(b[i] | c[i])) return false;
+        }
+        return true;
+    }
+
+    template<typename Fn>
+    static void forEachSetBit(const uint64_t* a, size_t words, Fn fn) {
+        for (size_t i = 0; i < words; i++) {
+            uint64_t w = a[i];
+            while (w) {
+                fn((Handle)(i * 64 + lowestBit(w)));
+                w &= w - 1;
+            }
+        }
+    }
+};
+
+// Row-major bit matrix stored in copy-on-write blocks of about 4 KB. Copying a
+// matrix shares its blocks; a write copies just the block it lands in if that
+// block is still shared. Rows beyond the current size read as all zeros.
+//
+// Each row also carries a changed flag, set by every write, so freeze() can
+// tell which blocks a published copy still shares with the one before it.
+// A row is only ever written under a lock of its own (its student or course
+// stripe), and so is its flag. The first write after a freeze also lists the
+// row, so freeze() visits only the rows written since rather than every row.
+class BitMatrix {
+private:
+    static const size_t BLOCK_WORDS = 512;
+
+    typedef vector<uint64_t> Block;
+
+    size_t rows;
+    size_t stride;     // words per row
+    size_t blockShift; // log2 of rows per block
+    vector<shared_ptr<Block>> blocks;
+    vector<uint64_t> zeroRow;
+    vector<uint8_t> changed;      // per row, written since the last freeze()
+    vector<uint32_t> changedRows; // the flagged rows, in the first changedCount slots
+    atomic<size_t> changedCount;  // a row is listed at most once, so it fits
+
+    size_t rowsPerBlock() const { return (size_t)1 << blockShift; }
+
+    shared_ptr<Block> newBlock() const { return make_shared<Block>(rowsPerBlock() * stride, 0); }
+
+    void flag(size_t r) {
+        changed[r] = 1;
+        changedRows[changedCount.fetch_add(1, memory_order_relaxed)] = (uint32_t)r;
+    }
+
+    uint64_t* writableRow(size_t r) {
+        if (!changed[r]) flag(r);
+        shared_ptr<Block>& block = blocks[r >> blockShift];
+        if (block.use_count() > 1) block = make_shared<Block>(*block);
+        return &(*block)[(r & (rowsPerBlock() - 1)) * stride];
+    }
+
+public:
+    BitMatrix() : rows(0), stride(0), blockShift(0), changedCount(0) {}
+
+    BitMatrix(const BitMatrix& other)
+        : rows(other.rows), stride(other.stride), blockShift(other.blockShift), blocks(other.blocks),
+        zeroRow(other.zeroRow), changed(other.changed), changedRows(other.changedRows),
+        changedCount(other.changedCount.load()) {}
+
+    BitMatrix& operator=(const BitMatrix& other) {
+        rows = other.rows;
+        stride = other.stride;
+        blockShift = other.blockShift;
+        blocks = other.blocks;
+        zeroRow = other.zeroRow;
+        changed = other.changed;
+        changedRows = other.changedRows;
+        changedCount = other.changedCount.load();
+        return *this;
+    }
+
+    size_t rowCount() const { return rows; }
+    size_t wordsPerRow() const { return stride; }
+
+    // Grows to at least `rowCount` rows and exactly `words` words per row, keeping contents.
+    void reshape(size_t rowCount, size_t words) {
+        if (rowCount < rows) rowCount = rows;
+        if (words != stride) {
+            BitMatrix relaid;
+            relaid.stride = words;
+            while (relaid.blockShift < 16 && (words << (relaid.blockShift + 1)) <= BLOCK_WORDS) relaid.blockShift++;
+            relaid.reshape(rowCount, words);
+            size_t keep = words < stride ? words : stride;
+            for (size_t r = 0; r < rows; r++) {
+                const uint64_t* from = row(r);
+                uint64_t* to = relaid.writableRow(r);
+                for (size_t w = 0; w < keep; w++) to[w] = from[w];
+            }
+            blocks.swap(relaid.blocks);
+            stride = words;
+            blockShift = relaid.blockShift;
+            zeroRow.assign(stride, 0);
+            changed.assign(rowCount, 0);
+            changedRows.assign(rowCount, 0);
+            changedCount = 0;
+            for (size_t r = 0; r < rowCount; r++) flag(r);
+        }
+        else if (stride) {
+            while (blocks.size() << blockShift < rowCount) blocks.push_back(newBlock());
+        }
+        changed.resize(rowCount, 0);
+        changedRows.resize(rowCount, 0);
+        for (size_t r = rows; r < rowCount; r++) {
+            if (!changed[r]) flag(r);
+        }
+        rows = rowCount;
+    }
+
+    void set(size_t r, size_t c) { writableRow(r)[c / 64] |= (1ULL << (c % 64)); }
+    void reset(size_t r, size_t c) { writableRow(r)[c / 64] &= ~(1ULL << (c % 64)); }
+    bool test(size_t r, size_t c) const {
+        return r < rows && c / 64 < stride && (row(r)[c / 64] >> (c % 64)) & 1;
+    }
+
+    const uint64_t* row(size_t r) const {
+        return r < rows && (r >> blockShift) < blocks.size() ? &(*blocks[r >> blockShift])[(r & (rowsPerBlock() - 1)) * stride] : zeroRow.data();
+    }
+    uint64_t* mutableRow(size_t r) { return writableRow(r); }
+
+    void clearRow(size_t r) {
+        if (r >= rows) return;
+        uint64_t* words = writableRow(r);
+        for (size_t w = 0; w < stride; w++) words[w] = 0;
+    }
+
+    // Takes private copies of all shared blocks.
+    void detach() {
+        for (shared_ptr<Block>& block : blocks) {
+            if (block.use_count() > 1) block = make_shared<Block>(*block);
+        }
+    }
+
+    // Read-only copy of the current contents for a published version. Blocks
+    // with no row changed since `previous` (the last copy frozen from this
+    // matrix, or null) are shared with it and the rest are copied, so this
+    // matrix never shares a block with a frozen copy and writers need not
+    // copy on write afterwards. Clears the changed flags.
+    BitMatrix freeze(const BitMatrix* previous) {
+        BitMatrix frozen;
+        frozen.rows = rows;
+        frozen.stride = stride;
+        frozen.blockShift = blockShift;
+        frozen.zeroRow = zeroRow;
+        frozen.blocks.resize(blocks.size());
+
+        bool sameLayout = previous && previous->stride == stride && previous->blockShift == blockShift;
+        vector<uint8_t> dirty(blocks.size(), sameLayout ? 0 : 1);
+        size_t listed = changedCount;
+        for (size_t i = 0; i < listed; i++) {
+            size_t r = changedRows[i];
+            changed[r] = 0;
+            if ((r >> blockShift) < dirty.size()) dirty[r >> blockShift] = 1;
+        }
+        changedCount = 0;
+        for (size_t b = 0; b < blocks.size(); b++) {
+            bool copied = dirty[b] || b >= previous->blocks.size();
+            frozen.blocks[b] = copied ? make_shared<Block>(*blocks[b]) : previous->blocks[b];
+        }
+        return frozen;
+    }
+
+    // Bytes held in blocks, counting shared blocks in full.
+    size_t bytes() const { return blocks.size() * (rowsPerBlock() * stride * sizeof(uint64_t) + sizeof(shared_ptr<Block>)); }
+
+    void clear() {
+        rows = 0;
+        stride = 0;
+        blockShift = 0;
+        blocks.clear();
+        zeroRow.clear();
+        changed.clear();
+        changedRows.clear();
+        changedCount = 0;
+    }
+};
+
+// Reachability over a directed graph of dense node IDs, one bit row per node:
+// reachableFrom(v) holds every node v reaches by one or more edges, and
+// reaching(v) every node that reaches v.
+//
+// build() first collapses strongly connected components (iterative Tarjan),
+// which also emits them sinks first. Each component's row is then the OR of
+// its edges' targets and their rows, filled level by level: a level holds the
+// components whose successors all sit in lower levels, so the components of
+// one level are independent and are split across threads by row block. The
+// reverse rows are a transpose of the forward ones, split across threads by
+// column words. Cost is O(edges x words) with 64 nodes per word operation.
+class TransitiveClosure {
+private:
+    size_t n;
+    size_t words;
+    vector<uint64_t> forward;  // n rows of `words` words
+    vector<uint64_t> backward;
+    vector<uint64_t> zeroRow;
+
+    static void setBit(uint64_t* row, size_t bit) { row[bit >> 6] |= 1ULL << (bit & 63); }
+
+    // Components in the order Tarjan completes them: every edge leaving a
+    // component points to one completed earlier.
+    static size_t components(size_t nodes, const vector<size_t>& offsets, const vector<uint32_t>& targets,
+        vector<uint32_t>& component) {
+        const uint32_t UNSEEN = 0xFFFFFFFFu;
+        vector<uint32_t> index(nodes, UNSEEN), low(nodes, 0);
+        vector<char> onStack(nodes, 0);
+        vector<uint32_t> stack;
+        vector<pair<uint32_t, size_t>> calls; // node, next edge
+        component.assign(nodes, UNSEEN);
+        uint32_t counter = 0, found = 0;
+
+        for (size_t root = 0; root < nodes; root++) {
+            if (index[root] != UNSEEN) continue;
+            calls.push_back(make_pair((uint32_t)root, offsets[root]));
+            index[root] = low[root] = counter++;
+            stack.push_back((uint32_t)root);
+            onStack[root] = 1;
+
+            while (!calls.empty()) {
+                uint32_t v = calls.back().first;
+                size_t& edge = calls.back().second;
+                if (edge < offsets[v + 1]) {
+                    uint32_t w = targets[edge++];
+                    if (index[w] == UNSEEN) {
+                        index[w] = low[w] = counter++;
+                        stack.push_back(w);
+                        onStack[w] = 1;
+                        calls.push_back(make_pair(w, offsets[w]));
+                    }
+                    else if (onStack[w]) low[v] = min(low[v], index[w]);
+                    continue;
+                }
+
+                if (low[v] == index[v]) {
+                    uint32_t w;
+                    do {
+                        w = stack.back();
+                        stack.pop_back();
+                        onStack[w] = 0;
+                        component[w] = found;
+                    } while (w != v);
+                    found++;
+                }
+                calls.pop_back();
+                if (!calls.empty()) {
+                    uint32_t parent = calls.back().first;
+                    low[parent] = min(low[parent], low[v]);
+                }
+            }
+        }
+        return found;
+    }
+
+public:
+    TransitiveClosure() : n(0), words(0) {}
+
+    // Edges of node v are targets[offsets[v] .. offsets[v + 1]); every target
+    // must be below `nodes`. 0 threads means one per hardware thread.
+    void build(size_t nodes, const vector<size_t>& offsets, const vector<uint32_t>& targets, unsigned threads = 0) {
+        n = nodes;
+        words = BitOps::wordsFor(n);
+        forward.assign(n * words, 0);
+        backward.assign(n * words, 0);
+        zeroRow.assign(max(words, (size_t)1), 0);
+        if (n == 0) return;
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+
+        vector<uint32_t> component;
+        size_t count = components(n, offsets, targets, component);
+
+        vector<vector<uint32_t>> members(count);
+        for (size_t v = 0; v < n; v++) members[component[v]].push_back((uint32_t)v);
+
+        // Level of a component: one more than its highest successor.
+        vector<uint32_t> level(count, 0);
+        uint32_t depth = 0;
+        for (size_t c = 0; c < count; c++) {
+            for (uint32_t v : members[c]) {
+                for (size_t e = offsets[v]; e < offsets[v + 1]; e++) {
+                    uint32_t target = component[targets[e]];
+                    if (target != c) level[c] = max(level[c], level[target] + 1);
+                }
+            }
+            depth = max(depth, level[c]);
+        }
+        vector<vector<uint32_t>> byLevel(depth + 1);
+        for (size_t c = 0; c < count; c++) byLevel[level[c]].push_back((uint32_t)c);
+
+        auto fill = [&](const vector<uint32_t>& batch, size_t first, size_t last) {
+            for (size_t i = first; i < last; i++) {
+                const vector<uint32_t>& group = members[batch[i]];
+                uint64_t* row = &forward[group[0] * words];
+                if (group.size() > 1) {
+                    for (uint32_t v : group) setBit(row, v);
+                }
+                for (uint32_t v : group) {
+                    for (size_t e = offsets[v]; e < offsets[v + 1]; e++) {
+                        uint32_t w = targets[e];
+                        setBit(row, w);
+                        if (component[w] != batch[i]) BitOps::orInto(row, &forward[w * words], words);
+                    }
+                }
+                for (size_t m = 1; m < group.size(); m++) copy(row, row + words, &forward[group[m] * words]);
+            }
+        };
+
+        // Small levels are not worth a thread start each.
+        const size_t PARALLEL_MIN = 256;
+        for (const vector<uint32_t>& batch : byLevel) {
+            if (threads == 1 || batch.size() < PARALLEL_MIN) {
+                fill(batch, 0, batch.size());
+                continue;
+            }
+            vector<thread> pool;
+            for (unsigned t = 0; t < threads; t++) {
+                size_t first = batch.size() * t / threads, last = batch.size() * (t + 1) / threads;
+                pool.push_back(thread([&, first, last]() { fill(batch, first, last); }));
+            }
+            for (thread& t : pool) t.join();
+        }
+
+        // Transpose: each thread owns a range of column words, i.e. a block of
+        // backward rows, and scans every forward row's slice of that range.
+        auto transpose = [&](size_t firstWord, size_t lastWord) {
+            for (size_t v = 0; v < n; v++) {
+                const uint64_t* row = &forward[v * words];
+                for (size_t w = firstWord; w < lastWord; w++) {
+                    uint64_t bits = row[w];
+                    while (bits) {
+                        size_t u = w * 64 + BitOps::lowestBit(bits);
+                        setBit(&backward[u * words], v);
+                        bits &= bits - 1;
+                    }
+                }
+            }
+        };
+        unsigned parts = (unsigned)min((size_t)threads, words);
+        if (parts <= 1 || n < PARALLEL_MIN) {
+            transpose(0, words);
+            return;
+        }
+        vector<thread> pool;
+        for (unsigned t = 0; t < parts; t++) {
+            size_t first = words * t / parts, last = words * (t + 1) / parts;
+            pool.push_back(thread([&, first, last]() { transpose(first, last); }));
+        }
+        for (thread& t : pool) t.join();
+    }
+
+    size_t size() const { return n; }
+    size_t wordsPerRow() const { return words; }
+
+    const uint64_t* reachableFrom(size_t v) const { return v < n ? &forward[v * words] : zeroRow.data(); }
+    const uint64_t* reaching(size_t v) const { return v < n ? &backward[v * words] : zeroRow.data(); }
+
+    bool reaches(size_t from, size_t to) const {
+        return from < n && to < n && (forward[from * words + (to >> 6)] >> (to & 63)) & 1;
+    }
+
+    bool onCycle(size_t v) const { return reaches(v, v); }
+};
+
+// Student x course enrollment/completion bits plus the transposed course x student
+// rosters, the course x course prerequisite matrix and its transitive closure in
+// both directions. All matrices that share a dimension share its word width, so
+// rows can be combined directly.
+//
+// Students are indexed by a dense row of their own, assigned in first-seen
+// order, not by handle: handles come from the process-wide table, so indexing
+// by handle would size every DataManager for the students of all the others.
+// Student bit positions in roster rows are these rows; studentAt() maps one
+// back to its handle. Courses are indexed by handle.
+//
+// The closure is maintained on every setPrerequisites() call. Changing a course's
+// prerequisites can only change the ancestor rows of that course and of the
+// courses requiring it, so just those rows are recomputed, prerequisites first,
+// and the descendant rows are patched with the bits that changed. Closing every
+// course at once after a bulk load goes through TransitiveClosure instead.
+class EnrollmentBits {
+private:
+    BitMatrix enrolled;        // student -> courses
+    BitMatrix completed;       // student -> courses
+    BitMatrix roster;          // course -> enrolled students
+    BitMatrix completedRoster; // course -> students who completed it
+    BitMatrix prerequisites;   // course -> prerequisite courses
+    BitMatrix ancestors;       // course -> direct and indirect prerequisites
+    BitMatrix descendants;     // course -> courses requiring it directly or indirectly
+    HandleMap rowOfStudent;             // student handle -> row
+    PersistentVector<Handle> studentOfRow; // row -> student handle
+    size_t studentCapacity;
+    size_t courseCapacity;
+
+    static size_t grow(size_t capacity, size_t needed) {
+        if (capacity == 0) capacity = 64;
+        while (capacity < needed) capacity *= 2;
+        return capacity;
+    }
+
+    // Sizes the matrices for a student row and a course handle; pass
+    // INVALID_HANDLE for either to leave that dimension alone.
+    void ensure(size_t student, Handle course) {
+        if (student != INVALID_HANDLE && student >= studentCapacity) {
+            studentCapacity = grow(studentCapacity, student + 1);
+            roster.reshape(roster.rowCount(), studentWords());
+            completedRoster.reshape(completedRoster.rowCount(), studentWords());
+        }
+        if (course != INVALID_HANDLE && course >= courseCapacity) {
+            courseCapacity = grow(courseCapacity, course + 1);
+            enrolled.reshape(enrolled.rowCount(), courseWords());
+            completed.reshape(completed.rowCount(), courseWords());
+            prerequisites.reshape(prerequisites.rowCount(), courseWords());
+            ancestors.reshape(ancestors.rowCount(), courseWords());
+            descendants.reshape(descendants.rowCount(), courseWords());
+        }
+        if (student != INVALID_HANDLE && student >= enrolled.rowCount()) {
+            enrolled.reshape(student + 1, courseWords());
+            completed.reshape(student + 1, courseWords());
+        }
+        if (course != INVALID_HANDLE && course >= roster.rowCount()) {
+            roster.reshape(course + 1, studentWords());
+            completedRoster.reshape(course + 1, studentWords());
+            prerequisites.reshape(course + 1, courseWords());
+            ancestors.reshape(course + 1, courseWords());
+            descendants.reshape(course + 1, courseWords());
+        }
+    }
+
+    // Recomputes the ancestor rows of `courses`, which must include every
+    // course requiring one of them. Rows outside the list are final, so each
+    // listed row is the OR of its prerequisites and their rows, taken in
+    // topological order within the list (Kahn). Courses on or behind a
+    // prerequisite cycle never become ready and are iterated to a fixpoint.
+    void recomputeClosure(const vector<Handle>& courses) {
+        const uint32_t UNLISTED = 0xFFFFFFFFu;
+        size_t words = courseWords();
+        size_t n = courses.size();
+        vector<uint32_t> position(prerequisites.rowCount(), UNLISTED);
+        for (size_t i = 0; i < n; i++) position[courses[i]] = (uint32_t)i;
+
+        vector<uint32_t> pending(n, 0);
+        vector<vector<uint32_t>> dependents(n);
+        for (size_t i = 0; i < n; i++) {
+            BitOps::forEachSetBit(prerequisites.row(courses[i]), words, [&](Handle p) {
+                if (p < position.size() && position[p] != UNLISTED) {
+                    pending[i]++;
+                    dependents[position[p]].push_back((uint32_t)i);
+                }
+            });
+        }
+
+        vector<uint64_t> fresh(n * words, 0);
+        auto close = [&](size_t i) {
+            uint64_t* row = &fresh[i * words];
+            BitOps::forEachSetBit(prerequisites.row(courses[i]), words, [&](Handle p) {
+                row[p >> 6] |= 1ULL << (p & 63);
+                bool listed = p < position.size() && position[p] != UNLISTED;
+                BitOps::orInto(row, listed ? &fresh[position[p] * words] : ancestors.row(p), words);
+            });
+        };
+
+        vector<uint32_t> ready;
+        for (size_t i = 0; i < n; i++) {
+            if (!pending[i]) ready.push_back((uint32_t)i);
+        }
+        size_t done = 0;
+        while (!ready.empty()) {
+            uint32_t i = ready.back();
+            ready.pop_back();
+            close(i);
+            done++;
+            for (uint32_t d : dependents[i]) {
+                if (--pending[d] == 0) ready.push_back(d);
+            }
+        }
+        if (done < n) {
+            vector<uint64_t> before(words);
+            for (bool changed = true; changed;) {
+                changed = false;
+                for (size_t i = 0; i < n; i++) {
+                    if (!pending[i]) continue;
+                    copy(&fresh[i * words], &fresh[i * words] + words, before.begin());
+                    close(i);
+                    if (!equal(before.begin(), before.end(), &fresh[i * words])) changed = true;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            const uint64_t* now = &fresh[i * words];
+            const uint64_t* was = ancestors.row(courses[i]);
+            for (size_t w = 0; w < words; w++) {
+                for (uint64_t diff = now[w] ^ was[w]; diff; diff &= diff - 1) {
+                    size_t p = w * 64 + BitOps::lowestBit(diff);
+                    if ((now[w] >> (p & 63)) & 1) descendants.set(p, courses[i]);
+                    else descendants.reset(p, courses[i]);
+                }
+            }
+            copy(now, now + words, ancestors.mutableRow(courses[i]));
+        }
+    }
+
+public:
+    EnrollmentBits() : studentCapacity(0), courseCapacity(0) {}
+
+    // Gives a student a row if it has none and sizes the matrices for it.
+    // Writers on several threads may only touch students that already have
+    // rows, so give every student one before they start.
+    size_t addStudent(Handle student) {
+        uint32_t row = rowOfStudent.get(student);
+        if (row == HandleMap::NONE) {
+            row = (uint32_t)studentOfRow.size();
+            rowOfStudent.put(student, row);
+            studentOfRow.push_back(student);
+            ensure(row, INVALID_HANDLE);
+        }
+        return row;
+    }
+
+    // Sizes every matrix for course handles below `courses`, so later updates
+    // for those courses never reallocate.
+    void reserve(size_t courses) {
+        ensure(INVALID_HANDLE, courses ? (Handle)(courses - 1) : INVALID_HANDLE);
+    }
+
+    size_t studentWords() const { return BitOps::wordsFor(studentCapacity); }
+    size_t courseWords() const { return BitOps::wordsFor(courseCapacity); }
+
+    // Row of a student in the student bit rows, or INVALID_HANDLE if it has none.
+    size_t studentRow(Handle student) const { return rowOfStudent.get(student); }
+    Handle studentAt(size_t row) const { return studentOfRow[row]; }
+    size_t studentCount() const { return studentOfRow.size(); }
+
+    void enroll(Handle student, Handle course) {
+        size_t row = addStudent(student);
+        ensure(INVALID_HANDLE, course);
+        enrolled.set(row, course);
+        roster.set(course, row);
+    }
+
+    void complete(Handle student, Handle course) {
+        size_t row = addStudent(student);
+        ensure(INVALID_HANDLE, course);
+        enrolled.reset(row, course);
+        roster.reset(course, row);
+        completed.set(row, course);
+        completedRoster.set(course, row);
+    }
+
+    void drop(Handle student, Handle course) {
+        size_t row = studentRow(student);
+        if (row == INVALID_HANDLE || course >= roster.rowCount()) return;
+        enrolled.reset(row, course);
+        roster.reset(course, row);
+    }
+
+    void uncomplete(Handle student, Handle course) {
+        size_t row = studentRow(student);
+        if (row == INVALID_HANDLE || course >= roster.rowCount()) return;
+        completed.reset(row, course);
+        completedRoster.reset(course, row);
+    }
+
+    // Replaces a course's direct prerequisites and updates the closure; pass
+    // close = false when loading many courses, then call closePrerequisites().
+    void setPrerequisites(Handle course, const HandleSet& prereqs, bool close = true) {
+        ensure(INVALID_HANDLE, course);
+        if (!prereqs.empty()) ensure(INVALID_HANDLE, prereqs.data().back());
+        prerequisites.clearRow(course);
+        for (Handle p : prereqs) {
+            prerequisites.set(course, p);
+        }
+        if (!close) return;
+
+        vector<Handle> affected;
+        BitOps::forEachSetBit(descendants.row(course), courseWords(), [&](Handle d) { affected.push_back(d); });
+        if (!descendants.test(course, course)) affected.push_back(course);
+        recomputeClosure(affected);
+    }
+
+    // Recomputes the closure of every course from scratch, on `threads`
+    // threads (0 means one per hardware thread; see TransitiveClosure).
+    void closePrerequisites(unsigned threads = 0) {
+        size_t courses = prerequisites.rowCount();
+        size_t words = courseWords();
+        vector<size_t> offsets(courses + 1, 0);
+        vector<uint32_t> targets;
+        for (size_t c = 0; c < courses; c++) {
+            BitOps::forEachSetBit(prerequisites.row(c), words, [&](Handle p) { targets.push_back(p); });
+            offsets[c + 1] = targets.size();
+        }
+
+        TransitiveClosure closure;
+        closure.build(courses, offsets, targets, threads);
+        for (size_t c = 0; c < courses; c++) {
+            ancestors.clearRow(c);
+            descendants.clearRow(c);
+            BitOps::orInto(ancestors.mutableRow(c), closure.reachableFrom(c), closure.wordsPerRow());
+            BitOps::orInto(descendants.mutableRow(c), closure.reaching(c), closure.wordsPerRow());
+        }
+    }
+
+    // Whether giving `course` these prerequisites would close a cycle: one of
+    // them is the course itself or already requires it.
+    bool createsCycle(Handle course, const HandleSet& prereqs) const {
+        for (Handle p : prereqs) {
+            if (p == course || descendants.test(course, p)) return true;
+        }
+        return false;
+    }
+
+    // Rows of course bits (courseWords() words each)
+    const uint64_t* enrolledCourses(Handle student) const { return enrolled.row(studentRow(student)); }
+    const uint64_t* completedCourses(Handle student) const { return completed.row(studentRow(student)); }
+    const uint64_t* prerequisitesOf(Handle course) const { return prerequisites.row(course); }
+    const uint64_t* allPrerequisitesOf(Handle course) const { return ancestors.row(course); }
+    const uint64_t* coursesRequiring(Handle course) const { return descendants.row(course); }
+
+    // Rows of student bits (studentWords() words each), by student row
+    const uint64_t* enrolledStudents(Handle course) const { return roster.row(course); }
+    const uint64_t* completedStudents(Handle course) const { return completedRoster.row(course); }
+
+    bool isEnrolled(Handle student, Handle course) const { return enrolled.test(studentRow(student), course); }
+    bool hasCompleted(Handle student, Handle course) const { return completed.test(studentRow(student), course); }
+    bool requiresCourse(Handle course, Handle prereq) const { return ancestors.test(course, prereq); }
+
+    // Read-only copy for a published version, sharing every block that has
+    // not changed since `previous` was frozen from this object (see
+    // BitMatrix::freeze()).
+    EnrollmentBits freeze(const EnrollmentBits* previous) {
+        EnrollmentBits frozen;
+        frozen.rowOfStudent = rowOfStudent;
+        frozen.studentOfRow = studentOfRow;
+        frozen.studentCapacity = studentCapacity;
+        frozen.courseCapacity = courseCapacity;
+        frozen.enrolled = enrolled.freeze(previous ? &previous->enrolled : nullptr);
+        frozen.completed = completed.freeze(previous ? &previous->completed : nullptr);
+        frozen.roster = roster.freeze(previous ? &previous->roster : nullptr);
+        frozen.completedRoster = completedRoster.freeze(previous ? &previous->completedRoster : nullptr);
+        frozen.prerequisites = prerequisites.freeze(previous ? &previous->prerequisites : nullptr);
+        frozen.ancestors = ancestors.freeze(previous ? &previous->ancestors : nullptr);
+        frozen.descendants = descendants.freeze(previous ? &previous->descendants : nullptr);
+        return frozen;
+    }
+
+    // Takes private copies of every block still shared with another copy.
+    void detach() {
+        enrolled.detach();
+        completed.detach();
+        roster.detach();
+        completedRoster.detach();
+        prerequisites.detach();
+        ancestors.detach();
+        descendants.detach();
+    }
+
+    // Bytes held by the matrices and the student rows, counting shared blocks in full.
+    size_t bytes() const {
+        return enrolled.bytes() + completed.bytes() + roster.bytes() + completedRoster.bytes() +
+            prerequisites.bytes() + ancestors.bytes() + descendants.bytes() +
+            rowOfStudent.bytes() + studentOfRow.size() * sizeof(Handle);
+    }
+
+    void clear() {
+        rowOfStudent.clear();
+        studentOfRow.clear();
+        enrolled.clear();
+        completed.clear();
+        roster.clear();
+        completedRoster.clear();
+        prerequisites.clear();
+        ancestors.clear();
+        descendants.clear();
+        studentCapacity = 0;
+        courseCapacity = 0;
+    }
+};
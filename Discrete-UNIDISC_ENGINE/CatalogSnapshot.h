@@ -0,0 +1,586 @@
+#pragma once
+
+#include "Core.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <algorithm>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+private:
+    const char* base;
+    size_t length;
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+public:
+#if defined(_WIN32)
+    MappedFile() : base(nullptr), length(0), file(INVALID_HANDLE_VALUE), mapping(NULL) {}
+#else
+    MappedFile() : base(nullptr), length(0), fd(-1) {}
+#endif
+    ~MappedFile() { close(); }
+
+    bool open(const string& path) {
+        close();
+#if defined(_WIN32)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) { close(); return false; }
+        length = (size_t)size.QuadPart;
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mapping) { close(); return false; }
+        base = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!base) { close(); return false; }
+#else
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { close(); return false; }
+        length = (size_t)st.st_size;
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) { close(); return false; }
+        base = (const char*)p;
+#endif
+        return true;
+    }
+
+    void close() {
+#if defined(_WIN32)
+        if (base) UnmapViewOfFile(base);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (base) munmap((void*)base, length);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+        base = nullptr;
+        length = 0;
+    }
+
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+    bool isOpen() const { return base != nullptr; }
+};
+
+// On-disk layout. All integers are little-endian, every section starts on an
+// 8-byte boundary, and records only hold offsets, so a mapped file can be
+// queried in place. Course and student records are sorted by ID.
+//
+// Records are read and written exactly as they sit in memory, so only
+// little-endian hosts can use the format; the writer and open() refuse on others.
+struct SnapshotFormat {
+    static const uint32_t VERSION = 1;
+
+    static const char* magic() { return "UNIDSNAP"; }
+
+    static bool hostIsLittleEndian() {
+        const uint32_t probe = 1;
+        unsigned char low;
+        memcpy(&low, &probe, 1);
+        return low == 1;
+    }
+
+    enum Section {
+        COURSE_IDS, STUDENT_IDS, COURSES, STUDENTS, FACULTY, ROOMS, LABS, LINKS, STRINGS,
+        SECTION_COUNT
+    };
+
+    struct SectionEntry {
+        uint64_t offset;
+        uint64_t count;
+    };
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint64_t fileSize;
+        uint64_t checksum; // FNV-1a over every byte after the header
+        SectionEntry sections[SECTION_COUNT];
+    };
+
+    struct StrRef {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    // Course and student references are indices into COURSE_IDS / STUDENT_IDS;
+    // ranges point into LINKS.
+    struct CourseRecord {
+        uint32_t id;
+        StrRef name;
+        int32_t credits;
+        uint32_t prereqBegin, prereqCount;
+    };
+
+    struct StudentRecord {
+        uint32_t id;
+        StrRef name;
+        int32_t credits;
+        uint32_t enrolledBegin, enrolledCount;
+        uint32_t completedBegin, completedCount;
+    };
+
+    struct FacultyRecord {
+        StrRef id;
+        StrRef name;
+        int32_t maxCourses;
+        uint32_t assignedBegin, assignedCount;
+    };
+
+    struct RoomRecord {
+        StrRef id;
+        StrRef type;
+        int32_t capacity;
+    };
+
+    struct LabRecord {
+        StrRef id;
+        uint32_t course;
+        int32_t capacity;
+        uint32_t studentsBegin, studentsCount;
+    };
+
+    static uint64_t checksum(const char* data, size_t length) {
+        uint64_t hash = 1469598103934665603ULL;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= (unsigned char)data[i];
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+};
+
+class SnapshotWriter {
+private:
+    typedef SnapshotFormat::StrRef StrRef;
+
+    string strings;
+    vector<uint32_t> links;
+    map<Handle, uint32_t> courseIndex;
+    map<Handle, uint32_t> studentIndex;
+    vector<StrRef> courseIds;
+    vector<StrRef> studentIds;
+
+    StrRef addString(const string& s) {
+        StrRef ref = { (uint32_t)strings.size(), (uint32_t)s.size() };
+        strings += s;
+        return ref;
+    }
+
+    uint32_t courseRef(Handle h) {
+        auto it = courseIndex.find(h);
+        if (it != courseIndex.end()) return it->second;
+        uint32_t index = (uint32_t)courseIds.size();
+        courseIds.push_back(addString(Symbols::courses().name(h)));
+        courseIndex[h] = index;
+        return index;
+    }
+
+    uint32_t studentRef(Handle h) {
+        auto it = studentIndex.find(h);
+        if (it != studentIndex.end()) return it->second;
+        uint32_t index = (uint32_t)studentIds.size();
+        studentIds.push_back(addString(Symbols::students().name(h)));
+        studentIndex[h] = index;
+        return index;
+    }
+
+    void addCourseLinks(const HandleSet& set, uint32_t& begin, uint32_t& count) {
+        begin = (uint32_t)links.size();
+        count = (uint32_t)set.size();
+        for (Handle h : set) links.push_back(courseRef(h));
+    }
+
+    template<typename T>
+    static void appendSection(string& out, SnapshotFormat::SectionEntry& entry, const vector<T>& items) {
+        while (out.size() % 8) out.push_back('\0');
+        entry.offset = out.size();
+        entry.count = items.size();
+        if (!items.empty()) out.append((const char*)items.data(), items.size() * sizeof(T));
+    }
+
+    template<typename T>
+    static vector<const T*> sortedByID(const EntityStore<T>& store) {
+        vector<const T*> sorted;
+        for (const T& record : store) sorted.push_back(&record);
+        sort(sorted.begin(), sorted.end(), [](const T* a, const T* b) { return a->getID() < b->getID(); });
+        return sorted;
+    }
+
+    void reset() {
+        strings.clear();
+        links.clear();
+        courseIndex.clear();
+        studentIndex.clear();
+        courseIds.clear();
+        studentIds.clear();
+    }
+
+public:
+    bool write(const DataManager& dm, const string& path) {
+        typedef SnapshotFormat F;
+        if (!F::hostIsLittleEndian()) return false;
+        reset();
+
+        vector<F::CourseRecord> courses;
+        for (const Course* c : sortedByID(dm.getAllCourses())) {
+            F::CourseRecord rec;
+            rec.id = courseRef(c->getHandle());
+            rec.name = addString(c->getName());
+            rec.credits = c->getCredits();
+            addCourseLinks(c->getPrerequisiteHandles(), rec.prereqBegin, rec.prereqCount);
+            courses.push_back(rec);
+        }
+
+        vector<F::StudentRecord> students;
+        for (const Student* s : sortedByID(dm.getAllStudents())) {
+            F::StudentRecord rec;
+            rec.id = studentRef(s->getHandle());
+            rec.name = addString(s->getName());
+            rec.credits = s->getCurrentCredits();
+            addCourseLinks(s->getEnrolledHandles(), rec.enrolledBegin, rec.enrolledCount);
+            addCourseLinks(s->getCompletedHandles(), rec.completedBegin, rec.completedCount);
+            students.push_back(rec);
+        }
+
+        vector<F::FacultyRecord> faculty;
+        for (const Faculty& f : dm.getAllFaculty()) {
+            F::FacultyRecord rec;
+            rec.id = addString(f.getID());
+            rec.name = addString(f.getName());
+            rec.maxCourses = f.getMaxCourses();
+            addCourseLinks(f.getAssignedHandles(), rec.assignedBegin, rec.assignedCount);
+            faculty.push_back(rec);
+        }
+
+        vector<F::RoomRecord> rooms;
+        for (const Room& r : dm.getAllRooms()) {
+            F::RoomRecord rec;
+            rec.id = addString(r.getID());
+            rec.type = addString(r.getType());
+            rec.capacity = r.getCapacity();
+            rooms.push_back(rec);
+        }
+
+        vector<F::LabRecord> labs;
+        for (const Lab& l : dm.getAllLabs()) {
+            F::LabRecord rec;
+            rec.id = addString(l.getID());
+            rec.course = courseRef(l.getAssociatedCourseHandle());
+            rec.capacity = l.getCapacity();
+            rec.studentsBegin = (uint32_t)links.size();
+            rec.studentsCount = (uint32_t)l.getEnrolledHandles().size();
+            for (Handle h : l.getEnrolledHandles()) links.push_back(studentRef(h));
+            labs.push_back(rec);
+        }
+
+        F::Header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, F::magic(), sizeof(header.magic));
+        header.version = F::VERSION;
+        header.headerSize = sizeof(F::Header);
+
+        string out(sizeof(F::Header), '\0');
+        appendSection(out, header.sections[F::COURSE_IDS], courseIds);
+        appendSection(out, header.sections[F::STUDENT_IDS], studentIds);
+        appendSection(out, header.sections[F::COURSES], courses);
+        appendSection(out, header.sections[F::STUDENTS], students);
+        appendSection(out, header.sections[F::FACULTY], faculty);
+        appendSection(out, header.sections[F::ROOMS], rooms);
+        appendSection(out, header.sections[F::LABS], labs);
+        appendSection(out, header.sections[F::LINKS], links);
+        appendSection(out, header.sections[F::STRINGS], vector<char>(strings.begin(), strings.end()));
+
+        header.fileSize = out.size();
+        header.checksum = F::checksum(out.data() + sizeof(F::Header), out.size() - sizeof(F::Header));
+        memcpy(&out[0], &header, sizeof(F::Header));
+
+        ofstream file(path.c_str(), ios::binary | ios::trunc);
+        if (!file) return false;
+        file.write(out.data(), out.size());
+        return (bool)file;
+    }
+};
+
+// A snapshot opened in place. Lookups binary-search the mapped, ID-sorted
+// records; nothing is parsed or allocated until loadInto() is called.
+class MappedSnapshot {
+private:
+    MappedFile file;
+    const SnapshotFormat::Header* header;
+    string lastError;
+
+    template<typename T>
+    const T* section(SnapshotFormat::Section s) const {
+        return (const T*)(file.data() + header->sections[s].offset);
+    }
+
+    bool fail(const string& message) {
+        lastError = message;
+        file.close();
+        header = nullptr;
+        return false;
+    }
+
+    template<typename T>
+    const T* findByID(SnapshotFormat::Section s, const SnapshotFormat::StrRef* ids, const string& id) const {
+        const T* records = section<T>(s);
+        size_t lo = 0, hi = count(s);
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            int cmp = compare(ids[records[mid].id], id);
+            if (cmp == 0) return &records[mid];
+            if (cmp < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        return nullptr;
+    }
+
+    int compare(const SnapshotFormat::StrRef& ref, const char* s, size_t length) const {
+        size_t n = min((size_t)ref.length, length);
+        int cmp = n ? memcmp(strings() + ref.offset, s, n) : 0;
+        if (cmp != 0) return cmp;
+        return ref.length < length ? -1 : (ref.length > length ? 1 : 0);
+    }
+
+    int compare(const SnapshotFormat::StrRef& ref, const string& s) const {
+        return compare(ref, s.data(), s.size());
+    }
+
+    // findByID() binary-searches the records, so their IDs must strictly increase.
+    template<typename T>
+    bool sortedByID(SnapshotFormat::Section s, SnapshotFormat::Section idTable) const {
+        const T* records = section<T>(s);
+        const SnapshotFormat::StrRef* ids = section<SnapshotFormat::StrRef>(idTable);
+        for (size_t i = 1; i < count(s); i++) {
+            const SnapshotFormat::StrRef& id = ids[records[i].id];
+            if (compare(ids[records[i - 1].id], strings() + id.offset, id.length) >= 0) return false;
+        }
+        return true;
+    }
+
+    bool validString(const SnapshotFormat::StrRef& ref) const {
+        size_t size = count(SnapshotFormat::STRINGS);
+        return ref.offset <= size && ref.length <= size - ref.offset;
+    }
+
+    // A LINKS range must lie inside the pool and every entry must index a
+    // record of the referenced ID table.
+    bool validLinks(uint32_t begin, uint32_t length, SnapshotFormat::Section target) const {
+        size_t size = count(SnapshotFormat::LINKS);
+        if (begin > size || length > size - begin) return false;
+        const uint32_t* pool = links();
+        for (uint32_t k = 0; k < length; k++) {
+            if (pool[begin + k] >= count(target)) return false;
+        }
+        return true;
+    }
+
+    bool validIDs(SnapshotFormat::Section s) const {
+        const SnapshotFormat::StrRef* ids = section<SnapshotFormat::StrRef>(s);
+        for (size_t i = 0; i < count(s); i++) {
+            if (!validString(ids[i])) return false;
+        }
+        return true;
+    }
+
+    // Checks every index a record holds, so lookups and loadInto() never read
+    // outside the mapped sections, even for a file whose checksum matches.
+    bool validRecords() const {
+        typedef SnapshotFormat F;
+        if (!validIDs(F::COURSE_IDS) || !validIDs(F::STUDENT_IDS)) return false;
+
+        const F::CourseRecord* c = courses();
+        for (size_t i = 0; i < courseCount(); i++) {
+            if (c[i].id >= count(F::COURSE_IDS) || !validString(c[i].name) ||
+                !validLinks(c[i].prereqBegin, c[i].prereqCount, F::COURSE_IDS)) return false;
+        }
+        const F::StudentRecord* s = students();
+        for (size_t i = 0; i < studentCount(); i++) {
+            if (s[i].id >= count(F::STUDENT_IDS) || !validString(s[i].name) ||
+                !validLinks(s[i].enrolledBegin, s[i].enrolledCount, F::COURSE_IDS) ||
+                !validLinks(s[i].completedBegin, s[i].completedCount, F::COURSE_IDS)) return false;
+        }
+        const F::FacultyRecord* f = section<F::FacultyRecord>(F::FACULTY);
+        for (size_t i = 0; i < count(F::FACULTY); i++) {
+            if (!validString(f[i].id) || !validString(f[i].name) ||
+                !validLinks(f[i].assignedBegin, f[i].assignedCount, F::COURSE_IDS)) return false;
+        }
+        const F::RoomRecord* r = section<F::RoomRecord>(F::ROOMS);
+        for (size_t i = 0; i < count(F::ROOMS); i++) {
+            if (!validString(r[i].id) || !validString(r[i].type)) return false;
+        }
+        const F::LabRecord* l = section<F::LabRecord>(F::LABS);
+        for (size_t i = 0; i < count(F::LABS); i++) {
+            if (!validString(l[i].id) || l[i].course >= count(F::COURSE_IDS) ||
+                !validLinks(l[i].studentsBegin, l[i].studentsCount, F::STUDENT_IDS)) return false;
+        }
+        return sortedByID<F::CourseRecord>(F::COURSES, F::COURSE_IDS) &&
+            sortedByID<F::StudentRecord>(F::STUDENTS, F::STUDENT_IDS);
+    }
+
+public:
+    MappedSnapshot() : header(nullptr) {}
+
+    bool open(const string& path, bool verifyChecksum = true) {
+        typedef SnapshotFormat F;
+
+        if (!F::hostIsLittleEndian()) return fail("snapshots need a little-endian host");
+        if (!file.open(path)) return fail("cannot open " + path);
+        if (file.size() < sizeof(F::Header)) return fail("file too small");
+
+        header = (const F::Header*)file.data();
+        if (memcmp(header->magic, F::magic(), sizeof(header->magic)) != 0) return fail("not a catalog snapshot");
+        if (header->version != F::VERSION) return fail("unsupported snapshot version " + to_string(header->version));
+        if (header->headerSize != sizeof(F::Header) || header->fileSize != file.size()) return fail("truncated snapshot");
+
+        const size_t recordSizes[F::SECTION_COUNT] = {
+            sizeof(F::StrRef), sizeof(F::StrRef), sizeof(F::CourseRecord), sizeof(F::StudentRecord),
+            sizeof(F::FacultyRecord), sizeof(F::RoomRecord), sizeof(F::LabRecord), sizeof(uint32_t), 1
+        };
+        for (int s = 0; s < F::SECTION_COUNT; s++) {
+            const F::SectionEntry& e = header->sections[s];
+            if (e.offset < sizeof(F::Header) || e.offset % 8 || e.offset > file.size() ||
+                e.count > (file.size() - e.offset) / recordSizes[s]) {
+                return fail("corrupt section table");
+            }
+        }
+
+        if (verifyChecksum &&
+            F::checksum(file.data() + sizeof(F::Header), file.size() - sizeof(F::Header)) != header->checksum) {
+            return fail("checksum mismatch");
+        }
+        if (!validRecords()) return fail("corrupt record");
+        return true;
+    }
+
+    void close() {
+        file.close();
+        header = nullptr;
+    }
+
+    bool isOpen() const { return header != nullptr; }
+    const string& error() const { return lastError; }
+    uint64_t checksum() const { return header->checksum; }
+
+    size_t count(SnapshotFormat::Section s) const { return header->sections[s].count; }
+    size_t courseCount() const { return count(SnapshotFormat::COURSES); }
+    size_t studentCount() const { return count(SnapshotFormat::STUDENTS); }
+
+    const char* strings() const { return section<char>(SnapshotFormat::STRINGS); }
+    const uint32_t* links() const { return section<uint32_t>(SnapshotFormat::LINKS); }
+    string str(const SnapshotFormat::StrRef& ref) const { return string(strings() + ref.offset, ref.length); }
+
+    const SnapshotFormat::StrRef& courseID(uint32_t index) const {
+        return section<SnapshotFormat::StrRef>(SnapshotFormat::COURSE_IDS)[index];
+    }
+    const SnapshotFormat::StrRef& studentID(uint32_t index) const {
+        return section<SnapshotFormat::StrRef>(SnapshotFormat::STUDENT_IDS)[index];
+    }
+
+    const SnapshotFormat::CourseRecord* courses() const {
+        return section<SnapshotFormat::CourseRecord>(SnapshotFormat::COURSES);
+    }
+    const SnapshotFormat::StudentRecord* students() const {
+        return section<SnapshotFormat::StudentRecord>(SnapshotFormat::STUDENTS);
+    }
+
+    const SnapshotFormat::CourseRecord* findCourse(const string& id) const {
+        return findByID<SnapshotFormat::CourseRecord>(SnapshotFormat::COURSES,
+            section<SnapshotFormat::StrRef>(SnapshotFormat::COURSE_IDS), id);
+    }
+    const SnapshotFormat::StudentRecord* findStudent(const string& id) const {
+        return findByID<SnapshotFormat::StudentRecord>(SnapshotFormat::STUDENTS,
+            section<SnapshotFormat::StrRef>(SnapshotFormat::STUDENT_IDS), id);
+    }
+
+    // Materializes the snapshot into a DataManager (replacing records with the
+    // same IDs). Every index was checked by open(); fails if nothing is open.
+    bool loadInto(DataManager& dm) const {
+        typedef SnapshotFormat F;
+        if (!isOpen()) return false;
+        const uint32_t* pool = links();
+        dm.beginBatch();
+
+        const F::CourseRecord* c = courses();
+        for (size_t i = 0; i < courseCount(); i++) {
+            Course course(str(courseID(c[i].id)), str(c[i].name), c[i].credits);
+            for (uint32_t k = 0; k < c[i].prereqCount; k++) {
+                course.addPrerequisite(str(courseID(pool[c[i].prereqBegin + k])));
+            }
+            dm.addCourse(course);
+        }
+
+        const F::StudentRecord* s = students();
+        for (size_t i = 0; i < studentCount(); i++) {
+            Student student(str(studentID(s[i].id)), str(s[i].name));
+            HandleSet enrolled, completed;
+            for (uint32_t k = 0; k < s[i].enrolledCount; k++) {
+                enrolled.insert(Symbols::courses().intern(str(courseID(pool[s[i].enrolledBegin + k]))));
+            }
+            for (uint32_t k = 0; k < s[i].completedCount; k++) {
+                completed.insert(Symbols::courses().intern(str(courseID(pool[s[i].completedBegin + k]))));
+            }
+            student.restoreState(enrolled, completed, s[i].credits);
+            dm.addStudent(student);
+        }
+
+        const F::FacultyRecord* f = section<F::FacultyRecord>(F::FACULTY);
+        for (size_t i = 0; i < count(F::FACULTY); i++) {
+            Faculty fac(str(f[i].id), str(f[i].name), f[i].maxCourses);
+            for (uint32_t k = 0; k < f[i].assignedCount; k++) {
+                fac.assignCourse(str(courseID(pool[f[i].assignedBegin + k])));
+            }
+            dm.addFaculty(fac);
+        }
+
+        const F::RoomRecord* r = section<F::RoomRecord>(F::ROOMS);
+        for (size_t i = 0; i < count(F::ROOMS); i++) {
+            dm.addRoom(Room(str(r[i].id), r[i].capacity, str(r[i].type)));
+        }
+
+        const F::LabRecord* l = section<F::LabRecord>(F::LABS);
+        for (size_t i = 0; i < count(F::LABS); i++) {
+            Lab lab(str(l[i].id), str(courseID(l[i].course)), l[i].capacity);
+            for (uint32_t k = 0; k < l[i].studentsCount; k++) {
+                lab.enrollStudent(str(studentID(pool[l[i].studentsBegin + k])));
+            }
+            dm.addLab(lab);
+        }
+        dm.endBatch();
+        return true;
+    }
+};
@@ -0,0 +1,240 @@
+#pragma once
+
+#include "Core.h"
+#include <vector>
+#include <string>
+#include <queue>
+#include <thread>
+#include <algorithm>
+#include <functional>
+
+using namespace std;
+
+struct CoursePair {
+    string courseA;
+    string courseB;
+    size_t shared;
+
+    CoursePair(const string& a, const string& b, size_t n) : courseA(a), courseB(b), shared(n) {}
+};
+
+// Students shared by every pair of courses: the sparse product E^T x E of
+// the student x course enrollment matrix E, kept as one CSR row per course
+// (rows in course ID order, entries sorted by column, no diagonal).
+//
+// build() takes the student -> course index from the published columns,
+// transposes it into course -> student rosters, and multiplies row by row
+// (Gustavson): for a course, every student on its roster adds one to each
+// other course that student takes. Rows are split into contiguous ranges of
+// equal work (sum of the rostered students' course loads) and computed on
+// separate threads, each with its own dense accumulator. Cost is the number
+// of co-enrolled (student, course, course) triples, however many course
+// pairs there are.
+class CoEnrollmentMatrix {
+private:
+    const DataManager* dm;
+    vector<Handle> courseHandles;  // row -> course
+    vector<uint32_t> rowOfCourse;  // course handle -> row, NO_ROW if absent
+    vector<uint32_t> enrolledCount;
+    vector<size_t> offsets;        // rows + 1 offsets into columns/counts
+    vector<uint32_t> columns;
+    vector<uint32_t> counts;
+
+    enum : uint32_t { NO_ROW = 0xFFFFFFFFu };
+
+    struct Slice {
+        vector<size_t> lengths;
+        vector<uint32_t> columns;
+        vector<uint32_t> counts;
+    };
+
+    static void multiply(size_t first, size_t last, const vector<size_t>& rosterOffsets, const vector<uint32_t>& rosters,
+        const vector<size_t>& loadOffsets, const vector<uint32_t>& loads, size_t courseCount, Slice& out) {
+        vector<uint32_t> accumulator(courseCount, 0);
+        vector<uint32_t> touched;
+        for (size_t c = first; c < last; c++) {
+            touched.clear();
+            for (size_t i = rosterOffsets[c]; i < rosterOffsets[c + 1]; i++) {
+                uint32_t s = rosters[i];
+                for (size_t j = loadOffsets[s]; j < loadOffsets[s + 1]; j++) {
+                    uint32_t other = loads[j];
+                    if (other == c) continue;
+                    if (accumulator[other]++ == 0) touched.push_back(other);
+                }
+            }
+            sort(touched.begin(), touched.end());
+            for (uint32_t other : touched) {
+                out.columns.push_back(other);
+                out.counts.push_back(accumulator[other]);
+                accumulator[other] = 0;
+            }
+            out.lengths.push_back(touched.size());
+        }
+    }
+
+    size_t rowOf(const string& courseID) const {
+        Handle h = Symbols::courses().find(courseID);
+        return h < rowOfCourse.size() ? rowOfCourse[h] : NO_ROW;
+    }
+
+    CoursePair pairAt(size_t row, size_t entry) const {
+        return CoursePair(Symbols::courses().name(courseHandles[row]),
+            Symbols::courses().name(courseHandles[columns[entry]]), counts[entry]);
+    }
+
+public:
+    explicit CoEnrollmentMatrix(DataManager* manager) : dm(manager) {}
+
+    // Recomputes the matrix from the current catalog version; 0 threads means
+    // one per hardware thread.
+    void build(unsigned threads = 0) {
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
+        const CatalogColumns& catalog = version->columns;
+        size_t courseCount = catalog.courseCount();
+        size_t studentCount = catalog.studentCount();
+
+        courseHandles.clear();
+        rowOfCourse.assign(Symbols::courses().size(), NO_ROW);
+        for (size_t c = 0; c < courseCount; c++) {
+            courseHandles.push_back(catalog.courseHandle(c));
+            if (courseHandles.back() >= rowOfCourse.size()) rowOfCourse.resize(courseHandles.back() + 1, NO_ROW);
+            rowOfCourse[courseHandles.back()] = (uint32_t)c;
+        }
+
+        // E: student row -> course rows
+        vector<size_t> loadOffsets(1, 0);
+        vector<uint32_t> loads;
+        enrolledCount.assign(courseCount, 0);
+        for (size_t s = 0; s < studentCount; s++) {
+            for (Handle h : catalog.enrolled(s)) {
+                uint32_t c = h < rowOfCourse.size() ? rowOfCourse[h] : NO_ROW;
+                if (c == NO_ROW) continue;
+                loads.push_back(c);
+                enrolledCount[c]++;
+            }
+            loadOffsets.push_back(loads.size());
+        }
+
+        // E^T: course row -> student rows, by counting sort
+        vector<size_t> rosterOffsets(courseCount + 1, 0);
+        for (size_t c = 0; c < courseCount; c++) rosterOffsets[c + 1] = rosterOffsets[c] + enrolledCount[c];
+        vector<uint32_t> rosters(loads.size());
+        vector<size_t> next(rosterOffsets.begin(), rosterOffsets.end() - 1);
+        for (size_t s = 0; s < studentCount; s++) {
+            for (size_t j = loadOffsets[s]; j < loadOffsets[s + 1]; j++) rosters[next[loads[j]]++] = (uint32_t)s;
+        }
+
+        vector<size_t> work(courseCount + 1, 0);
+        for (size_t c = 0; c < courseCount; c++) {
+            size_t rowWork = 0;
+            for (size_t i = rosterOffsets[c]; i < rosterOffsets[c + 1]; i++) {
+                rowWork += loadOffsets[rosters[i] + 1] - loadOffsets[rosters[i]];
+            }
+            work[c + 1] = work[c] + rowWork;
+        }
+
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        threads = (unsigned)max((size_t)1, min((size_t)threads, courseCount));
+        vector<size_t> bounds(1, 0);
+        for (unsigned t = 1; t < threads; t++) {
+            size_t target = work[courseCount] / threads * t;
+            bounds.push_back(max(bounds.back(), (size_t)(lower_bound(work.begin(), work.end(), target) - work.begin())));
+        }
+        bounds.push_back(courseCount);
+
+        vector<Slice> slices(threads);
+        vector<thread> pool;
+        for (unsigned t = 0; t < threads; t++) {
+            pool.push_back(thread([&, t]() {
+                multiply(bounds[t], bounds[t + 1], rosterOffsets, rosters, loadOffsets, loads, courseCount, slices[t]);
+            }));
+        }
+        for (thread& t : pool) t.join();
+
+        offsets.assign(1, 0);
+        columns.clear();
+        counts.clear();
+        for (const Slice& slice : slices) {
+            for (size_t length : slice.lengths) offsets.push_back(offsets.back() + length);
+            columns.insert(columns.end(), slice.columns.begin(), slice.columns.end());
+            counts.insert(counts.end(), slice.counts.begin(), slice.counts.end());
+        }
+    }
+
+    size_t courseCount() const { return courseHandles.size(); }
+
+    // Course pairs sharing at least one student.
+    size_t pairCount() const { return columns.size() / 2; }
+
+    size_t shared(const string& courseA, const string& courseB) const {
+        size_t a = rowOf(courseA), b = rowOf(courseB);
+        if (a == NO_ROW || b == NO_ROW) return 0;
+        if (a == b) return enrolledCount[a];
+        const uint32_t* first = columns.data() + offsets[a];
+        const uint32_t* last = columns.data() + offsets[a + 1];
+        const uint32_t* it = lower_bound(first, last, (uint32_t)b);
+        return it != last && *it == b ? counts[it - columns.data()] : 0;
+    }
+
+    // Pairs sharing at least `threshold` students (and at least one), in
+    // course ID order.
+    vector<CoursePair> pairsAtLeast(size_t threshold) const {
+        vector<CoursePair> result;
+        for (size_t row = 0; row + 1 < offsets.size(); row++) {
+            for (size_t e = offsets[row]; e < offsets[row + 1]; e++) {
+                if (columns[e] > row && counts[e] >= threshold) result.push_back(pairAt(row, e));
+            }
+        }
+        return result;
+    }
+
+    // The k pairs sharing the most students, most first; ties in course ID
+    // order. Entries are visited in that order, so the heap keeps the worst
+    // pair kept so far on top: fewest shared, then latest entry.
+    vector<CoursePair> topPairs(size_t k) const {
+        typedef pair<uint32_t, size_t> Ranked; // shared, entry
+        auto better = [](const Ranked& a, const Ranked& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        };
+        priority_queue<Ranked, vector<Ranked>, decltype(better)> best(better);
+        for (size_t row = 0; row + 1 < offsets.size() && k > 0; row++) {
+            for (size_t e = offsets[row]; e < offsets[row + 1]; e++) {
+                if (columns[e] < row) continue;
+                Ranked candidate(counts[e], e);
+                if (best.size() < k) best.push(candidate);
+                else if (better(candidate, best.top())) {
+                    best.pop();
+                    best.push(candidate);
+                }
+            }
+        }
+
+        vector<size_t> entries;
+        for (; !best.empty(); best.pop()) entries.push_back(best.top().second);
+        sort(entries.begin(), entries.end(), [&](size_t x, size_t y) {
+            return counts[x] != counts[y] ? counts[x] > counts[y] : x < y;
+        });
+        vector<CoursePair> result;
+        for (size_t e : entries) {
+            size_t row = upper_bound(offsets.begin(), offsets.end(), e) - offsets.begin() - 1;
+            result.push_back(pairAt(row, e));
+        }
+        return result;
+    }
+
+    // The k courses sharing the most students with `courseID`, most first.
+    vector<CoursePair> topPartners(const string& courseID, size_t k) const {
+        vector<CoursePair> result;
+        size_t row = rowOf(courseID);
+        if (row == NO_ROW) return result;
+
+        vector<size_t> entries;
+        for (size_t e = offsets[row]; e < offsets[row + 1]; e++) entries.push_back(e);
+        k = min(k, entries.size());
+        partial_sort(entries.begin(), entries.begin() + k, entries.end(), [&](size_t x, size_t y) {
+            return counts[x] != counts[y] ? counts[x] > counts[y] : x < y;
+        });
+        for (size_t i = 0; i < k; i++) result.push_back(pairAt(row, entries[i]));
+        return result;
+    }
+};
@@ -9,26 +9,26 @@
 
 class ConsistencyChecker {
 private:
-    DataManager* dm;
+    const DataManager* dm;
     vector<string> violations;
 
 public:
-    ConsistencyChecker() {
-        dm = DataManager::getInstance();
+    explicit ConsistencyChecker(DataManager* manager) {
+        dm = manager;
     }
 
-    void detectCourseConflicts() {
+    // The checks below read one pinned catalog version, so a run never sees
+    // enrollments change underneath it.
+    void detectCourseConflicts(const CatalogVersion& version) {
         cout << "\n--- Detecting Course Conflicts ---" << endl;
         violations.clear();
 
-        for (auto& pair : dm->getAllStudents()) {
-            Student& student = pair.second;
-            set<string> enrolled = student.getEnrolledCourses();
-
-            
+        const CatalogColumns& columns = version.columns;
+        for (size_t row = 0; row < columns.studentCount(); row++) {
             map<string, vector<string>> prefixGroups;
 
-            for (const string& courseID : enrolled) {
+            for (Handle course : columns.enrolled(row)) {
+                const string& courseID = Symbols::courses().name(course);
                 if (courseID.length() >= 2) {
                     string prefix = courseID.substr(0, 2);
                     prefixGroups[prefix].push_back(courseID);
@@ -37,7 +37,7 @@ public:
 
             for (auto& prefixPair : prefixGroups) {
                 if (prefixPair.second.size() > 3) {
-                    string violation = "Student " + student.getID() +
+                    string violation = "Student " + columns.studentID(row) +
                         " enrolled in too many " + prefixPair.first +
                         " courses: " + to_string(prefixPair.second.size());
                     violations.push_back(violation);
@@ -51,31 +51,38 @@ public:
         }
     }
 
-    void detectMissingPrerequisites() {
+    void detectMissingPrerequisites(const CatalogVersion& version) {
         cout << "\n--- Detecting Missing Prerequisites ---" << endl;
         int violationCount = 0;
 
-        for (auto& pair : dm->getAllStudents()) {
-            Student& student = pair.second;
-
-            for (const string& courseID : student.getEnrolledCourses()) {
-                Course* course = dm->getCourse(courseID);
-                if (!course) continue;
-
-                for (const string& prereq : course->getPrerequisites()) {
-                    if (student.getCompletedCourses().find(prereq) ==
-                        student.getCompletedCourses().end() &&
-                        student.getEnrolledCourses().find(prereq) ==
-                        student.getEnrolledCourses().end()) {
-
-                        string violation = "Student " + student.getID() +
-                            " enrolled in " + courseID +
-                            " without prerequisite " + prereq;
-                        violations.push_back(violation);
-                        cout << "VIOLATION: " << violation << endl;
-                        violationCount++;
-                    }
-                }
+        const EnrollmentBits& bits = version.bits;
+        size_t words = bits.courseWords();
+        vector<uint64_t> missing(words);
+
+        const CatalogColumns& columns = version.columns;
+        for (size_t row = 0; row < columns.studentCount(); row++) {
+            Handle student = columns.studentHandle(row);
+            const uint64_t* enrolled = bits.enrolledCourses(student);
+            const uint64_t* completed = bits.completedCourses(student);
+
+            for (Handle courseHandle : columns.enrolled(row)) {
+                if (columns.courseRow(courseHandle) == CatalogColumns::NO_ROW) continue;
+
+                const uint64_t* prereqs = bits.prerequisitesOf(courseHandle);
+                if (BitOps::isSubsetOfUnion(prereqs, completed, enrolled, words)) continue;
+
+                missing.assign(prereqs, prereqs + words);
+                BitOps::andNotInto(missing.data(), completed, words);
+                BitOps::andNotInto(missing.data(), enrolled, words);
+
+                BitOps::forEachSetBit(missing.data(), words, [&](Handle prereq) {
+                    string violation = "Student " + columns.studentID(row) +
+                        " enrolled in " + Symbols::courses().name(courseHandle) +
+                        " without prerequisite " + Symbols::courses().name(prereq);
+                    violations.push_back(violation);
+                    cout << "VIOLATION: " << violation << endl;
+                    violationCount++;
+                });
             }
         }
 
@@ -84,17 +91,17 @@ public:
         }
     }
 
-    void detectOverload() {
+    void detectOverload(const CatalogVersion& version) {
         cout << "\n--- Detecting Student Overload ---" << endl;
         const int MAX_CREDITS = 18;
         int overloadCount = 0;
 
-        for (auto& pair : dm->getAllStudents()) {
-            Student& student = pair.second;
-
-            if (student.getCurrentCredits() > MAX_CREDITS) {
-                string violation = "Student " + student.getID() +
-                    " overloaded: " + to_string(student.getCurrentCredits()) +
+        const CatalogColumns& columns = version.columns;
+        for (size_t row = 0; row < columns.studentCount(); row++) {
+            int credits = columns.studentCreditsAt(row);
+            if (credits > MAX_CREDITS) {
+                string violation = "Student " + columns.studentID(row) +
+                    " overloaded: " + to_string(credits) +
                     " credits (max: " + to_string(MAX_CREDITS) + ")";
                 violations.push_back(violation);
                 cout << "OVERLOAD: " << violation << endl;
@@ -107,11 +114,16 @@ public:
         }
     }
 
+    void detectCourseConflicts() { detectCourseConflicts(*dm->snapshot()); }
+    void detectMissingPrerequisites() { detectMissingPrerequisites(*dm->snapshot()); }
+    void detectOverload() { detectOverload(*dm->snapshot()); }
+
     void runAllChecks() {
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
         violations.clear();
-        detectCourseConflicts();
-        detectMissingPrerequisites();
-        detectOverload();
+        detectCourseConflicts(*version);
+        detectMissingPrerequisites(*version);
+        detectOverload(*version);
 
         cout << "\n=== CONSISTENCY CHECK SUMMARY ===" << endl;
         cout << "Total violations found: " << violations.size() << endl;
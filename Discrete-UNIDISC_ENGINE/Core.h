@@ -4,6 +4,14 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include "SymbolTable.h"
+#include "BitMatrix.h"
+#include "Persistent.h"
 
 using namespace std;
 
@@ -15,195 +23,1446 @@ class Room;
 class Lab;
 
 
+// Receives enrollment and assignment changes from records owned by a DataManager.
+class RecordListener {
+public:
+    virtual ~RecordListener() {}
+    virtual void onEnroll(Handle student, Handle course, int credits) = 0;
+    virtual void onComplete(Handle student, Handle course, int credits) = 0;
+    virtual void onDrop(Handle student, Handle course, int credits) = 0;
+    virtual void onAssign(Handle faculty, Handle course) = 0;
+    virtual void onUnassign(Handle faculty, Handle course) = 0;
+    virtual void onPrerequisitesChanged(Handle course) = 0;
+    // Asked before a course gains these prerequisites; false rejects the edit.
+    virtual bool acceptsPrerequisites(Handle course, const HandleSet& prereqs) = 0;
+    virtual void onLabJoin(Handle lab, Handle student) = 0;
+    virtual void onLabLeave(Handle lab, Handle student) = 0;
+};
+
+// Public hook for every change a DataManager applies, called after the change
+// (and the DataManager's own indexes) are in place. Used by the mutation journal.
+class MutationObserver {
+public:
+    virtual ~MutationObserver() {}
+    virtual void onCourseAdded(const Course&) {}
+    virtual void onStudentAdded(const Student&) {}
+    virtual void onFacultyAdded(const Faculty&) {}
+    virtual void onRoomAdded(const Room&) {}
+    virtual void onLabAdded(const Lab&) {}
+    virtual void onEnrolled(Handle, Handle, int) {}
+    virtual void onCompleted(Handle, Handle, int) {}
+    virtual void onDropped(Handle, Handle, int) {}
+    virtual void onAssigned(Handle, Handle) {}
+    virtual void onUnassigned(Handle, Handle) {}
+    virtual void onPrerequisitesUpdated(const Course&) {}
+    virtual void onLabJoined(Handle, Handle) {}
+    virtual void onLabLeft(Handle, Handle) {}
+    virtual void onCleared() {}
+};
+
+// Back-reference from a stored record to its owner. Copies start detached,
+// so editing a copy of a stored record never touches the owner's indexes.
+class ListenerLink {
+private:
+    RecordListener* target;
+
+public:
+    ListenerLink() : target(nullptr) {}
+    ListenerLink(const ListenerLink&) : target(nullptr) {}
+    ListenerLink& operator=(const ListenerLink&) { return *this; }
+
+    void attach(RecordListener* listener) {
+        if (target != listener) target = listener; // no write when already attached
+    }
+    RecordListener* operator->() const { return target; }
+    explicit operator bool() const { return target != nullptr; }
+};
+
 class Course {
 private:
-    string courseID;
+    Handle courseID;
     string courseName;
     int credits;
-    set<string> prerequisites; 
+    HandleSet prerequisites; 
+    ListenerLink listener;
 
 public:
-    Course() : credits(0) {}
+    Course() : courseID(INVALID_HANDLE), credits(0) {}
     Course(string id, string name, int cred)
-        : courseID(id), courseName(name), credits(cred) {
+        : courseID(Symbols::courses().intern(id)), courseName(name), credits(cred) {
     }
 
-    string getID() const { return courseID; }
+    Handle getHandle() const { return courseID; }
+    const string& getID() const { return Symbols::courses().name(courseID); }
     string getName() const { return courseName; }
     int getCredits() const { return credits; }
-    set<string> getPrerequisites() const { return prerequisites; }
+    IdSetView getPrerequisites() const { return IdSetView(prerequisites, Symbols::courses()); }
+    const HandleSet& getPrerequisiteHandles() const { return prerequisites; }
+    bool requiresCourse(const string& courseID) const { return getPrerequisites().contains(courseID); }
 
-    void addPrerequisite(const string& prereq) { prerequisites.insert(prereq); }
-    void setPrerequisites(const set<string>& prereqs) { prerequisites = prereqs; }
+    // The edits below return false, changing nothing, when the owning
+    // DataManager rejects them because they would close a prerequisite cycle.
+    bool addPrerequisite(const string& prereq) {
+        Handle h = Symbols::courses().intern(prereq);
+        if (listener && !prerequisites.contains(h)) {
+            HandleSet added;
+            added.insert(h);
+            if (!listener->acceptsPrerequisites(courseID, added)) return false;
+        }
+        prerequisites.insert(h);
+        if (listener) listener->onPrerequisitesChanged(courseID);
+        return true;
+    }
+    bool setPrerequisites(const set<string>& prereqs) {
+        HandleSet next;
+        for (const string& prereq : prereqs) {
+            next.insert(Symbols::courses().intern(prereq));
+        }
+        if (listener && !listener->acceptsPrerequisites(courseID, next)) return false;
+        prerequisites = next;
+        if (listener) listener->onPrerequisitesChanged(courseID);
+        return true;
+    }
+    void removePrerequisite(const string& prereq) {
+        if (prerequisites.erase(Symbols::courses().find(prereq)) && listener) listener->onPrerequisitesChanged(courseID);
+    }
 
-    bool operator<(const Course& other) const { return courseID < other.courseID; }
+    void attach(RecordListener* owner) { listener.attach(owner); }
+
+    bool operator<(const Course& other) const { return getID() < other.getID(); }
 };
 
 class Student {
 private:
-    string studentID;
+    Handle studentID;
     string name;
-    set<string> enrolledCourses; 
-    set<string> completedCourses; 
+    HandleSet enrolledCourses; 
+    HandleSet completedCourses; 
     int currentCredits;
+    ListenerLink listener;
 
 public:
-    Student() : currentCredits(0) {}
+    Student() : studentID(INVALID_HANDLE), currentCredits(0) {}
     Student(string id, string n)
-        : studentID(id), name(n), currentCredits(0) {
+        : studentID(Symbols::students().intern(id)), name(n), currentCredits(0) {
     }
 
-    string getID() const { return studentID; }
+    Handle getHandle() const { return studentID; }
+    const string& getID() const { return Symbols::students().name(studentID); }
     string getName() const { return name; }
-    set<string> getEnrolledCourses() const { return enrolledCourses; }
-    set<string> getCompletedCourses() const { return completedCourses; }
+    IdSetView getEnrolledCourses() const { return IdSetView(enrolledCourses, Symbols::courses()); }
+    IdSetView getCompletedCourses() const { return IdSetView(completedCourses, Symbols::courses()); }
+    const HandleSet& getEnrolledHandles() const { return enrolledCourses; }
+    const HandleSet& getCompletedHandles() const { return completedCourses; }
+    bool isEnrolled(const string& courseID) const { return getEnrolledCourses().contains(courseID); }
+    bool hasCompleted(const string& courseID) const { return getCompletedCourses().contains(courseID); }
     int getCurrentCredits() const { return currentCredits; }
 
-    void enrollCourse(const string& courseID, int credits) {
-        enrolledCourses.insert(courseID);
+    void enrollCourse(Handle course, int credits) {
+        enrolledCourses.insert(course);
         currentCredits += credits;
+        if (listener) listener->onEnroll(studentID, course, credits);
+    }
+    void enrollCourse(const string& courseID, int credits) {
+        enrollCourse(Symbols::courses().intern(courseID), credits);
     }
 
-    void completeCourse(const string& courseID, int credits) {
-        enrolledCourses.erase(courseID);
-        completedCourses.insert(courseID);
+    void completeCourse(Handle course, int credits) {
+        enrolledCourses.erase(course);
+        completedCourses.insert(course);
         currentCredits -= credits;
+        if (listener) listener->onComplete(studentID, course, credits);
+    }
+    void completeCourse(const string& courseID, int credits) {
+        Handle course = Symbols::courses().find(courseID);
+        if (course != INVALID_HANDLE) completeCourse(course, credits);
     }
 
-    void dropCourse(const string& courseID, int credits) {
-        enrolledCourses.erase(courseID);
+    void dropCourse(Handle course, int credits) {
+        enrolledCourses.erase(course);
         currentCredits -= credits;
+        if (listener) listener->onDrop(studentID, course, credits);
     }
+    void dropCourse(const string& courseID, int credits) {
+        Handle course = Symbols::courses().find(courseID);
+        if (course != INVALID_HANDLE) dropCourse(course, credits);
+    }
+
+    // Replaces enrollment state wholesale, e.g. when loading persisted records.
+    void restoreState(const HandleSet& enrolled, const HandleSet& completed, int credits) {
+        enrolledCourses = enrolled;
+        completedCourses = completed;
+        currentCredits = credits;
+    }
+
+    void attach(RecordListener* owner) { listener.attach(owner); }
 
-    bool operator<(const Student& other) const { return studentID < other.studentID; }
+    bool operator<(const Student& other) const { return getID() < other.getID(); }
 };
 
 class Faculty {
 private:
-    string facultyID;
+    Handle facultyID;
     string name;
-    set<string> assignedCourses; 
+    HandleSet assignedCourses; 
     int maxCourses;
+    ListenerLink listener;
 
 public:
-    Faculty() : maxCourses(3) {}
+    Faculty() : facultyID(INVALID_HANDLE), maxCourses(3) {}
     Faculty(string id, string n, int max = 3)
-        : facultyID(id), name(n), maxCourses(max) {
+        : facultyID(Symbols::faculty().intern(id)), name(n), maxCourses(max) {
     }
 
-    string getID() const { return facultyID; }
+    Handle getHandle() const { return facultyID; }
+    const string& getID() const { return Symbols::faculty().name(facultyID); }
     string getName() const { return name; }
-    set<string> getAssignedCourses() const { return assignedCourses; }
+    IdSetView getAssignedCourses() const { return IdSetView(assignedCourses, Symbols::courses()); }
+    const HandleSet& getAssignedHandles() const { return assignedCourses; }
+    bool teaches(const string& courseID) const { return getAssignedCourses().contains(courseID); }
     int getMaxCourses() const { return maxCourses; }
 
     bool canAssignCourse() const { return assignedCourses.size() < maxCourses; }
-    void assignCourse(const string& courseID) { assignedCourses.insert(courseID); }
-    void removeCourse(const string& courseID) { assignedCourses.erase(courseID); }
+    void assignCourse(const string& courseID) {
+        Handle course = Symbols::courses().intern(courseID);
+        assignedCourses.insert(course);
+        if (listener) listener->onAssign(facultyID, course);
+    }
+    void removeCourse(const string& courseID) {
+        Handle course = Symbols::courses().find(courseID);
+        if (course == INVALID_HANDLE) return;
+        assignedCourses.erase(course);
+        if (listener) listener->onUnassign(facultyID, course);
+    }
 
-    bool operator<(const Faculty& other) const { return facultyID < other.facultyID; }
+    void attach(RecordListener* owner) { listener.attach(owner); }
+
+    bool operator<(const Faculty& other) const { return getID() < other.getID(); }
 };
 
 class Room {
 private:
-    string roomID;
+    Handle roomID;
     int capacity;
     string type; 
 
 public:
-    Room() : capacity(0) {}
+    Room() : roomID(INVALID_HANDLE), capacity(0) {}
     Room(string id, int cap, string t)
-        : roomID(id), capacity(cap), type(t) {
+        : roomID(Symbols::rooms().intern(id)), capacity(cap), type(t) {
     }
 
-    string getID() const { return roomID; }
+    Handle getHandle() const { return roomID; }
+    const string& getID() const { return Symbols::rooms().name(roomID); }
     int getCapacity() const { return capacity; }
     string getType() const { return type; }
 
-    bool operator<(const Room& other) const { return roomID < other.roomID; }
+    bool operator<(const Room& other) const { return getID() < other.getID(); }
 };
 
 class Lab {
 private:
-    string labID;
-    string associatedCourse; 
+    Handle labID;
+    Handle associatedCourse; 
     int capacity;
-    set<string> enrolledStudents; 
+    HandleSet enrolledStudents; 
+    ListenerLink listener;
 
 public:
-    Lab() : capacity(0) {}
+    Lab() : labID(INVALID_HANDLE), associatedCourse(INVALID_HANDLE), capacity(0) {}
     Lab(string id, string course, int cap)
-        : labID(id), associatedCourse(course), capacity(cap) {
+        : labID(Symbols::labs().intern(id)), associatedCourse(Symbols::courses().intern(course)), capacity(cap) {
     }
 
-    string getID() const { return labID; }
-    string getAssociatedCourse() const { return associatedCourse; }
+    Handle getHandle() const { return labID; }
+    const string& getID() const { return Symbols::labs().name(labID); }
+    const string& getAssociatedCourse() const { return Symbols::courses().name(associatedCourse); }
+    Handle getAssociatedCourseHandle() const { return associatedCourse; }
     int getCapacity() const { return capacity; }
-    set<string> getEnrolledStudents() const { return enrolledStudents; }
+    IdSetView getEnrolledStudents() const { return IdSetView(enrolledStudents, Symbols::students()); }
+    const HandleSet& getEnrolledHandles() const { return enrolledStudents; }
+    bool hasStudent(const string& studentID) const { return getEnrolledStudents().contains(studentID); }
 
     bool canEnroll() const { return enrolledStudents.size() < capacity; }
-    void enrollStudent(const string& studentID) { enrolledStudents.insert(studentID); }
-    void removeStudent(const string& studentID) { enrolledStudents.erase(studentID); }
+    void enrollStudent(Handle student) {
+        enrolledStudents.insert(student);
+        if (listener) listener->onLabJoin(labID, student);
+    }
+    void enrollStudent(const string& studentID) { enrollStudent(Symbols::students().intern(studentID)); }
+    void removeStudent(Handle student) {
+        enrolledStudents.erase(student);
+        if (listener) listener->onLabLeave(labID, student);
+    }
+    void removeStudent(const string& studentID) {
+        Handle student = Symbols::students().find(studentID);
+        if (student != INVALID_HANDLE) removeStudent(student);
+    }
+
+    void attach(RecordListener* owner) { listener.attach(owner); }
 
-    bool operator<(const Lab& other) const { return labID < other.labID; }
+    bool operator<(const Lab& other) const { return getID() < other.getID(); }
 };
 
 
-class DataManager {
+template<typename T>
+inline void attachRecord(T& record, RecordListener* owner) {
+    if (owner) record.attach(owner);
+}
+inline void attachRecord(Room&, RecordListener*) {}
+
+// Dense storage for one entity kind, indexed by handle. Both tables are
+// copy-on-write, so a forked DataManager shares every record with its parent
+// until one side changes it. Iteration is read-only; change records through
+// the non-const get(), which gives this store its own copy first if the
+// record is shared. Plain lookups should use the const get(), which never
+// copies.
+template<typename T>
+class EntityStore {
+private:
+    PersistentVector<T> records; // insertion order
+    PersistentVector<int> slots; // handle -> index into records, -1 when absent
+    RecordListener* owner;
+
+public:
+    typedef typename PersistentVector<T>::const_iterator iterator;
+    typedef typename PersistentVector<T>::const_iterator const_iterator;
+
+    EntityStore() : owner(nullptr) {}
+
+    // Records handed out for writing are attached to `listener`.
+    void setOwner(RecordListener* listener) { owner = listener; }
+
+    T* put(const T& record) {
+        Handle h = record.getHandle();
+        if (h == INVALID_HANDLE) return nullptr;
+        slots.resize(h + 1, -1);
+        if (slots[h] >= 0) {
+            records.mutableAt(slots[h]) = record;
+        }
+        else {
+            slots.mutableAt(h) = (int)records.size();
+            records.push_back(record);
+        }
+        return get(h);
+    }
+
+    T* get(Handle h) {
+        if (!contains(h)) return nullptr;
+        T* record = &records.mutableAt(slots[h]);
+        attachRecord(*record, owner);
+        return record;
+    }
+    const T* get(Handle h) const {
+        return contains(h) ? &records[slots[h]] : nullptr;
+    }
+    bool contains(Handle h) const { return h < slots.size() && slots[h] >= 0; }
+
+    // Sizes the handle table once ahead of a bulk insert.
+    void reserveHandles(size_t count) { slots.resize(count, -1); }
+
+    // Takes private copies of all shared records, e.g. before concurrent writers.
+    void detach() {
+        records.detach();
+        slots.detach();
+        for (size_t i = 0; i < records.size(); i++) attachRecord(records.mutableAt(i), owner);
+    }
+
+    size_t size() const { return records.size(); }
+    bool empty() const { return records.empty(); }
+    void clear() {
+        records.clear();
+        slots.clear();
+    }
+
+    const_iterator begin() const { return records.begin(); }
+    const_iterator end() const { return records.end(); }
+};
+
+
+// Contiguous run of handles inside a column.
+class HandleRange {
+private:
+    const Handle* first;
+    const Handle* last;
+
+public:
+    HandleRange(const Handle* f, const Handle* l) : first(f), last(l) {}
+
+    const Handle* begin() const { return first; }
+    const Handle* end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    bool contains(Handle h) const { return binary_search(first, last, h); }
+};
+
+// Intersection of any number of sorted handle lists. Lists are visited
+// smallest first: each handle of the smallest is looked up in the others by
+// galloping (doubling the step from the last position, then binary search),
+// and a miss skips the smallest list ahead to the value found instead. The
+// cost follows the smallest list, and an empty or exhausted list ends the
+// work at once.
+struct SortedIntersection {
+    // First position in [first, last) not less than target.
+    static const Handle* gallop(const Handle* first, const Handle* last, Handle target) {
+        if (first == last || *first >= target) return first;
+        const Handle* lo = first;
+        size_t step = 1;
+        while ((size_t)(last - lo) > step && lo[step] < target) {
+            lo += step;
+            step <<= 1;
+        }
+        const Handle* hi = (size_t)(last - lo) > step ? lo + step : last;
+        return lower_bound(lo + 1, hi, target);
+    }
+
+    template<typename F>
+    static void forEach(vector<HandleRange> lists, F fn) {
+        if (lists.empty()) return;
+        sort(lists.begin(), lists.end(), [](const HandleRange& a, const HandleRange& b) { return a.size() < b.size(); });
+
+        vector<const Handle*> at(lists.size());
+        for (size_t i = 0; i < lists.size(); i++) at[i] = lists[i].begin();
+
+        const Handle* candidate = lists[0].begin();
+        const Handle* candidates = lists[0].end();
+        while (candidate != candidates) {
+            Handle target = *candidate;
+            bool everywhere = true;
+            for (size_t i = 1; i < lists.size(); i++) {
+                at[i] = gallop(at[i], lists[i].end(), target);
+                if (at[i] == lists[i].end()) return;
+                if (*at[i] != target) {
+                    candidate = gallop(candidate, candidates, *at[i]);
+                    everywhere = false;
+                    break;
+                }
+            }
+            if (everywhere) {
+                fn(target);
+                ++candidate;
+            }
+        }
+    }
+
+    static vector<Handle> all(const vector<HandleRange>& lists) {
+        vector<Handle> result;
+        forEach(lists, [&](Handle h) { result.push_back(h); });
+        return result;
+    }
+
+    static size_t count(const vector<HandleRange>& lists) {
+        size_t total = 0;
+        forEach(lists, [&](Handle) { total++; });
+        return total;
+    }
+};
+
+// Struct-of-arrays copy of the student and course records, rows in ID order.
+// Hot fields (credits, enrollment/completion/prerequisite lists as offsets into
+// flat handle columns) are contiguous; names live in separate cold pools, so
+// full-population passes stream through memory instead of visiting records.
+//
+// Students are stored in chunks of CHUNK_ROWS rows and courses and faculty as
+// one section each, all immutable and held by shared_ptr. Copying the columns
+// shares every chunk and section, and refreshStudents() rebuilds only the
+// chunks holding the students it is given, so a new version built from the
+// previous one costs about what changed since.
+class CatalogColumns {
 private:
-    static DataManager* instance;
+    static const size_t CHUNK_SHIFT = 8;
+    static const size_t CHUNK_ROWS = (size_t)1 << CHUNK_SHIFT;
 
-    map<string, Course> courses;
-    map<string, Student> students;
-    map<string, Faculty> faculty;
-    map<string, Room> rooms;
-    map<string, Lab> labs;
+    struct StudentChunk {
+        vector<Handle> handles;
+        vector<int> credits;
+        vector<uint32_t> enrolledOffsets;  // rows + 1 offsets into enrolledColumn
+        vector<Handle> enrolledColumn;
+        vector<uint32_t> completedOffsets; // rows + 1 offsets into completedColumn
+        vector<Handle> completedColumn;
+        vector<uint32_t> nameOffsets;
+        string namePool;
+    };
 
-    DataManager() {} 
+    struct CourseSection {
+        vector<Handle> handles;
+        vector<int> credits;
+        vector<uint32_t> prereqOffsets;    // rows + 1 offsets into prereqColumn
+        vector<Handle> prereqColumn;
+        vector<uint32_t> nameOffsets;
+        string namePool;
+        vector<uint32_t> rowOf;            // course handle -> row, NO_ROW if absent
+    };
+
+    struct FacultySection {
+        vector<Handle> handles;
+        vector<uint32_t> assignedOffsets;  // rows + 1 offsets into assignedColumn
+        vector<Handle> assignedColumn;
+    };
+
+    size_t studentRows;
+    vector<shared_ptr<const StudentChunk>> studentChunks;
+    HandleMap rowOfStudent; // student handle -> row, NO_ROW if absent
+    shared_ptr<const CourseSection> courseSection;
+    shared_ptr<const FacultySection> facultySection;
+
+    static void appendHandles(vector<Handle>& column, vector<uint32_t>& offsets, const HandleSet& set) {
+        column.insert(column.end(), set.begin(), set.end());
+        offsets.push_back((uint32_t)column.size());
+    }
+
+    static void appendName(string& pool, vector<uint32_t>& offsets, const string& name) {
+        pool.append(name);
+        offsets.push_back((uint32_t)pool.size());
+    }
+
+    template<typename T>
+    static vector<const T*> sortedByID(const EntityStore<T>& store, const SymbolTable& table) {
+        vector<const T*> rows;
+        rows.reserve(store.size());
+        for (const T& record : store) rows.push_back(&record);
+        sort(rows.begin(), rows.end(), [&](const T* a, const T* b) {
+            return table.name(a->getHandle()) < table.name(b->getHandle());
+        });
+        return rows;
+    }
+
+    static void indexRows(vector<uint32_t>& rows, const vector<Handle>& handles, size_t firstRow) {
+        for (size_t i = 0; i < handles.size(); i++) {
+            if (handles[i] >= rows.size()) rows.resize(handles[i] + 1, NO_ROW);
+            rows[handles[i]] = (uint32_t)(firstRow + i);
+        }
+    }
+
+    static size_t rowOf(const vector<uint32_t>& rows, Handle h) {
+        return h < rows.size() ? rows[h] : NO_ROW;
+    }
+
+    static shared_ptr<const StudentChunk> buildChunk(const EntityStore<Student>& students, const Handle* handles, size_t count) {
+        shared_ptr<StudentChunk> chunk = make_shared<StudentChunk>();
+        chunk->handles.assign(handles, handles + count);
+        chunk->credits.reserve(count);
+        chunk->enrolledOffsets.assign(1, 0);
+        chunk->completedOffsets.assign(1, 0);
+        chunk->nameOffsets.assign(1, 0);
+        for (size_t i = 0; i < count; i++) {
+            const Student* student = students.get(handles[i]);
+            chunk->credits.push_back(student->getCurrentCredits());
+            appendHandles(chunk->enrolledColumn, chunk->enrolledOffsets, student->getEnrolledHandles());
+            appendHandles(chunk->completedColumn, chunk->completedOffsets, student->getCompletedHandles());
+            appendName(chunk->namePool, chunk->nameOffsets, student->getName());
+        }
+        return chunk;
+    }
+
+    const StudentChunk& chunkOf(size_t row) const { return *studentChunks[row >> CHUNK_SHIFT]; }
 
 public:
-    static DataManager* getInstance() {
-        if (!instance) {
-            instance = new DataManager();
+    enum : uint32_t { NO_ROW = 0xFFFFFFFFu };
+
+    CatalogColumns() { clear(); }
+
+    // Re-sorts and rebuilds every section.
+    void rebuild(const EntityStore<Student>& students, const EntityStore<Course>& courses,
+        const EntityStore<Faculty>& faculty) {
+        rebuildStudents(students);
+        rebuildCourses(courses);
+        rebuildFaculty(faculty);
+    }
+
+    // Needed when students were added or removed: rows are re-sorted.
+    void rebuildStudents(const EntityStore<Student>& students) {
+        vector<Handle> handles;
+        handles.reserve(students.size());
+        for (const Student* student : sortedByID(students, Symbols::students())) handles.push_back(student->getHandle());
+
+        studentRows = handles.size();
+        studentChunks.clear();
+        for (size_t first = 0; first < handles.size(); first += CHUNK_ROWS) {
+            studentChunks.push_back(buildChunk(students, handles.data() + first, min(CHUNK_ROWS, handles.size() - first)));
+        }
+        rowOfStudent.clear();
+        for (size_t i = 0; i < handles.size(); i++) rowOfStudent.put(handles[i], (uint32_t)i);
+    }
+
+    // Splices students that have no row yet into the ID order. Chunks before
+    // the first insertion point are kept; the rest are re-chunked from the
+    // merged order, without sorting the existing rows again.
+    void insertStudents(const EntityStore<Student>& students, vector<Handle> added) {
+        const SymbolTable& table = Symbols::students();
+        sort(added.begin(), added.end(), [&](Handle a, Handle b) { return table.name(a) < table.name(b); });
+        if (added.empty()) return;
+
+        size_t low = 0, high = studentRows;
+        const string& smallest = table.name(added[0]);
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (studentID(mid) < smallest) low = mid + 1;
+            else high = mid;
         }
-        return instance;
+        size_t firstChunk = low >> CHUNK_SHIFT;
+        size_t from = firstChunk << CHUNK_SHIFT;
+
+        vector<Handle> tail;
+        tail.reserve(studentRows - from + added.size());
+        size_t row = from, next = 0;
+        while (row < studentRows || next < added.size()) {
+            if (next < added.size() && (row == studentRows || table.name(added[next]) < studentID(row))) tail.push_back(added[next++]);
+            else tail.push_back(studentHandle(row++));
+        }
+
+        studentChunks.resize(firstChunk);
+        for (size_t first = 0; first < tail.size(); first += CHUNK_ROWS) {
+            studentChunks.push_back(buildChunk(students, tail.data() + first, min(CHUNK_ROWS, tail.size() - first)));
+        }
+        for (size_t i = 0; i < tail.size(); i++) rowOfStudent.put(tail[i], (uint32_t)(from + i));
+        studentRows = from + tail.size();
+    }
+
+    // Rebuilds the chunks holding `changed`, which must all already have rows.
+    void refreshStudents(const EntityStore<Student>& students, const vector<Handle>& changed) {
+        vector<size_t> chunks;
+        for (Handle h : changed) {
+            size_t row = studentRow(h);
+            if (row != NO_ROW) chunks.push_back(row >> CHUNK_SHIFT);
+        }
+        sort(chunks.begin(), chunks.end());
+        chunks.erase(unique(chunks.begin(), chunks.end()), chunks.end());
+        for (size_t c : chunks) {
+            const vector<Handle>& handles = studentChunks[c]->handles;
+            studentChunks[c] = buildChunk(students, handles.data(), handles.size());
+        }
+    }
+
+    void rebuildCourses(const EntityStore<Course>& courses) {
+        shared_ptr<CourseSection> section = make_shared<CourseSection>();
+        vector<const Course*> courseRows = sortedByID(courses, Symbols::courses());
+        section->handles.reserve(courseRows.size());
+        section->credits.reserve(courseRows.size());
+        section->prereqOffsets.assign(1, 0);
+        section->nameOffsets.assign(1, 0);
+        for (const Course* course : courseRows) {
+            section->handles.push_back(course->getHandle());
+            section->credits.push_back(course->getCredits());
+            appendHandles(section->prereqColumn, section->prereqOffsets, course->getPrerequisiteHandles());
+            appendName(section->namePool, section->nameOffsets, course->getName());
+        }
+        indexRows(section->rowOf, section->handles, 0);
+        courseSection = section;
+    }
+
+    void rebuildFaculty(const EntityStore<Faculty>& faculty) {
+        shared_ptr<FacultySection> section = make_shared<FacultySection>();
+        section->assignedOffsets.assign(1, 0);
+        for (const Faculty* fac : sortedByID(faculty, Symbols::faculty())) {
+            section->handles.push_back(fac->getHandle());
+            appendHandles(section->assignedColumn, section->assignedOffsets, fac->getAssignedHandles());
+        }
+        facultySection = section;
+    }
+
+    void clear() {
+        studentRows = 0;
+        studentChunks.clear();
+        rowOfStudent.clear();
+        shared_ptr<CourseSection> courses = make_shared<CourseSection>();
+        courses->prereqOffsets.assign(1, 0);
+        courses->nameOffsets.assign(1, 0);
+        courseSection = courses;
+        shared_ptr<FacultySection> fac = make_shared<FacultySection>();
+        fac->assignedOffsets.assign(1, 0);
+        facultySection = fac;
+    }
+
+    size_t studentCount() const { return studentRows; }
+    size_t studentRow(Handle h) const { return rowOfStudent.get(h); }
+    Handle studentHandle(size_t row) const { return chunkOf(row).handles[row & (CHUNK_ROWS - 1)]; }
+    const string& studentID(size_t row) const { return Symbols::students().name(studentHandle(row)); }
+    int studentCreditsAt(size_t row) const { return chunkOf(row).credits[row & (CHUNK_ROWS - 1)]; }
+    HandleRange enrolled(size_t row) const {
+        const StudentChunk& chunk = chunkOf(row);
+        size_t i = row & (CHUNK_ROWS - 1);
+        return HandleRange(chunk.enrolledColumn.data() + chunk.enrolledOffsets[i], chunk.enrolledColumn.data() + chunk.enrolledOffsets[i + 1]);
+    }
+    HandleRange completed(size_t row) const {
+        const StudentChunk& chunk = chunkOf(row);
+        size_t i = row & (CHUNK_ROWS - 1);
+        return HandleRange(chunk.completedColumn.data() + chunk.completedOffsets[i], chunk.completedColumn.data() + chunk.completedOffsets[i + 1]);
+    }
+    string studentName(size_t row) const {
+        const StudentChunk& chunk = chunkOf(row);
+        size_t i = row & (CHUNK_ROWS - 1);
+        return chunk.namePool.substr(chunk.nameOffsets[i], chunk.nameOffsets[i + 1] - chunk.nameOffsets[i]);
+    }
+
+    size_t courseCount() const { return courseSection->handles.size(); }
+    size_t courseRow(Handle h) const { return rowOf(courseSection->rowOf, h); }
+    Handle courseHandle(size_t row) const { return courseSection->handles[row]; }
+    const string& courseID(size_t row) const { return Symbols::courses().name(courseSection->handles[row]); }
+    int courseCreditsAt(size_t row) const { return courseSection->credits[row]; }
+    HandleRange prerequisites(size_t row) const {
+        const CourseSection& section = *courseSection;
+        return HandleRange(section.prereqColumn.data() + section.prereqOffsets[row], section.prereqColumn.data() + section.prereqOffsets[row + 1]);
+    }
+    string courseName(size_t row) const {
+        const CourseSection& section = *courseSection;
+        return section.namePool.substr(section.nameOffsets[row], section.nameOffsets[row + 1] - section.nameOffsets[row]);
+    }
+
+    size_t facultyCount() const { return facultySection->handles.size(); }
+    Handle facultyHandle(size_t row) const { return facultySection->handles[row]; }
+    const string& facultyID(size_t row) const { return Symbols::faculty().name(facultySection->handles[row]); }
+    HandleRange assigned(size_t row) const {
+        const FacultySection& section = *facultySection;
+        return HandleRange(section.assignedColumn.data() + section.assignedOffsets[row], section.assignedColumn.data() + section.assignedOffsets[row + 1]);
+    }
+};
+
+// One immutable, published state of the catalog: the columns plus a copy of
+// the enrollment bit matrices, taken together so they always agree. Readers
+// hold it through a shared_ptr for as long as they like; writers never touch
+// it, they publish a successor instead.
+struct CatalogVersion {
+    uint64_t number;
+    CatalogColumns columns;
+    EnrollmentBits bits;
+
+    CatalogVersion() : number(0) {}
+};
+
+// Answers "would these prerequisites close a cycle?" from the course records
+// alone, for when no up-to-date closure is at hand (inside a batch, or while a
+// catalog is being built). Visited marks are stamped rather than cleared, so a
+// check costs only the prerequisites it reaches.
+class PrerequisiteWalk {
+private:
+    vector<uint32_t> mark;
+    uint32_t stamp;
+
+public:
+    PrerequisiteWalk() : stamp(0) {}
+
+    bool closesCycle(const EntityStore<Course>& courses, Handle course, const HandleSet& prereqs) {
+        if (++stamp == 0) {
+            fill(mark.begin(), mark.end(), 0);
+            stamp = 1;
+        }
+        if (mark.size() < Symbols::courses().size()) mark.resize(Symbols::courses().size(), 0);
+
+        vector<Handle> stack(prereqs.begin(), prereqs.end());
+        while (!stack.empty()) {
+            Handle c = stack.back();
+            stack.pop_back();
+            if (c == course) return true;
+            if (c >= mark.size() || mark[c] == stamp) continue;
+            mark[c] = stamp;
+            const Course* record = courses.get(c);
+            if (record) stack.insert(stack.end(), record->getPrerequisiteHandles().begin(), record->getPrerequisiteHandles().end());
+        }
+        return false;
+    }
+};
+
+// Immutable set of courses and their prerequisites that several DataManagers
+// (one per term or campus) can start from. Each manager shares the catalog's
+// records and prerequisite bits and copies only the courses it changes, so
+// the catalog itself never changes and can be used from any thread. Records
+// whose prerequisites would close a cycle with earlier ones are left out.
+class CourseCatalog {
+private:
+    friend class DataManager;
+
+    EntityStore<Course> courses;
+    EnrollmentBits prerequisiteBits;
+
+public:
+    explicit CourseCatalog(const vector<Course>& records) {
+        PrerequisiteWalk walk;
+        for (const Course& course : records) {
+            if (walk.closesCycle(courses, course.getHandle(), course.getPrerequisiteHandles())) continue;
+            courses.put(course);
+            prerequisiteBits.setPrerequisites(course.getHandle(), course.getPrerequisiteHandles(), false);
+        }
+        prerequisiteBits.closePrerequisites();
+    }
+
+    size_t size() const { return courses.size(); }
+    const Course* getCourse(Handle h) const { return courses.get(h); }
+    const Course* getCourse(const string& id) const { return courses.get(Symbols::courses().find(id)); }
+    const EntityStore<Course>& getAllCourses() const { return courses; }
+};
+
+// One self-contained dataset, e.g. a term or a campus. Modules are handed the
+// manager they work on, and any number of managers can be alive and in use on
+// different threads at once.
+class DataManager : private RecordListener {
+private:
+    shared_ptr<const CourseCatalog> catalog;
+
+    EntityStore<Course> courses;
+    EntityStore<Student> students;
+    EntityStore<Faculty> faculty;
+    EntityStore<Room> rooms;
+    EntityStore<Lab> labs;
+
+    // Inverted indexes keyed by course handle; copy-on-write like the stores.
+    typedef PersistentVector<HandleSet> CourseIndex;
+    CourseIndex enrolledByCourse;
+    CourseIndex completedByCourse;
+    CourseIndex facultyByCourse;
+    CourseIndex labsByCourse;
+
+    EnrollmentBits bits;
+
+    vector<MutationObserver*> observers;
+
+    // Latest published catalog version, swapped with atomic_store/atomic_load.
+    // Readers only ever load it. A change made outside a batch or hold only
+    // marks it stale, and the next snapshot() publishes the successor, so a
+    // run of single-record changes costs one publish. A successor is built
+    // from this version plus what changed since: whole sections when courses
+    // or faculty changed or a batch rebuilt everything, spliced rows for added
+    // students, otherwise just the student chunks and bit blocks written.
+    shared_ptr<const CatalogVersion> published;
+    mutex publishLock;
+    uint64_t versionCounter;
+    int publishHolds;
+    atomic<bool> unpublished;
+    vector<Handle> addedStudents; // added outside a batch since the last publish
+    atomic<bool> studentSetChanged;
+    atomic<bool> coursesChanged;
+    atomic<bool> facultyChanged;
+
+    // Guards the per-course index entries (roster sets and roster bit rows),
+    // which students registering concurrently would otherwise share, and
+    // collects the students whose enrollments changed under that lock.
+    struct CourseStripe {
+        mutex lock;
+        vector<Handle> changedStudents;
+        char pad[64];
+    };
+    static const size_t COURSE_STRIPES = 64;
+    CourseStripe courseStripes[COURSE_STRIPES];
+
+    CourseStripe& courseStripe(Handle course) { return courseStripes[course % COURSE_STRIPES]; }
+
+    // While a batch is open the inverted indexes and bit matrices are left
+    // alone and rebuilt once when the outermost batch ends.
+    int batchDepth;
+    PrerequisiteWalk batchWalk;
+
+    static HandleSet& slot(CourseIndex& index, Handle course) {
+        if (course >= index.size()) {
+            index.resize(course + 1, HandleSet());
+        }
+        return index.mutableAt(course);
+    }
+
+    static void load(CourseIndex& index, const vector<HandleSet>& built) {
+        index.clear();
+        for (const HandleSet& set : built) index.push_back(set);
+    }
+
+    static const HandleSet& lookup(const CourseIndex& index, Handle course) {
+        static const HandleSet empty;
+        return course < index.size() ? index[course] : empty;
+    }
+
+    void indexStudent(const Student& student, bool add) {
+        if (batchDepth) return;
+        Handle h = student.getHandle();
+        if (add) bits.addStudent(h);
+        for (Handle course : student.getEnrolledHandles()) {
+            if (add) {
+                slot(enrolledByCourse, course).insert(h);
+                bits.enroll(h, course);
+            }
+            else {
+                slot(enrolledByCourse, course).erase(h);
+                bits.drop(h, course);
+            }
+        }
+        for (Handle course : student.getCompletedHandles()) {
+            if (add) {
+                slot(completedByCourse, course).insert(h);
+                bits.complete(h, course);
+            }
+            else {
+                slot(completedByCourse, course).erase(h);
+                bits.uncomplete(h, course);
+            }
+        }
+    }
+
+    void indexFaculty(const Faculty& fac, bool add) {
+        if (batchDepth) return;
+        for (Handle course : fac.getAssignedHandles()) {
+            if (add) slot(facultyByCourse, course).insert(fac.getHandle());
+            else slot(facultyByCourse, course).erase(fac.getHandle());
+        }
+    }
+
+    void onEnroll(Handle student, Handle course, int credits) {
+        if (!batchDepth) {
+            CourseStripe& stripe = courseStripe(course);
+            lock_guard<mutex> guard(stripe.lock);
+            slot(enrolledByCourse, course).insert(student);
+            bits.enroll(student, course);
+            stripe.changedStudents.push_back(student);
+        }
+        publishChange();
+        for (MutationObserver* o : observers) o->onEnrolled(student, course, credits);
+    }
+
+    void onComplete(Handle student, Handle course, int credits) {
+        if (!batchDepth) {
+            CourseStripe& stripe = courseStripe(course);
+            lock_guard<mutex> guard(stripe.lock);
+            slot(enrolledByCourse, course).erase(student);
+            slot(completedByCourse, course).insert(student);
+            bits.complete(student, course);
+            stripe.changedStudents.push_back(student);
+        }
+        publishChange();
+        for (MutationObserver* o : observers) o->onCompleted(student, course, credits);
+    }
+
+    void onDrop(Handle student, Handle course, int credits) {
+        if (!batchDepth) {
+            CourseStripe& stripe = courseStripe(course);
+            lock_guard<mutex> guard(stripe.lock);
+            slot(enrolledByCourse, course).erase(student);
+            bits.drop(student, course);
+            stripe.changedStudents.push_back(student);
+        }
+        publishChange();
+        for (MutationObserver* o : observers) o->onDropped(student, course, credits);
+    }
+
+    void onAssign(Handle fac, Handle course) {
+        if (!batchDepth) {
+            lock_guard<mutex> guard(courseStripe(course).lock);
+            slot(facultyByCourse, course).insert(fac);
+        }
+        facultyChanged = true;
+        publishChange();
+        for (MutationObserver* o : observers) o->onAssigned(fac, course);
+    }
+
+    void onUnassign(Handle fac, Handle course) {
+        if (!batchDepth) {
+            lock_guard<mutex> guard(courseStripe(course).lock);
+            slot(facultyByCourse, course).erase(fac);
+        }
+        facultyChanged = true;
+        publishChange();
+        for (MutationObserver* o : observers) o->onUnassigned(fac, course);
+    }
+
+    void onPrerequisitesChanged(Handle course) {
+        const Course* stored = courses.get(course);
+        if (!stored) return;
+        if (!batchDepth) bits.setPrerequisites(course, stored->getPrerequisiteHandles());
+        coursesChanged = true;
+        publishChange();
+        for (MutationObserver* o : observers) o->onPrerequisitesUpdated(*stored);
+    }
+
+    bool acceptsPrerequisites(Handle course, const HandleSet& prereqs) {
+        if (!batchDepth) return !bits.createsCycle(course, prereqs);
+        // The closure is stale until the batch ends; walk the records instead.
+        return !batchWalk.closesCycle(courses, course, prereqs);
+    }
+
+    void onLabJoin(Handle lab, Handle student) {
+        for (MutationObserver* o : observers) o->onLabJoined(lab, student);
+    }
+
+    void onLabLeave(Handle lab, Handle student) {
+        for (MutationObserver* o : observers) o->onLabLeft(lab, student);
+    }
+
+    // Records handed out for writing report their changes to this manager.
+    void adoptStores() {
+        courses.setOwner(this);
+        students.setOwner(this);
+        faculty.setOwner(this);
+        rooms.setOwner(this);
+        labs.setOwner(this);
+    }
+
+    template<typename T>
+    static vector<const T*> inHandleOrder(const EntityStore<T>& store) {
+        vector<const T*> records;
+        records.reserve(store.size());
+        for (const T& record : store) records.push_back(&record);
+        sort(records.begin(), records.end(), [](const T* a, const T* b) {
+            return a->getHandle() < b->getHandle();
+        });
+        return records;
+    }
+
+    // Recomputes every derived index from the records in one pass. Owners are
+    // visited in handle order, so each index list is built by appending.
+    void rebuildIndexes() {
+        size_t courseSlots = Symbols::courses().size();
+        vector<HandleSet> enrolledBuilt(courseSlots), completedBuilt(courseSlots);
+        vector<HandleSet> facultyBuilt(courseSlots), labsBuilt(courseSlots);
+        bits.clear();
+
+        for (const Course* course : inHandleOrder(courses)) {
+            bits.setPrerequisites(course->getHandle(), course->getPrerequisiteHandles(), false);
+        }
+        bits.closePrerequisites();
+        for (const Student* student : inHandleOrder(students)) {
+            Handle h = student->getHandle();
+            bits.addStudent(h);
+            for (Handle course : student->getEnrolledHandles()) {
+                enrolledBuilt[course].appendSorted(h);
+                bits.enroll(h, course);
+            }
+            for (Handle course : student->getCompletedHandles()) {
+                completedBuilt[course].appendSorted(h);
+                bits.complete(h, course);
+            }
+        }
+        for (const Faculty* fac : inHandleOrder(faculty)) {
+            for (Handle course : fac->getAssignedHandles()) {
+                facultyBuilt[course].appendSorted(fac->getHandle());
+            }
+        }
+        for (const Lab* lab : inHandleOrder(labs)) {
+            Handle course = lab->getAssociatedCourseHandle();
+            if (course < courseSlots) labsBuilt[course].appendSorted(lab->getHandle());
+        }
+        load(enrolledByCourse, enrolledBuilt);
+        load(completedByCourse, completedBuilt);
+        load(facultyByCourse, facultyBuilt);
+        load(labsByCourse, labsBuilt);
+        markAllChanged();
+    }
+
+    void markAllChanged() {
+        studentSetChanged = true;
+        coursesChanged = true;
+        facultyChanged = true;
+    }
+
+    // Marks a change made outside a batch for the next snapshot() to publish,
+    // unless publishing is held.
+    void publishChange() {
+        if (!batchDepth && !publishHolds) unpublished = true;
+    }
+
+    // Body of publish(); the caller holds publishLock.
+    shared_ptr<const CatalogVersion> publishLocked() {
+        unpublished = false;
+        shared_ptr<const CatalogVersion> previous = atomic_load(&published);
+        shared_ptr<CatalogVersion> next = make_shared<CatalogVersion>();
+        next->number = ++versionCounter;
+        if (previous) next->columns = previous->columns; // shares every chunk and section
+
+        vector<Handle> changedStudents;
+        for (CourseStripe& stripe : courseStripes) {
+            lock_guard<mutex> stripeGuard(stripe.lock);
+            changedStudents.insert(changedStudents.end(), stripe.changedStudents.begin(), stripe.changedStudents.end());
+            stripe.changedStudents.clear();
+        }
+        if (!previous || studentSetChanged.exchange(false)) {
+            next->columns.rebuildStudents(students);
+        }
+        else {
+            next->columns.insertStudents(students, addedStudents);
+            if (!changedStudents.empty()) next->columns.refreshStudents(students, changedStudents);
+        }
+        addedStudents.clear();
+        if (!previous || coursesChanged.exchange(false)) next->columns.rebuildCourses(courses);
+        if (!previous || facultyChanged.exchange(false)) next->columns.rebuildFaculty(faculty);
+        next->bits = bits.freeze(previous ? &previous->bits : nullptr);
+
+        shared_ptr<const CatalogVersion> frozen = next;
+        atomic_store(&published, frozen);
+        return frozen;
+    }
+
+public:
+    // One enrollment-state change for applyEnrollments().
+    struct EnrollmentChange {
+        enum Kind { ENROLL, COMPLETE, DROP };
+
+        Handle student;
+        Handle course;
+        int credits;
+        Kind kind;
+
+        EnrollmentChange(Handle s, Handle c, int cred, Kind k) : student(s), course(c), credits(cred), kind(k) {}
+    };
+
+    // Outcome of a batch call: how many items were applied, and the batch
+    // index and reason for every item that was not.
+    struct BatchResult {
+        size_t applied;
+        vector<pair<size_t, string>> rejected;
+
+        BatchResult() : applied(0) {}
+    };
+
+    DataManager()
+        : versionCounter(0), publishHolds(0), unpublished(false), studentSetChanged(true), coursesChanged(true),
+        facultyChanged(true), batchDepth(0) {
+        adoptStores();
+        publish();
+    }
+
+    // Starts with every course of a shared catalog. Courses added or changed
+    // here stay private to this manager.
+    explicit DataManager(shared_ptr<const CourseCatalog> shared)
+        : catalog(shared), courses(shared->courses), bits(shared->prerequisiteBits),
+        versionCounter(0), publishHolds(0), unpublished(false), studentSetChanged(true), coursesChanged(true),
+        facultyChanged(true), batchDepth(0) {
+        adoptStores();
+        publish();
+    }
+
+    // The catalog this manager started from, if any.
+    shared_ptr<const CourseCatalog> getCatalog() const { return catalog; }
+
+    // Captures this manager's current courses as a catalog other managers can share.
+    shared_ptr<const CourseCatalog> exportCatalog() const {
+        vector<Course> records(courses.begin(), courses.end());
+        return make_shared<const CourseCatalog>(records);
+    }
+
+    // What-if copy: shares every record, index and bit row with this manager
+    // and copies only what either side changes afterwards, so forking is cheap
+    // and each later change costs O(log n). The copy starts from this
+    // manager's published version and publishes its own from there; observers
+    // are not carried over. Not to be called while writers are active.
+    //
+    // Record pointers taken from either side before the fork must be fetched
+    // again afterwards: they point at the shared copy, so a write through one
+    // would reach both managers and is lost once the owner copies the record.
+    unique_ptr<DataManager> fork() const {
+        unique_ptr<DataManager> copy(new DataManager());
+        copy->catalog = catalog;
+        copy->courses = courses;
+        copy->students = students;
+        copy->faculty = faculty;
+        copy->rooms = rooms;
+        copy->labs = labs;
+        copy->adoptStores();
+        copy->enrolledByCourse = enrolledByCourse;
+        copy->completedByCourse = completedByCourse;
+        copy->facultyByCourse = facultyByCourse;
+        copy->labsByCourse = labsByCourse;
+        copy->bits = bits;
+        copy->published = atomic_load(&published);
+        copy->versionCounter = versionCounter;
+        copy->addedStudents = addedStudents;
+        copy->studentSetChanged = studentSetChanged.load();
+        copy->coursesChanged = coursesChanged.load();
+        copy->facultyChanged = facultyChanged.load();
+        for (size_t i = 0; i < COURSE_STRIPES; i++) copy->courseStripes[i].changedStudents = courseStripes[i].changedStudents;
+        if (batchDepth) copy->rebuildIndexes(); // ours are stale until the batch ends
+        copy->publish();
+        return copy;
     }
 
     
-    void addCourse(const Course& course) { courses[course.getID()] = course; }
-    Course* getCourse(const string& id) {
-        return courses.find(id) != courses.end() ? &courses[id] : nullptr;
+    // Read-only access to this manager. Lookups through it use the const
+    // getters, which never copy a record shared with a fork.
+    const DataManager& view() const { return *this; }
+
+    // Adds or replaces a course. Refused (false) when its prerequisites would
+    // close a cycle, e.g. one of them already requires it.
+    bool addCourse(const Course& course) {
+        if (course.getHandle() == INVALID_HANDLE) return false;
+        if (!acceptsPrerequisites(course.getHandle(), course.getPrerequisiteHandles())) return false;
+        Course* stored = courses.put(course);
+        stored->attach(this);
+        if (!batchDepth) bits.setPrerequisites(stored->getHandle(), stored->getPrerequisiteHandles());
+        coursesChanged = true;
+        publishChange();
+        for (MutationObserver* o : observers) o->onCourseAdded(*stored);
+        return true;
     }
-    map<string, Course>& getAllCourses() { return courses; }
-    bool courseExists(const string& id) { return courses.find(id) != courses.end(); }
+    Course* getCourse(const string& id) { return courses.get(Symbols::courses().find(id)); }
+    Course* getCourse(Handle h) { return courses.get(h); }
+    const Course* getCourse(const string& id) const { return courses.get(Symbols::courses().find(id)); }
+    const Course* getCourse(Handle h) const { return courses.get(h); }
+    EntityStore<Course>& getAllCourses() { return courses; }
+    const EntityStore<Course>& getAllCourses() const { return courses; }
+    bool courseExists(const string& id) const { return courses.contains(Symbols::courses().find(id)); }
 
     
-    void addStudent(const Student& student) { students[student.getID()] = student; }
-    Student* getStudent(const string& id) {
-        return students.find(id) != students.end() ? &students[id] : nullptr;
+    void addStudent(const Student& student) {
+        const Student* previous = students.get(student.getHandle());
+        if (previous) indexStudent(*previous, false);
+
+        Student* stored = students.put(student);
+        if (!stored) return;
+        stored->attach(this);
+        indexStudent(*stored, true);
+        if (!previous) {
+            if (batchDepth) studentSetChanged = true;
+            else addedStudents.push_back(stored->getHandle());
+        }
+        else {
+            lock_guard<mutex> guard(courseStripes[0].lock);
+            courseStripes[0].changedStudents.push_back(stored->getHandle());
+        }
+        publishChange();
+        for (MutationObserver* o : observers) o->onStudentAdded(*stored);
     }
-    map<string, Student>& getAllStudents() { return students; }
-    bool studentExists(const string& id) { return students.find(id) != students.end(); }
+    Student* getStudent(const string& id) { return students.get(Symbols::students().find(id)); }
+    Student* getStudent(Handle h) { return students.get(h); }
+    const Student* getStudent(const string& id) const { return students.get(Symbols::students().find(id)); }
+    const Student* getStudent(Handle h) const { return students.get(h); }
+    EntityStore<Student>& getAllStudents() { return students; }
+    const EntityStore<Student>& getAllStudents() const { return students; }
+    bool studentExists(const string& id) const { return students.contains(Symbols::students().find(id)); }
 
-    void addFaculty(const Faculty& fac) { faculty[fac.getID()] = fac; }
-    Faculty* getFaculty(const string& id) {
-        return faculty.find(id) != faculty.end() ? &faculty[id] : nullptr;
+    void addFaculty(const Faculty& fac) {
+        const Faculty* previous = faculty.get(fac.getHandle());
+        if (previous) indexFaculty(*previous, false);
+
+        Faculty* stored = faculty.put(fac);
+        if (!stored) return;
+        stored->attach(this);
+        indexFaculty(*stored, true);
+        facultyChanged = true;
+        publishChange();
+        for (MutationObserver* o : observers) o->onFacultyAdded(*stored);
+    }
+    Faculty* getFaculty(const string& id) { return faculty.get(Symbols::faculty().find(id)); }
+    Faculty* getFaculty(Handle h) { return faculty.get(h); }
+    const Faculty* getFaculty(const string& id) const { return faculty.get(Symbols::faculty().find(id)); }
+    const Faculty* getFaculty(Handle h) const { return faculty.get(h); }
+    EntityStore<Faculty>& getAllFaculty() { return faculty; }
+    const EntityStore<Faculty>& getAllFaculty() const { return faculty; }
+    bool facultyExists(const string& id) const { return faculty.contains(Symbols::faculty().find(id)); }
+
+    void addRoom(const Room& room) {
+        Room* stored = rooms.put(room);
+        if (!stored) return;
+        for (MutationObserver* o : observers) o->onRoomAdded(*stored);
     }
-    map<string, Faculty>& getAllFaculty() { return faculty; }
-    bool facultyExists(const string& id) { return faculty.find(id) != faculty.end(); }
+    Room* getRoom(const string& id) { return rooms.get(Symbols::rooms().find(id)); }
+    Room* getRoom(Handle h) { return rooms.get(h); }
+    const Room* getRoom(const string& id) const { return rooms.get(Symbols::rooms().find(id)); }
+    const Room* getRoom(Handle h) const { return rooms.get(h); }
+    EntityStore<Room>& getAllRooms() { return rooms; }
+    const EntityStore<Room>& getAllRooms() const { return rooms; }
+    bool roomExists(const string& id) const { return rooms.contains(Symbols::rooms().find(id)); }
+
+    void addLab(const Lab& lab) {
+        const Lab* previous = labs.get(lab.getHandle());
+        if (previous && !batchDepth) slot(labsByCourse, previous->getAssociatedCourseHandle()).erase(lab.getHandle());
 
-    void addRoom(const Room& room) { rooms[room.getID()] = room; }
-    Room* getRoom(const string& id) {
-        return rooms.find(id) != rooms.end() ? &rooms[id] : nullptr;
+        Lab* stored = labs.put(lab);
+        if (!stored) return;
+        stored->attach(this);
+        if (!batchDepth) slot(labsByCourse, stored->getAssociatedCourseHandle()).insert(stored->getHandle());
+        for (MutationObserver* o : observers) o->onLabAdded(*stored);
+    }
+    Lab* getLab(const string& id) { return labs.get(Symbols::labs().find(id)); }
+    Lab* getLab(Handle h) { return labs.get(h); }
+    const Lab* getLab(const string& id) const { return labs.get(Symbols::labs().find(id)); }
+    const Lab* getLab(Handle h) const { return labs.get(h); }
+    EntityStore<Lab>& getAllLabs() { return labs; }
+    const EntityStore<Lab>& getAllLabs() const { return labs; }
+    bool labExists(const string& id) const { return labs.contains(Symbols::labs().find(id)); }
+
+    // Course -> students/faculty/labs lookups, maintained as records change.
+    const HandleSet& getEnrolledStudents(Handle course) const { return lookup(enrolledByCourse, course); }
+    const HandleSet& getCompletedStudents(Handle course) const { return lookup(completedByCourse, course); }
+    const HandleSet& getCourseFaculty(Handle course) const { return lookup(facultyByCourse, course); }
+    const HandleSet& getCourseLabs(Handle course) const { return lookup(labsByCourse, course); }
+
+    const HandleSet& getEnrolledStudents(const string& courseID) const {
+        return getEnrolledStudents(Symbols::courses().find(courseID));
+    }
+    const HandleSet& getCompletedStudents(const string& courseID) const {
+        return getCompletedStudents(Symbols::courses().find(courseID));
+    }
+    const HandleSet& getCourseFaculty(const string& courseID) const {
+        return getCourseFaculty(Symbols::courses().find(courseID));
+    }
+    const HandleSet& getCourseLabs(const string& courseID) const {
+        return getCourseLabs(Symbols::courses().find(courseID));
+    }
+
+    // Bit-matrix form of enrollments, completions and prerequisites.
+    const EnrollmentBits& getEnrollmentBits() const { return bits; }
+
+    // Pre-sizes the indexes for every stored student and interned course and takes
+    // private copies of anything still shared with a fork, so that enrollment
+    // changes arriving from several threads (see RegistrationEngine) only
+    // touch existing, unshared slots.
+    void reserveIndexes() {
+        size_t courseSlots = Symbols::courses().size();
+        enrolledByCourse.resize(courseSlots, HandleSet());
+        completedByCourse.resize(courseSlots, HandleSet());
+        facultyByCourse.resize(courseSlots, HandleSet());
+        labsByCourse.resize(courseSlots, HandleSet());
+        for (const Student& student : students) bits.addStudent(student.getHandle());
+        bits.reserve(courseSlots);
+
+        courses.detach();
+        students.detach();
+        faculty.detach();
+        rooms.detach();
+        labs.detach();
+        enrolledByCourse.detach();
+        completedByCourse.detach();
+        facultyByCourse.detach();
+        labsByCourse.detach();
+        bits.detach();
+    }
+
+    // Defers index maintenance until the matching endBatch(); batches nest.
+    // The outermost endBatch() publishes the result.
+    void beginBatch() { batchDepth++; }
+    void endBatch() {
+        if (batchDepth > 0 && --batchDepth == 0) {
+            rebuildIndexes();
+            publishChange();
+        }
+    }
+
+    // Stops snapshot() from publishing changes until the matching
+    // releasePublishing(), which publishes everything held back. Holds nest.
+    // Whoever holds publishing, e.g. a RegistrationEngine whose writers run on
+    // several threads, publishes through publish() when it suits them.
+    // Changes still waiting for a snapshot() are published first, so readers
+    // on other threads never publish while the holder's writers run.
+    void holdPublishing() {
+        if (unpublished) publish();
+        publishHolds++;
+    }
+    void releasePublishing() {
+        if (publishHolds > 0 && --publishHolds == 0 && !batchDepth) publish();
+    }
+
+    BatchResult addCourses(const Course* records, size_t count) {
+        BatchResult result;
+        vector<char> seen(Symbols::courses().size(), 0);
+        beginBatch();
+        courses.reserveHandles(Symbols::courses().size());
+        for (size_t i = 0; i < count; i++) {
+            Handle h = records[i].getHandle();
+            if (h == INVALID_HANDLE) { result.rejected.push_back(make_pair(i, string("invalid course ID"))); continue; }
+            if (seen[h]) { result.rejected.push_back(make_pair(i, "duplicate course " + records[i].getID())); continue; }
+            seen[h] = 1;
+            if (!addCourse(records[i])) {
+                result.rejected.push_back(make_pair(i, "prerequisites of " + records[i].getID() + " would form a cycle"));
+                continue;
+            }
+            result.applied++;
+        }
+        endBatch();
+        return result;
+    }
+    BatchResult addCourses(const vector<Course>& records) { return addCourses(records.data(), records.size()); }
+
+    BatchResult addStudents(const Student* records, size_t count) {
+        BatchResult result;
+        vector<char> seen(Symbols::students().size(), 0);
+        beginBatch();
+        students.reserveHandles(Symbols::students().size());
+        for (size_t i = 0; i < count; i++) {
+            Handle h = records[i].getHandle();
+            if (h == INVALID_HANDLE) { result.rejected.push_back(make_pair(i, string("invalid student ID"))); continue; }
+            if (seen[h]) { result.rejected.push_back(make_pair(i, "duplicate student " + records[i].getID())); continue; }
+            seen[h] = 1;
+            addStudent(records[i]);
+            result.applied++;
+        }
+        endBatch();
+        return result;
+    }
+    BatchResult addStudents(const vector<Student>& records) { return addStudents(records.data(), records.size()); }
+
+    // Changes are grouped by student (keeping their relative order) and applied
+    // against the student's state as it evolves through the batch.
+    BatchResult applyEnrollments(const EnrollmentChange* changes, size_t count) {
+        BatchResult result;
+        vector<size_t> order(count);
+        for (size_t i = 0; i < count; i++) order[i] = i;
+        stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return changes[a].student < changes[b].student;
+        });
+
+        beginBatch();
+        for (size_t i : order) {
+            const EnrollmentChange& change = changes[i];
+            Student* student = students.get(change.student);
+            if (!student) {
+                result.rejected.push_back(make_pair(i, "unknown student " + Symbols::students().name(change.student)));
+                continue;
+            }
+            if (!courses.contains(change.course)) {
+                result.rejected.push_back(make_pair(i, "unknown course " + Symbols::courses().name(change.course)));
+                continue;
+            }
+
+            bool enrolled = student->getEnrolledHandles().contains(change.course);
+            switch (change.kind) {
+            case EnrollmentChange::ENROLL:
+                if (enrolled) { result.rejected.push_back(make_pair(i, string("already enrolled"))); continue; }
+                student->enrollCourse(change.course, change.credits);
+                break;
+            case EnrollmentChange::COMPLETE:
+                // A course completed without a live enrollment (a transcript
+                // row) is recorded but never counted in current credits.
+                student->completeCourse(change.course, enrolled ? change.credits : 0);
+                break;
+            case EnrollmentChange::DROP:
+                if (!enrolled) { result.rejected.push_back(make_pair(i, string("not enrolled"))); continue; }
+                student->dropCourse(change.course, change.credits);
+                break;
+            }
+            result.applied++;
+        }
+        endBatch();
+
+        sort(result.rejected.begin(), result.rejected.end());
+        return result;
+    }
+    BatchResult applyEnrollments(const vector<EnrollmentChange>& changes) {
+        return applyEnrollments(changes.data(), changes.size());
+    }
+
+    // Builds the next catalog version from the last one and what changed
+    // since, and swaps it in. A writer-side call: it must not overlap a change
+    // (it runs from snapshot() after unheld changes, on release of a hold, or
+    // from RegistrationEngine::publish() with every writer locked out).
+    // Readers are never blocked.
+    shared_ptr<const CatalogVersion> publish() {
+        lock_guard<mutex> guard(publishLock);
+        return publishLocked();
+    }
+
+    // The current version: the last published one, after publishing any
+    // change made since outside a batch or hold. That publish is writer-side
+    // work, so a writer whose changes other threads read while it runs must
+    // hold publishing (as RegistrationEngine does); then this never publishes
+    // and the holder decides how far it lags. Long-running readers should hold
+    // on to the returned pointer rather than calling back into the
+    // DataManager, so they see one consistent state.
+    shared_ptr<const CatalogVersion> snapshot() const {
+        if (unpublished) {
+            // Publishing is deferred writer-side state, not a visible change.
+            DataManager* self = const_cast<DataManager*>(this);
+            lock_guard<mutex> guard(self->publishLock);
+            if (unpublished) self->publishLocked();
+        }
+        return atomic_load(&published);
     }
-    map<string, Room>& getAllRooms() { return rooms; }
-    bool roomExists(const string& id) { return rooms.find(id) != rooms.end(); }
 
-    void addLab(const Lab& lab) { labs[lab.getID()] = lab; }
-    Lab* getLab(const string& id) {
-        return labs.find(id) != labs.end() ? &labs[id] : nullptr;
+    void addObserver(MutationObserver* observer) { observers.push_back(observer); }
+    void removeObserver(MutationObserver* observer) {
+        observers.erase(remove(observers.begin(), observers.end(), observer), observers.end());
     }
-    map<string, Lab>& getAllLabs() { return labs; }
-    bool labExists(const string& id) { return labs.find(id) != labs.end(); }
 
     void clearAll() {
         courses.clear();
@@ -211,5 +1470,14 @@ public:
         faculty.clear();
         rooms.clear();
         labs.clear();
+        enrolledByCourse.clear();
+        completedByCourse.clear();
+        facultyByCourse.clear();
+        labsByCourse.clear();
+        bits.clear();
+        markAllChanged();
+        for (CourseStripe& stripe : courseStripes) stripe.changedStudents.clear();
+        publishChange();
+        for (MutationObserver* o : observers) o->onCleared();
     }
 };
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define SCHEDULING_H
 
 #include "Core.h"
+#include "Arena.h"
 #include <vector>
 #include <string>
 #include <set>
@@ -13,70 +14,75 @@ using namespace std;
 
 class SchedulingModule {
 private:
-    DataManager* dm;
+    const DataManager* dm;
     map<string, vector<vector<string>>> memoizedSequences;
     
     void getAllPrerequisites(const string& courseID, set<string>& allPrereqs) {
-        Course* course = dm->getCourse(courseID);
-        if (!course) return;
-        
-        for (const string& prereq : course->getPrerequisites()) {
-            if (allPrereqs.find(prereq) == allPrereqs.end()) {
-                allPrereqs.insert(prereq);
-                getAllPrerequisites(prereq, allPrereqs);
-            }
-        }
+        const EnrollmentBits& bits = dm->getEnrollmentBits();
+        BitOps::forEachSetBit(bits.allPrerequisitesOf(Symbols::courses().find(courseID)), bits.courseWords(),
+            [&](Handle prereq) { allPrereqs.insert(Symbols::courses().name(prereq)); });
     }
 
+    // Depth-first search with backtracking: one `taken` flag per candidate, one
+    // `completed` flag per course handle and a single shared sequence are
+    // updated in place and undone on the way back, instead of copying the
+    // remaining/completed sets and the sequence at every level. Each level's
+    // eligible list is a frame carved out of the query arena.
     void generateSequencesRecursive(
-        const set<string>& remaining,
-        const set<string>& completed,
+        const vector<Handle>& candidates,
+        vector<char>& taken,
+        vector<char>& completed,
+        size_t remaining,
+        uint32_t* frame,
         vector<string>& currentSequence,
         vector<vector<string>>& allSequences,
         int maxDepth
     ) {
-        if (remaining.empty() || maxDepth == 0) {
+        if (remaining == 0 || maxDepth == 0) {
             if (!currentSequence.empty()) {
                 allSequences.push_back(currentSequence);
             }
             return;
         }
         
-        vector<string> eligible;
-        for (const string& courseID : remaining) {
-            Course* course = dm->getCourse(courseID);
+        uint32_t* eligible = frame;
+        size_t eligibleCount = 0;
+        for (size_t i = 0; i < candidates.size(); i++) {
+            if (taken[i]) continue;
+            const Course* course = dm->getCourse(candidates[i]);
             if (!course) continue;
             
             bool canTake = true;
-            for (const string& prereq : course->getPrerequisites()) {
-                if (completed.find(prereq) == completed.end()) {
+            for (Handle prereq : course->getPrerequisiteHandles()) {
+                if (prereq >= completed.size() || !completed[prereq]) {
                     canTake = false;
                     break;
                 }
             }
             
             if (canTake) {
-                eligible.push_back(courseID);
+                eligible[eligibleCount++] = (uint32_t)i;
             }
         }
         
-        for (const string& courseID : eligible) {
-            set<string> newRemaining = remaining;
-            newRemaining.erase(courseID);
-            
-            set<string> newCompleted = completed;
-            newCompleted.insert(courseID);
+        for (size_t k = 0; k < eligibleCount; k++) {
+            uint32_t i = eligible[k];
+            taken[i] = 1;
+            completed[candidates[i]] = 1;
+            currentSequence.push_back(Symbols::courses().name(candidates[i]));
             
-            vector<string> newSequence = currentSequence;
-            newSequence.push_back(courseID);
+            generateSequencesRecursive(candidates, taken, completed, remaining - 1,
+                frame + candidates.size(), currentSequence, allSequences, maxDepth - 1);
             
-            generateSequencesRecursive(newRemaining, newCompleted, newSequence, allSequences, maxDepth - 1);
+            currentSequence.pop_back();
+            completed[candidates[i]] = 0;
+            taken[i] = 0;
         }
     }
     
 public:
-    SchedulingModule() {
-        dm = DataManager::getInstance();
+    explicit SchedulingModule(DataManager* manager) {
+        dm = manager;
     }
     
     void viewCoursesAndPrerequisites() {
@@ -87,8 +93,7 @@ public:
             return;
         }
         
-        for (auto& pair : dm->getAllCourses()) {
-            Course& course = pair.second;
+        for (const Course& course : dm->getAllCourses()) {
             cout << "\nCourse: " << course.getID() << " - " << course.getName() 
                  << " (" << course.getCredits() << " credits)" << endl;
             
@@ -109,17 +114,29 @@ public:
     
     vector<vector<string>> generateValidSequences(const set<string>& courseIDs, int maxLength = 10) {
         vector<vector<string>> allSequences;
+        if (courseIDs.empty() || maxLength == 0) return allSequences;
+        
+        vector<Handle> candidates;
+        for (const string& courseID : courseIDs) {
+            candidates.push_back(Symbols::courses().find(courseID));
+        }
+        vector<char> taken(candidates.size(), 0);
+        vector<char> completed(Symbols::courses().size(), 0);
         vector<string> currentSequence;
-        set<string> completed;
         
-        generateSequencesRecursive(courseIDs, completed, currentSequence, allSequences, maxLength);
+        MonotonicArena arena;
+        size_t depth = maxLength < 0 ? candidates.size() : min(candidates.size(), (size_t)maxLength);
+        uint32_t* frames = arena.allocateArray<uint32_t>(depth * candidates.size());
+        
+        generateSequencesRecursive(candidates, taken, completed, candidates.size(), frames,
+            currentSequence, allSequences, maxLength);
         
         return allSequences;
     }
     
     bool checkEligibility(const string& studentID, const string& courseID) {
-        Student* student = dm->getStudent(studentID);
-        Course* course = dm->getCourse(courseID);
+        const Student* student = dm->getStudent(studentID);
+        const Course* course = dm->getCourse(courseID);
         
         if (!student || !course) {
             cout << "Invalid student or course ID" << endl;
@@ -130,12 +147,12 @@ public:
         cout << "Student: " << student->getName() << " (" << studentID << ")" << endl;
         cout << "Course: " << course->getName() << " (" << courseID << ")" << endl;
         
-        if (student->getEnrolledCourses().find(courseID) != student->getEnrolledCourses().end()) {
+        if (student->isEnrolled(courseID)) {
             cout << "\nStudent is already enrolled in this course!" << endl;
             return false;
         }
         
-        if (student->getCompletedCourses().find(courseID) != student->getCompletedCourses().end()) {
+        if (student->hasCompleted(courseID)) {
             cout << "\nStudent has already completed this course!" << endl;
             return false;
         }
@@ -151,7 +168,7 @@ public:
             cout << "\nStudent IS ELIGIBLE for " << courseID << endl;
         } else {
             for (const string& prereq : course->getPrerequisites()) {
-                if (student->getCompletedCourses().find(prereq) == student->getCompletedCourses().end()) {
+                if (!student->hasCompleted(prereq)) {
                     cout << "Missing prerequisite: " << prereq << endl;
                     eligible = false;
                 } else {
@@ -167,38 +184,52 @@ public:
     }
     
     vector<string> predictAvailableCourses(const string& studentID) {
-        Student* student = dm->getStudent(studentID);
+        const Student* student = dm->getStudent(studentID);
         if (!student) {
             cout << "Student not found." << endl;
             return vector<string>();
         }
         
         vector<string> available;
+
+        const EnrollmentBits& bits = dm->getEnrollmentBits();
+        Handle s = student->getHandle();
+        const uint64_t* completed = bits.completedCourses(s);
         
-        for (auto& pair : dm->getAllCourses()) {
-            const string& courseID = pair.first;
-            Course& course = pair.second;
+        for (const Course& course : dm->getAllCourses()) {
+            Handle c = course.getHandle();
             
-            if (student->getEnrolledCourses().find(courseID) != student->getEnrolledCourses().end() ||
-                student->getCompletedCourses().find(courseID) != student->getCompletedCourses().end()) {
+            if (bits.isEnrolled(s, c) || bits.hasCompleted(s, c)) {
                 continue;
             }
             
-            bool canTake = true;
-            for (const string& prereq : course.getPrerequisites()) {
-                if (student->getCompletedCourses().find(prereq) == student->getCompletedCourses().end()) {
-                    canTake = false;
-                    break;
-                }
-            }
-            
-            if (canTake) {
-                available.push_back(courseID);
+            if (BitOps::isSubset(bits.prerequisitesOf(c), completed, bits.courseWords())) {
+                available.push_back(course.getID());
             }
         }
         
         return available;
     }
+
+    // Every student who could enroll in the course right now.
+    vector<string> eligibleStudents(const string& courseID) {
+        vector<string> eligible;
+        const Course* course = dm->getCourse(courseID);
+        if (!course) return eligible;
+
+        const EnrollmentBits& bits = dm->getEnrollmentBits();
+        Handle c = course->getHandle();
+        const uint64_t* prereqs = bits.prerequisitesOf(c);
+
+        for (const Student& student : dm->getAllStudents()) {
+            Handle s = student.getHandle();
+            if (bits.isEnrolled(s, c) || bits.hasCompleted(s, c)) continue;
+            if (BitOps::isSubset(prereqs, bits.completedCourses(s), bits.courseWords())) {
+                eligible.push_back(student.getID());
+            }
+        }
+        return eligible;
+    }
     
     vector<string> topologicalSort(const set<string>& courseIDs) {
         map<string, int> inDegree;
@@ -210,7 +241,7 @@ public:
         }
         
         for (const string& courseID : courseIDs) {
-            Course* course = dm->getCourse(courseID);
+            const Course* course = dm->getCourse(courseID);
             if (!course) continue;
             
             for (const string& prereq : course->getPrerequisites()) {
@@ -258,10 +289,10 @@ public:
         viewCoursesAndPrerequisites();
         
         if (!dm->getAllStudents().empty() && !dm->getAllCourses().empty()) {
-            string studentID = dm->getAllStudents().begin()->first;
+            string studentID = dm->getAllStudents().begin()->getID();
             
             if (dm->getAllCourses().size() > 0) {
-                string courseID = dm->getAllCourses().begin()->first;
+                string courseID = dm->getAllCourses().begin()->getID();
                 checkEligibility(studentID, courseID);
             }
             
@@ -272,7 +303,7 @@ public:
                 cout << "No available courses at this time." << endl;
             } else {
                 for (const string& courseID : available) {
-                    Course* course = dm->getCourse(courseID);
+                    const Course* course = dm->getCourse(courseID);
                     if (course) {
                         cout << "✓ " << courseID << ": " << course->getName() << endl;
                     }
@@ -282,8 +313,8 @@ public:
             if (dm->getAllCourses().size() >= 3) {
                 set<string> sampleCourses;
                 int count = 0;
-                for (auto& pair : dm->getAllCourses()) {
-                    sampleCourses.insert(pair.first);
+                for (const Course& course : dm->getAllCourses()) {
+                    sampleCourses.insert(course.getID());
                     if (++count >= 4) break;
                 }
                 
@@ -0,0 +1,317 @@
+#pragma once
+
+#include "Core.h"
+#include "CatalogSnapshot.h"
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+using namespace std;
+
+// Bulk loader for registrar CSV exports. The file is memory-mapped, split into
+// line-aligned chunks that are tokenized on separate threads (fields are
+// pointer/length slices into the mapping, nothing is copied), and the parsed
+// rows are then merged into the DataManager as one batch on the calling thread.
+//
+// Formats (one header line is skipped when hasHeader is set):
+//   COURSES      course_id,name,credits[,prereq;prereq;...]
+//   STUDENTS     student_id,name
+//   ENROLLMENTS  student_id,course_id[,enrolled|completed|dropped]
+// COURSES and STUDENTS rows whose ID already exists are rejected, never merged.
+class CsvImporter {
+public:
+    enum Kind { COURSES, STUDENTS, ENROLLMENTS };
+
+    struct Report {
+        size_t rowsRead;
+        size_t rowsImported;
+        size_t rowsRejected;
+        double seconds;
+        vector<string> errors; // first few rejections, with line numbers
+
+        Report() : rowsRead(0), rowsImported(0), rowsRejected(0), seconds(0) {}
+        double rowsPerSecond() const { return seconds > 0 ? rowsRead / seconds : 0; }
+    };
+
+private:
+    struct Field {
+        const char* data;
+        size_t length;
+
+        string str() const { return string(data, length); }
+        bool equals(const char* s) const { return length == strlen(s) && memcmp(data, s, length) == 0; }
+    };
+
+    struct Row {
+        Field fields[4];
+        int fieldCount;
+        size_t line; // chunk-relative until merged
+    };
+
+    struct Rejection {
+        size_t line;
+        string reason;
+    };
+
+    struct Chunk {
+        const char* begin;
+        const char* end;
+        size_t lines;
+        vector<Row> rows;
+        vector<Rejection> rejected;
+    };
+
+    static const size_t MAX_ERRORS = 10;
+
+    DataManager* dm;
+    unsigned threadCount;
+
+    static void trim(Field& f) {
+        while (f.length && (f.data[0] == ' ' || f.data[0] == '\t')) { f.data++; f.length--; }
+        while (f.length && (f.data[f.length - 1] == ' ' || f.data[f.length - 1] == '\t' ||
+            f.data[f.length - 1] == '\r')) f.length--;
+        if (f.length >= 2 && f.data[0] == '"' && f.data[f.length - 1] == '"') {
+            f.data++;
+            f.length -= 2;
+        }
+    }
+
+    static bool parseInt(const Field& f, int& out) {
+        if (f.length == 0 || f.length > 9) return false;
+        int value = 0;
+        for (size_t i = 0; i < f.length; i++) {
+            if (f.data[i] < '0' || f.data[i] > '9') return false;
+            value = value * 10 + (f.data[i] - '0');
+        }
+        out = value;
+        return true;
+    }
+
+    static int expectedFields(Kind kind, int& maxFields) {
+        switch (kind) {
+        case COURSES: maxFields = 4; return 3;
+        case STUDENTS: maxFields = 2; return 2;
+        default: maxFields = 3; return 2;
+        }
+    }
+
+    static void parseChunk(Chunk& chunk, Kind kind) {
+        int maxFields;
+        int minFields = expectedFields(kind, maxFields);
+        const char* p = chunk.begin;
+        chunk.lines = 0;
+
+        while (p < chunk.end) {
+            const char* eol = (const char*)memchr(p, '\n', chunk.end - p);
+            if (!eol) eol = chunk.end;
+            size_t line = chunk.lines++;
+
+            Row row;
+            row.fieldCount = 0;
+            row.line = line;
+            bool tooMany = false;
+            bool inQuotes = false;
+            const char* fieldStart = p;
+            for (const char* c = p; c <= eol; c++) {
+                if (c < eol && *c == '"') inQuotes = !inQuotes;
+                if (c == eol || (*c == ',' && !inQuotes)) {
+                    if (row.fieldCount == maxFields) { tooMany = true; break; }
+                    Field f = { fieldStart, (size_t)(c - fieldStart) };
+                    trim(f);
+                    row.fields[row.fieldCount++] = f;
+                    fieldStart = c + 1;
+                }
+            }
+            p = eol + 1;
+
+            if (row.fieldCount == 1 && row.fields[0].length == 0) continue; // blank line
+
+            Rejection rejection;
+            rejection.line = line;
+            if (tooMany || row.fieldCount < minFields) {
+                rejection.reason = "expected " + to_string(minFields) + "-" + to_string(maxFields) + " fields";
+            }
+            else if (row.fields[0].length == 0) {
+                rejection.reason = "empty ID";
+            }
+            else if (kind == COURSES) {
+                int credits;
+                if (!parseInt(row.fields[2], credits)) rejection.reason = "invalid credits";
+            }
+            else if (kind == ENROLLMENTS) {
+                if (row.fields[1].length == 0) rejection.reason = "empty course ID";
+                else if (row.fieldCount == 3 && !row.fields[2].equals("enrolled") &&
+                    !row.fields[2].equals("completed") && !row.fields[2].equals("dropped")) {
+                    rejection.reason = "unknown status";
+                }
+            }
+
+            if (rejection.reason.empty()) chunk.rows.push_back(row);
+            else chunk.rejected.push_back(rejection);
+        }
+    }
+
+    static Course makeCourse(const Row& row) {
+        int credits = 0;
+        parseInt(row.fields[2], credits);
+        Course course(row.fields[0].str(), row.fields[1].str(), credits);
+        if (row.fieldCount == 4) {
+            const Field& list = row.fields[3];
+            size_t start = 0;
+            for (size_t i = 0; i <= list.length; i++) {
+                if (i == list.length || list.data[i] == ';') {
+                    Field prereq = { list.data + start, i - start };
+                    trim(prereq);
+                    if (prereq.length) course.addPrerequisite(prereq.str());
+                    start = i + 1;
+                }
+            }
+        }
+        return course;
+    }
+
+    static DataManager::EnrollmentChange::Kind changeKind(const Row& row) {
+        if (row.fieldCount < 3 || row.fields[2].equals("enrolled")) return DataManager::EnrollmentChange::ENROLL;
+        if (row.fields[2].equals("completed")) return DataManager::EnrollmentChange::COMPLETE;
+        return DataManager::EnrollmentChange::DROP;
+    }
+
+    // Hands every parsed row to the DataManager as a single batch. Rows the
+    // batch refuses are added to `rejected` under their file line.
+    size_t merge(const vector<Chunk>& chunks, const vector<size_t>& firstLines, Kind kind, vector<Rejection>& rejected) {
+        vector<size_t> lines;
+        DataManager::BatchResult result;
+
+        if (kind == COURSES) {
+            vector<Course> batch;
+            for (size_t c = 0; c < chunks.size(); c++) {
+                for (const Row& row : chunks[c].rows) {
+                    string id = row.fields[0].str();
+                    if (dm->courseExists(id)) {
+                        rejected.push_back(Rejection{ firstLines[c] + row.line, "duplicate course " + id });
+                        continue;
+                    }
+                    batch.push_back(makeCourse(row));
+                    lines.push_back(firstLines[c] + row.line);
+                }
+            }
+            result = dm->addCourses(batch);
+        }
+        else if (kind == STUDENTS) {
+            vector<Student> batch;
+            for (size_t c = 0; c < chunks.size(); c++) {
+                for (const Row& row : chunks[c].rows) {
+                    string id = row.fields[0].str();
+                    if (dm->studentExists(id)) {
+                        rejected.push_back(Rejection{ firstLines[c] + row.line, "duplicate student " + id });
+                        continue;
+                    }
+                    batch.push_back(Student(id, row.fields[1].str()));
+                    lines.push_back(firstLines[c] + row.line);
+                }
+            }
+            result = dm->addStudents(batch);
+        }
+        else {
+            vector<DataManager::EnrollmentChange> batch;
+            for (size_t c = 0; c < chunks.size(); c++) {
+                for (const Row& row : chunks[c].rows) {
+                    size_t line = firstLines[c] + row.line;
+                    string studentID = row.fields[0].str();
+                    string courseID = row.fields[1].str();
+                    Handle student = Symbols::students().find(studentID);
+                    const Course* course = dm->view().getCourse(courseID);
+                    if (student == INVALID_HANDLE) { rejected.push_back(Rejection{ line, "unknown student " + studentID }); continue; }
+                    if (!course) { rejected.push_back(Rejection{ line, "unknown course " + courseID }); continue; }
+
+                    batch.push_back(DataManager::EnrollmentChange(student, course->getHandle(), course->getCredits(), changeKind(row)));
+                    lines.push_back(line);
+                }
+            }
+            result = dm->applyEnrollments(batch);
+        }
+
+        for (const pair<size_t, string>& r : result.rejected) {
+            rejected.push_back(Rejection{ lines[r.first], r.second });
+        }
+        return result.applied;
+    }
+
+public:
+    explicit CsvImporter(DataManager* manager, unsigned threads = 0) : dm(manager), threadCount(threads) {
+        if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+    }
+
+    Report importFile(const string& path, Kind kind, bool hasHeader = true) {
+        Report report;
+        auto start = chrono::high_resolution_clock::now();
+
+        // An empty file cannot be mapped, but it is a valid CSV with no rows.
+        ifstream probe(path.c_str(), ios::binary | ios::ate);
+        if (probe && probe.tellg() == 0) return report;
+        probe.close();
+
+        MappedFile file;
+        if (!file.open(path)) {
+            report.errors.push_back("cannot open " + path);
+            return report;
+        }
+
+        const char* begin = file.data();
+        const char* end = begin + file.size();
+        size_t headerLines = 0;
+        if (hasHeader) {
+            const char* eol = (const char*)memchr(begin, '\n', end - begin);
+            begin = eol ? eol + 1 : end;
+            headerLines = 1;
+        }
+
+        // Split at line boundaries; small files use a single chunk.
+        size_t parts = min<size_t>(threadCount, max<size_t>(1, (end - begin) / (64 * 1024)));
+        vector<Chunk> chunks(parts);
+        const char* cursor = begin;
+        for (size_t i = 0; i < parts; i++) {
+            chunks[i].begin = cursor;
+            const char* target = (i + 1 == parts) ? end : begin + (end - begin) * (i + 1) / parts;
+            if (target < cursor) target = cursor;
+            const char* eol = target < end ? (const char*)memchr(target, '\n', end - target) : nullptr;
+            cursor = eol ? eol + 1 : end;
+            chunks[i].end = cursor;
+        }
+
+        vector<thread> workers;
+        for (size_t i = 1; i < parts; i++) {
+            workers.push_back(thread(parseChunk, ref(chunks[i]), kind));
+        }
+        parseChunk(chunks[0], kind);
+        for (thread& t : workers) t.join();
+
+        vector<size_t> firstLines;
+        vector<Rejection> rejected;
+        size_t firstLine = headerLines;
+        for (const Chunk& chunk : chunks) {
+            firstLines.push_back(firstLine);
+            for (const Rejection& r : chunk.rejected) {
+                rejected.push_back(Rejection{ firstLine + r.line, r.reason });
+            }
+            report.rowsRead += chunk.rows.size() + chunk.rejected.size();
+            firstLine += chunk.lines;
+        }
+
+        report.rowsImported = merge(chunks, firstLines, kind, rejected);
+
+        sort(rejected.begin(), rejected.end(), [](const Rejection& a, const Rejection& b) { return a.line < b.line; });
+        report.rowsRejected = rejected.size();
+        for (size_t i = 0; i < rejected.size() && i < MAX_ERRORS; i++) {
+            report.errors.push_back("line " + to_string(rejected[i].line + 1) + ": " + rejected[i].reason);
+        }
+
+        report.seconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+        return report;
+    }
+};
@@ -0,0 +1,285 @@
+#pragma once
+
+#include "Core.h"
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+// Shape of a synthetic catalog. Courses are split into departments and
+// levels; a course at level L takes its prerequisites from lower levels, so
+// the prerequisite graph is a DAG of depth `levels`.
+struct DatasetSpec {
+    unsigned seed;
+    string prefix;              // prepended to every generated ID
+
+    int departments;
+    int coursesPerDepartment;
+    int levels;                 // prerequisite DAG depth
+    int maxPrerequisites;       // fan-in of a course above the first level
+    double crossDepartmentRate; // share of prerequisites and enrollments outside the home department
+
+    int students;
+    int minCourses;             // current enrollments per student
+    int maxCourses;
+    double popularitySkew;      // Zipf exponent over the courses of a level
+
+    double labCourseRate;       // share of courses that have lab sections
+    int labsPerCourse;
+    int labCapacity;
+
+    int coursesPerFaculty;      // upper bound on a faculty member's load
+    int rooms;
+
+    DatasetSpec()
+        : seed(1), prefix("GEN"), departments(8), coursesPerDepartment(40), levels(4), maxPrerequisites(3),
+        crossDepartmentRate(0.15), students(10000), minCourses(3), maxCourses(6), popularitySkew(1.0),
+        labCourseRate(0.3), labsPerCourse(2), labCapacity(25), coursesPerFaculty(3), rooms(60) {}
+
+    // A university of `studentCount` students with a catalog grown to match:
+    // roughly one department per 2000 students, between 4 and 20.
+    static DatasetSpec forStudents(int studentCount, unsigned seed = 1) {
+        DatasetSpec spec;
+        spec.seed = seed;
+        spec.students = studentCount;
+        spec.departments = max(4, min(20, studentCount / 2000));
+        spec.rooms = max(10, spec.departments * spec.coursesPerDepartment / 4);
+        return spec;
+    }
+};
+
+// Seeded generator that fills a DataManager with a catalog of the given
+// shape. The same spec and seed always produce the same records, so timings
+// taken at 10^3 to 10^6 students can be compared across runs and machines.
+//
+// Every enrolled course has its whole prerequisite chain completed, lab
+// sections are seated from their course's roster, and no faculty member is
+// assigned more than coursesPerFaculty courses. Use SnapshotWriter to keep a
+// generated catalog on disk.
+class DatasetGenerator {
+public:
+    struct Summary {
+        size_t courses;
+        size_t prerequisites;
+        size_t students;
+        size_t enrollments;
+        size_t completions;
+        size_t labs;
+        size_t labSeats;
+        size_t faculty;
+        size_t rooms;
+        double seconds;
+
+        Summary() : courses(0), prerequisites(0), students(0), enrollments(0), completions(0),
+            labs(0), labSeats(0), faculty(0), rooms(0), seconds(0) {}
+    };
+
+private:
+    struct GeneratedCourse {
+        Handle handle;
+        int department;
+        int level;
+        int credits;
+        vector<Handle> chain; // every direct and indirect prerequisite, sorted
+    };
+
+    DataManager* dm;
+    mt19937 rng;
+
+    // The engines are portable but the standard distributions are not, so
+    // sampling is done by hand to keep datasets identical across platforms.
+    size_t below(size_t n) { return n ? rng() % n : 0; }
+    double unit() { return rng() / 4294967296.0; }
+
+    static size_t pick(const vector<double>& cumulative, double u) {
+        size_t i = upper_bound(cumulative.begin(), cumulative.end(), u * cumulative.back()) - cumulative.begin();
+        return min(i, cumulative.size() - 1);
+    }
+
+    static HandleSet toHandleSet(vector<Handle>& handles) {
+        sort(handles.begin(), handles.end());
+        handles.erase(unique(handles.begin(), handles.end()), handles.end());
+        HandleSet result;
+        for (Handle h : handles) result.appendSorted(h);
+        return result;
+    }
+
+public:
+    explicit DatasetGenerator(DataManager* manager) : dm(manager) {}
+
+    Summary generate(const DatasetSpec& spec) {
+        auto start = chrono::high_resolution_clock::now();
+        Summary summary;
+        rng.seed(spec.seed);
+
+        int levels = max(1, spec.levels);
+        int departments = max(1, spec.departments);
+
+        // pool[department][level] lists indexes into `generated`
+        vector<vector<vector<size_t>>> pool(departments, vector<vector<size_t>>(levels));
+        vector<GeneratedCourse> generated;
+        vector<Course> courses;
+
+        for (int d = 0; d < departments; d++) {
+            for (int i = 0; i < spec.coursesPerDepartment; i++) {
+                int level = i * levels / max(1, spec.coursesPerDepartment);
+                GeneratedCourse course;
+                course.department = d;
+                course.level = level;
+                course.credits = below(4) == 0 ? 4 : 3;
+
+                courses.push_back(Course(spec.prefix + "-D" + to_string(d) + "-" + to_string((level + 1) * 100 + i),
+                    "Department " + to_string(d) + " Level " + to_string(level + 1), course.credits));
+                course.handle = courses.back().getHandle();
+                pool[d][level].push_back(generated.size());
+                generated.push_back(course);
+            }
+        }
+
+        // Prerequisites come from lower levels, mostly the level just below,
+        // so chains have the requested depth. Courses are visited level by
+        // level across all departments, so a prerequisite's chain is complete
+        // before it is copied.
+        vector<size_t> byLevel;
+        for (int level = 1; level < levels; level++) {
+            for (int d = 0; d < departments; d++) {
+                byLevel.insert(byLevel.end(), pool[d][level].begin(), pool[d][level].end());
+            }
+        }
+        for (size_t c : byLevel) {
+            GeneratedCourse& course = generated[c];
+
+            int fanIn = 1 + (int)below(max(1, spec.maxPrerequisites));
+            for (int k = 0; k < fanIn; k++) {
+                int department = unit() < spec.crossDepartmentRate ? (int)below(departments) : course.department;
+                int level = unit() < 0.7 ? course.level - 1 : (int)below(course.level);
+                const vector<size_t>& candidates = pool[department][level];
+                if (candidates.empty()) continue;
+
+                const GeneratedCourse& prereq = generated[candidates[below(candidates.size())]];
+                if (!courses[c].getPrerequisiteHandles().contains(prereq.handle)) {
+                    courses[c].addPrerequisite(Symbols::courses().name(prereq.handle));
+                    course.chain.push_back(prereq.handle);
+                    course.chain.insert(course.chain.end(), prereq.chain.begin(), prereq.chain.end());
+                    summary.prerequisites++;
+                }
+            }
+            sort(course.chain.begin(), course.chain.end());
+            course.chain.erase(unique(course.chain.begin(), course.chain.end()), course.chain.end());
+        }
+
+        // Popular courses sit at the front of each pool: rank r is drawn with
+        // weight 1 / (r + 1)^skew.
+        vector<vector<double>> popularity(levels);
+        for (int level = 0; level < levels; level++) {
+            double total = 0;
+            for (size_t r = 0; r < pool[0][level].size(); r++) {
+                total += 1.0 / pow((double)(r + 1), spec.popularitySkew);
+                popularity[level].push_back(total);
+            }
+        }
+
+        vector<int> courseIndex(Symbols::courses().size(), -1);
+        for (size_t c = 0; c < generated.size(); c++) courseIndex[generated[c].handle] = (int)c;
+
+        vector<Student> students;
+        students.reserve(spec.students);
+        vector<Handle> enrolled, completed;
+        for (int s = 0; s < spec.students; s++) {
+            Student student(spec.prefix + "-S" + to_string(s), "Student " + to_string(s));
+            int year = (int)below(levels);
+            int home = (int)below(departments);
+            int load = spec.minCourses + (int)below(max(0, spec.maxCourses - spec.minCourses) + 1);
+
+            enrolled.clear();
+            completed.clear();
+            for (int k = 0; k < load; k++) {
+                int department = unit() < spec.crossDepartmentRate ? (int)below(departments) : home;
+                int level = year > 0 && unit() < 0.3 ? (int)below(year) : year;
+                const vector<size_t>& candidates = pool[department][level];
+                if (candidates.empty()) continue;
+
+                const GeneratedCourse& course = generated[candidates[pick(popularity[level], unit())]];
+                enrolled.push_back(course.handle);
+                completed.insert(completed.end(), course.chain.begin(), course.chain.end());
+            }
+
+            HandleSet completedSet = toHandleSet(completed);
+            vector<Handle> current;
+            int credits = 0;
+            for (Handle h : toHandleSet(enrolled)) {
+                if (completedSet.contains(h)) continue;
+                current.push_back(h);
+                credits += generated[courseIndex[h]].credits;
+            }
+
+            summary.enrollments += current.size();
+            summary.completions += completedSet.size();
+            student.restoreState(toHandleSet(current), completedSet, credits);
+            students.push_back(student);
+        }
+
+        // Published once, at the end, rather than after every lab seat and
+        // faculty assignment.
+        dm->holdPublishing();
+        dm->beginBatch();
+        summary.courses = dm->addCourses(courses).applied;
+        summary.students = dm->addStudents(students).applied;
+        dm->endBatch();
+
+        // Lab sections are seated from the front of their course's roster.
+        for (const GeneratedCourse& course : generated) {
+            if (unit() >= spec.labCourseRate) continue;
+
+            HandleSet roster = dm->getEnrolledStudents(course.handle);
+            HandleSet::const_iterator next = roster.begin();
+            for (int l = 0; l < spec.labsPerCourse; l++) {
+                Lab lab(Symbols::courses().name(course.handle) + "-LAB" + to_string(l + 1),
+                    Symbols::courses().name(course.handle), spec.labCapacity);
+                dm->addLab(lab);
+                Lab* stored = dm->getLab(lab.getHandle());
+                for (int seat = 0; seat < spec.labCapacity && next != roster.end(); seat++, ++next) {
+                    stored->enrollStudent(*next);
+                    summary.labSeats++;
+                }
+                summary.labs++;
+            }
+        }
+
+        // Faculty teach within one department, each up to a randomly drawn load.
+        int perFaculty = max(1, spec.coursesPerFaculty);
+        for (int d = 0; d < departments; d++) {
+            Faculty* current = nullptr;
+            int target = 0;
+            for (int level = 0; level < levels; level++) {
+                for (size_t c : pool[d][level]) {
+                    if (!current || (int)current->getAssignedHandles().size() >= target) {
+                        Faculty faculty(spec.prefix + "-F" + to_string(summary.faculty),
+                            "Faculty " + to_string(summary.faculty), perFaculty);
+                        dm->addFaculty(faculty);
+                        current = dm->getFaculty(faculty.getHandle());
+                        target = 1 + (int)below(perFaculty);
+                        summary.faculty++;
+                    }
+                    current->assignCourse(Symbols::courses().name(generated[c].handle));
+                }
+            }
+        }
+
+        static const int ROOM_SIZES[] = { 30, 40, 60, 120 };
+        for (int r = 0; r < spec.rooms; r++) {
+            bool lab = below(4) == 0;
+            dm->addRoom(Room(spec.prefix + "-R" + to_string(r), lab ? 30 : ROOM_SIZES[below(4)], lab ? "Lab" : "Lecture"));
+            summary.rooms++;
+        }
+        dm->releasePublishing();
+
+        summary.seconds = chrono::duration_cast<chrono::duration<double>>(
+            chrono::high_resolution_clock::now() - start).count();
+        return summary;
+    }
+};
@@ -9,15 +9,15 @@
 
 class FunctionsModule {
 private:
-    DataManager* dm;
+    const DataManager* dm;
 
     map<string, string> studentToCourse;
     map<string, string> courseToFaculty;
     map<string, string> facultyToRoom;
 
 public:
-    FunctionsModule() {
-        dm = DataManager::getInstance();
+    explicit FunctionsModule(DataManager* manager) {
+        dm = manager;
         buildFunctions();
     }
 
@@ -27,24 +27,32 @@ public:
         facultyToRoom.clear();
 
     
-        for (auto& pair : dm->getAllStudents()) {
-            Student& student = pair.second;
-            if (!student.getEnrolledCourses().empty()) {
-                studentToCourse[student.getID()] = *student.getEnrolledCourses().begin();
+        // Everything but the rooms comes from one pinned version, rows in ID order.
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
+        const CatalogColumns& columns = version->columns;
+        for (size_t row = 0; row < columns.studentCount(); row++) {
+            const string* first = nullptr;
+            for (Handle course : columns.enrolled(row)) {
+                const string& id = Symbols::courses().name(course);
+                if (!first || id < *first) first = &id;
             }
+            if (first) studentToCourse.insert(studentToCourse.end(), make_pair(columns.studentID(row), *first));
         }
 
-        for (auto& pair : dm->getAllFaculty()) {
-            Faculty& faculty = pair.second;
-            for (const string& courseID : faculty.getAssignedCourses()) {
-                courseToFaculty[courseID] = faculty.getID();
+        // A course taught by several faculty maps to the last of them by ID.
+        for (size_t row = 0; row < columns.facultyCount(); row++) {
+            for (Handle course : columns.assigned(row)) {
+                courseToFaculty[Symbols::courses().name(course)] = columns.facultyID(row);
             }
         }
 
-        if (!dm->getAllRooms().empty()) {
-            string firstRoom = dm->getAllRooms().begin()->first;
-            for (auto& pair : dm->getAllFaculty()) {
-                facultyToRoom[pair.first] = firstRoom;
+        const string* firstRoom = nullptr;
+        for (const Room& room : dm->getAllRooms()) {
+            if (!firstRoom || room.getID() < *firstRoom) firstRoom = &room.getID();
+        }
+        if (firstRoom) {
+            for (size_t row = 0; row < columns.facultyCount(); row++) {
+                facultyToRoom.insert(facultyToRoom.end(), make_pair(columns.facultyID(row), *firstRoom));
             }
         }
     }
@@ -12,40 +12,53 @@ using namespace std;
 
 class InductionModule {
 private:
-    DataManager* dm;
+    const DataManager* dm;
 
-    set<string> getDirectPrerequisites(const string& courseID) {
-        Course* course = dm->getCourse(courseID);
-        if (!course) return set<string>();
-        return course->getPrerequisites();
+    // Proofs read one pinned catalog version from start to finish; rows are
+    // NO_ROW for records that do not exist in it.
+    static size_t courseRow(const CatalogVersion& version, const string& courseID) {
+        return version.columns.courseRow(Symbols::courses().find(courseID));
     }
 
-    void getAllPrerequisitesRecursive(const string& courseID, set<string>& allPrereqs, set<string>& visited) {
-        if (visited.find(courseID) != visited.end()) return;
-        visited.insert(courseID);
+    static size_t studentRow(const CatalogVersion& version, const string& studentID) {
+        return version.columns.studentRow(Symbols::students().find(studentID));
+    }
 
-        Course* course = dm->getCourse(courseID);
-        if (!course) return;
+    static bool hasCompleted(const CatalogVersion& version, size_t student, const string& courseID) {
+        return version.columns.completed(student).contains(Symbols::courses().find(courseID));
+    }
 
-        for (const string& prereq : course->getPrerequisites()) {
-            allPrereqs.insert(prereq);
-            getAllPrerequisitesRecursive(prereq, allPrereqs, visited);
-        }
+    set<string> getDirectPrerequisites(const string& courseID) {
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
+        size_t row = courseRow(*version, courseID);
+        set<string> prereqs;
+        if (row == CatalogColumns::NO_ROW) return prereqs;
+        for (Handle prereq : version->columns.prerequisites(row)) prereqs.insert(Symbols::courses().name(prereq));
+        return prereqs;
+    }
+
+    // Direct and indirect prerequisites, read from the version's closure rows.
+    static set<string> getAllPrerequisites(const CatalogVersion& version, const string& courseID) {
+        set<string> allPrereqs;
+        BitOps::forEachSetBit(version.bits.allPrerequisitesOf(Symbols::courses().find(courseID)), version.bits.courseWords(),
+            [&](Handle prereq) { allPrereqs.insert(Symbols::courses().name(prereq)); });
+        return allPrereqs;
     }
 
 public:
-    InductionModule() {
-        dm = DataManager::getInstance();
+    explicit InductionModule(DataManager* manager) {
+        dm = manager;
     }
 
     bool verifyBaseCase(const string& studentID, const string& courseID) {
-        Course* course = dm->getCourse(courseID);
-        if (!course) {
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
+        size_t course = courseRow(*version, courseID);
+        if (course == CatalogColumns::NO_ROW) {
             cout << "Course not found." << endl;
             return false;
         }
 
-        if (course->getPrerequisites().empty()) {
+        if (version->columns.prerequisites(course).empty()) {
             cout << "Base Case: Course " << courseID << " has no prerequisites." << endl;
             cout << "Student " << studentID << " can take this course." << endl;
             return true;
@@ -55,10 +68,11 @@ public:
     }
 
     bool verifyInductiveStep(const string& studentID, const string& courseID) {
-        Student* student = dm->getStudent(studentID);
-        Course* course = dm->getCourse(courseID);
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
+        size_t student = studentRow(*version, studentID);
+        size_t course = courseRow(*version, courseID);
 
-        if (!student || !course) {
+        if (student == CatalogColumns::NO_ROW || course == CatalogColumns::NO_ROW) {
             cout << "Invalid student or course." << endl;
             return false;
         }
@@ -67,7 +81,7 @@ public:
         cout << "Hypothesis: If student completed all level-k prerequisites," << endl;
         cout << "            they can take level-(k+1) course " << courseID << endl;
 
-        set<string> prerequisites = course->getPrerequisites();
+        HandleRange prerequisites = version->columns.prerequisites(course);
 
         if (prerequisites.empty()) {
             cout << "No prerequisites - Base case applies." << endl;
@@ -77,10 +91,9 @@ public:
         cout << "\nChecking prerequisites:" << endl;
         bool allCompleted = true;
 
-        for (const string& prereq : prerequisites) {
-            bool completed = student->getCompletedCourses().find(prereq) !=
-                student->getCompletedCourses().end();
-            cout << "  " << prereq << ": " << (completed ? "Completed" : "Not completed") << endl;
+        for (Handle prereq : prerequisites) {
+            bool completed = version->columns.completed(student).contains(prereq);
+            cout << "  " << Symbols::courses().name(prereq) << ": " << (completed ? "Completed" : "Not completed") << endl;
 
             if (!completed) allCompleted = false;
         }
@@ -96,17 +109,17 @@ public:
     }
 
     bool verifyPrerequisiteChain(const string& studentID, const string& courseID) {
-        Student* student = dm->getStudent(studentID);
-        Course* course = dm->getCourse(courseID);
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
+        const CatalogColumns& columns = version->columns;
+        size_t student = studentRow(*version, studentID);
+        size_t course = courseRow(*version, courseID);
 
-        if (!student || !course) return false;
+        if (student == CatalogColumns::NO_ROW || course == CatalogColumns::NO_ROW) return false;
 
         cout << "\n=== MATHEMATICAL INDUCTION PROOF ===" << endl;
         cout << "Proving: Student " << studentID << " can take course " << courseID << endl;
 
-        set<string> allPrereqs;
-        set<string> visited;
-        getAllPrerequisitesRecursive(courseID, allPrereqs, visited);
+        set<string> allPrereqs = getAllPrerequisites(*version, courseID);
 
         if (allPrereqs.empty()) {
             cout << "\nBase Case: Course has no prerequisites." << endl;
@@ -122,15 +135,15 @@ public:
                 return courseLevel[cid];
             }
 
-            Course* c = dm->getCourse(cid);
-            if (!c || c->getPrerequisites().empty()) {
+            size_t row = courseRow(*version, cid);
+            if (row == CatalogColumns::NO_ROW || columns.prerequisites(row).empty()) {
                 courseLevel[cid] = 0;
                 return 0;
             }
 
             int maxLevel = 0;
-            for (const string& prereq : c->getPrerequisites()) {
-                maxLevel = max(maxLevel, computeLevel(prereq) + 1);
+            for (Handle prereq : columns.prerequisites(row)) {
+                maxLevel = max(maxLevel, computeLevel(Symbols::courses().name(prereq)) + 1);
             }
 
             courseLevel[cid] = maxLevel;
@@ -152,8 +165,7 @@ public:
         }
         else {
             for (const string& prereq : levelMap[0]) {
-                bool completed = student->getCompletedCourses().find(prereq) !=
-                    student->getCompletedCourses().end();
+                bool completed = hasCompleted(*version, student, prereq);
                 cout << "  " << prereq << ": " << (completed ? "Completed" : "Not completed") << endl;
 
                 if (!completed) {
@@ -171,20 +183,18 @@ public:
             if (levelMap[k + 1].empty()) continue;
 
             for (const string& prereq : levelMap[k + 1]) {
-                Course* prereqCourse = dm->getCourse(prereq);
-                if (!prereqCourse) continue;
+                size_t prereqRow = courseRow(*version, prereq);
+                if (prereqRow == CatalogColumns::NO_ROW) continue;
 
                 bool canTake = true;
-                for (const string& subPrereq : prereqCourse->getPrerequisites()) {
-                    if (student->getCompletedCourses().find(subPrereq) ==
-                        student->getCompletedCourses().end()) {
+                for (Handle subPrereq : columns.prerequisites(prereqRow)) {
+                    if (!columns.completed(student).contains(subPrereq)) {
                         canTake = false;
                         break;
                     }
                 }
 
-                bool completed = student->getCompletedCourses().find(prereq) !=
-                    student->getCompletedCourses().end();
+                bool completed = hasCompleted(*version, student, prereq);
 
                 cout << "  " << prereq << ": Prerequisites "
                     << (canTake ? "satisfied" : "not satisfied")
@@ -208,19 +218,17 @@ public:
         cout << "\n=== STRONG INDUCTION VERIFICATION ===" << endl;
         cout << "Course: " << courseID << endl;
 
-        Student* student = dm->getStudent(studentID);
-        if (!student) return false;
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
+        size_t student = studentRow(*version, studentID);
+        if (student == CatalogColumns::NO_ROW) return false;
 
-        set<string> allPrereqs;
-        set<string> visited;
-        getAllPrerequisitesRecursive(courseID, allPrereqs, visited);
+        set<string> allPrereqs = getAllPrerequisites(*version, courseID);
 
         cout << "\nAll prerequisites (direct and indirect):" << endl;
 
         bool allSatisfied = true;
         for (const string& prereq : allPrereqs) {
-            bool completed = student->getCompletedCourses().find(prereq) !=
-                student->getCompletedCourses().end();
+            bool completed = hasCompleted(*version, student, prereq);
             cout << "  " << prereq << ": " << (completed ? "T" : "F") << endl;
 
             if (!completed) allSatisfied = false;
@@ -238,10 +246,7 @@ public:
     }
 
     set<string> validateIndirectPrerequisites(const string& courseID) {
-        set<string> allPrereqs;
-        set<string> visited;
-        getAllPrerequisitesRecursive(courseID, allPrereqs, visited);
-        return allPrereqs;
+        return getAllPrerequisites(*dm->snapshot(), courseID);
     }
 
     void demonstrate() {
@@ -254,16 +259,16 @@ public:
             return;
         }
 
-        string studentID = dm->getAllStudents().begin()->first;
-        Student* student = dm->getStudent(studentID);
+        string studentID = dm->getAllStudents().begin()->getID();
+        const Student* student = dm->getStudent(studentID);
 
         cout << "Demonstrating with Student: " << studentID
             << " (" << student->getName() << ")" << endl;
 
         string targetCourse;
-        for (auto& pair : dm->getAllCourses()) {
-            if (!pair.second.getPrerequisites().empty()) {
-                targetCourse = pair.first;
+        for (const Course& course : dm->getAllCourses()) {
+            if (!course.getPrerequisites().empty()) {
+                targetCourse = course.getID();
                 break;
             }
         }
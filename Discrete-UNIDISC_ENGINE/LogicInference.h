@@ -22,7 +22,7 @@ struct LogicRule {
 
 class LogicEngine {
 private:
-    DataManager* dm;
+    const DataManager* dm;
     vector<LogicRule> rules;
     set<string> facts; 
     map<string, string> conflicts;
@@ -57,8 +57,8 @@ private:
     }
 
 public:
-    LogicEngine() {
-        dm = DataManager::getInstance();
+    explicit LogicEngine(DataManager* manager) {
+        dm = manager;
     }
 
     void addCourseRule(const string& courseID, const string& prerequisite) {
@@ -140,16 +140,14 @@ public:
 
         map<string, set<string>> studentSchedules;
 
-        for (auto& studentPair : dm->getAllStudents()) {
-            Student& student = studentPair.second;
+        for (const Student& student : dm->getAllStudents()) {
             string studentID = student.getID();
 
             for (const string& courseID : student.getEnrolledCourses()) {
                 studentSchedules[studentID].insert(courseID);
             }
         }
-        for (auto& facultyPair : dm->getAllFaculty()) {
-            Faculty& faculty = facultyPair.second;
+        for (const Faculty& faculty : dm->getAllFaculty()) {
 
             if (faculty.getAssignedCourses().size() > faculty.getMaxCourses()) {
                 string conflict = "Faculty " + faculty.getID() + " overloaded: " +
@@ -160,16 +158,14 @@ public:
             }
         }
 
-        for (auto& studentPair : dm->getAllStudents()) {
-            Student& student = studentPair.second;
+        for (const Student& student : dm->getAllStudents()) {
 
             for (const string& courseID : student.getEnrolledCourses()) {
-                Course* course = dm->getCourse(courseID);
+                const Course* course = dm->getCourse(courseID);
                 if (!course) continue;
 
                 for (const string& prereq : course->getPrerequisites()) {
-                    if (student.getCompletedCourses().find(prereq) ==
-                        student.getCompletedCourses().end()) {
+                    if (!student.hasCompleted(prereq)) {
 
                         string conflict = "Student " + student.getID() +
                             " enrolled in " + courseID +
@@ -231,28 +227,25 @@ public:
         cout << "Creating rules from system data..." << endl;
 
         
-        for (auto& coursePair : dm->getAllCourses()) {
-            Course& course = coursePair.second;
+        for (const Course& course : dm->getAllCourses()) {
             for (const string& prereq : course.getPrerequisites()) {
                 addCourseRule(course.getID(), prereq);
             }
         }
 
         
-        for (auto& facultyPair : dm->getAllFaculty()) {
-            Faculty& faculty = facultyPair.second;
+        for (const Faculty& faculty : dm->getAllFaculty()) {
             for (const string& courseID : faculty.getAssignedCourses()) {
                 
                 if (!dm->getAllRooms().empty()) {
-                    string roomID = dm->getAllRooms().begin()->first;
+                    string roomID = dm->getAllRooms().begin()->getID();
                     addFacultyRule(faculty.getID(), courseID, roomID);
                 }
             }
         }
 
         
-        for (auto& studentPair : dm->getAllStudents()) {
-            Student& student = studentPair.second;
+        for (const Student& student : dm->getAllStudents()) {
             for (const string& courseID : student.getEnrolledCourses()) {
                 addFact("enrolled(" + courseID + ")");
             }
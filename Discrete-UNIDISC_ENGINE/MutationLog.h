@@ -0,0 +1,700 @@
+#pragma once
+
+#include "Core.h"
+#include "CatalogSnapshot.h"
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#if defined(_WIN32)
+#include <io.h>
+#endif
+
+using namespace std;
+
+// Append-only journal of DataManager mutations with group commit.
+//
+// <base>.snap holds the last compacted catalog snapshot and <base>.wal every
+// mutation applied since. The log header records the checksum of the snapshot
+// it continues from, so a log left behind by an interrupted compaction is
+// recognised as stale and ignored. Records carry string IDs (handles are only
+// stable within one process) and are framed as
+//   [u32 payload length][u32 checksum][u8 op][fields...]
+// so replay stops cleanly at a torn tail.
+//
+// Appends only copy the record into a buffer. A background flusher (or an
+// explicit sync()) writes everything pending with a single write + fsync, and
+// callers that need durability for their own change wait on that same flush.
+// A failed write is cut back off the file and its records stay pending for
+// the next flush; if the file cannot be cut back the log latches the failure
+// and refuses further records.
+class MutationLog : public MutationObserver {
+public:
+    struct RecoveryReport {
+        bool snapshotLoaded;
+        size_t recordsReplayed;
+        size_t recordsSkipped;
+        bool staleLogIgnored;
+        bool tailTruncated;
+        string error;
+
+        RecoveryReport()
+            : snapshotLoaded(false), recordsReplayed(0), recordsSkipped(0),
+              staleLogIgnored(false), tailTruncated(false) {}
+    };
+
+private:
+    enum Op : uint8_t {
+        OP_COURSE = 1, OP_STUDENT, OP_FACULTY, OP_ROOM, OP_LAB,
+        OP_ENROLL, OP_COMPLETE, OP_DROP, OP_ASSIGN, OP_UNASSIGN,
+        OP_PREREQUISITES, OP_LAB_JOIN, OP_LAB_LEAVE, OP_CLEAR
+    };
+
+    struct LogHeader {
+        char magic[8];
+        uint64_t baseChecksum; // checksum of the snapshot this log continues from, 0 if none
+    };
+
+    static const char* magic() { return "UNIDWAL1"; }
+
+    class Encoder {
+    private:
+        string& out;
+
+    public:
+        explicit Encoder(string& o) : out(o) {}
+
+        void i32(int32_t v) { out.append((const char*)&v, sizeof(v)); }
+        void u32(uint32_t v) { out.append((const char*)&v, sizeof(v)); }
+        void str(const string& s) {
+            u32((uint32_t)s.size());
+            out.append(s);
+        }
+        void ids(const HandleSet& handles, const SymbolTable& table) {
+            u32((uint32_t)handles.size());
+            for (Handle h : handles) str(table.name(h));
+        }
+    };
+
+    class Decoder {
+    private:
+        const char* p;
+        const char* end;
+        bool valid;
+
+    public:
+        Decoder(const char* data, size_t length) : p(data), end(data + length), valid(true) {}
+
+        bool ok() const { return valid && p == end; }
+
+        int32_t i32() { return (int32_t)u32(); }
+        uint32_t u32() {
+            uint32_t v = 0;
+            if (end - p < (ptrdiff_t)sizeof(v)) { valid = false; return 0; }
+            memcpy(&v, p, sizeof(v));
+            p += sizeof(v);
+            return v;
+        }
+        string str() {
+            uint32_t n = u32();
+            if (!valid || (size_t)(end - p) < n) { valid = false; return string(); }
+            string s(p, n);
+            p += n;
+            return s;
+        }
+        vector<string> ids() {
+            uint32_t n = u32();
+            vector<string> result;
+            for (uint32_t i = 0; i < n && valid; i++) result.push_back(str());
+            return result;
+        }
+    };
+
+    DataManager* dm;
+    string snapshotPath;
+    string logPath;
+    FILE* file;
+    uint64_t baseChecksum;
+    uint64_t logBytes;
+    uint64_t compactionThreshold;
+
+    mutex lock;
+    condition_variable flushed;
+    condition_variable wakeFlusher;
+    string pending;
+    uint64_t appendedRecords; // records handed to append()
+    uint64_t durableRecords;  // records known to be on disk
+    uint64_t syncCount;
+    bool flushing;
+    bool failed; // a torn write could not be removed; nothing more is accepted
+    bool stopping;
+    size_t groupSize;
+    chrono::milliseconds flushInterval;
+    thread flusher;
+
+    static uint32_t recordChecksum(const char* data, size_t length) {
+        uint64_t h = SnapshotFormat::checksum(data, length);
+        return (uint32_t)(h ^ (h >> 32));
+    }
+
+    static bool syncFile(FILE* f) {
+        if (fflush(f) != 0) return false;
+#if defined(_WIN32)
+        return _commit(_fileno(f)) == 0;
+#else
+        return fsync(fileno(f)) == 0;
+#endif
+    }
+
+    // Flushes a file written through another stream (the snapshot writer's
+    // ofstream) to disk.
+    static bool syncPath(const string& path) {
+        FILE* f = fopen(path.c_str(), "r+b");
+        if (!f) return false;
+        bool ok = syncFile(f);
+        fclose(f);
+        return ok;
+    }
+
+    // Makes a rename within the directory holding `path` durable.
+    static bool syncDirectory(const string& path) {
+#if defined(_WIN32)
+        (void)path;
+        return true;
+#else
+        size_t slash = path.find_last_of('/');
+        string dir = slash == string::npos ? string(".") : (slash == 0 ? string("/") : path.substr(0, slash));
+        int fd = ::open(dir.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        bool ok = fsync(fd) == 0;
+        ::close(fd);
+        return ok;
+#endif
+    }
+
+    static bool truncateFile(const string& path, uint64_t length) {
+#if defined(_WIN32)
+        FILE* f = fopen(path.c_str(), "r+b");
+        if (!f) return false;
+        bool ok = _chsize_s(_fileno(f), (long long)length) == 0;
+        fclose(f);
+        return ok;
+#else
+        return truncate(path.c_str(), (off_t)length) == 0;
+#endif
+    }
+
+    static bool replaceFile(const string& from, const string& to) {
+#if defined(_WIN32)
+        remove(to.c_str());
+#endif
+        return rename(from.c_str(), to.c_str()) == 0;
+    }
+
+    // Opens the log unbuffered, so a failed write leaves nothing behind in the
+    // stream to be written later behind the truncated tail.
+    static FILE* openLog(const string& path, const char* mode) {
+        FILE* f = fopen(path.c_str(), mode);
+        if (f) setvbuf(f, nullptr, _IONBF, 0);
+        return f;
+    }
+
+    static bool writeHeader(FILE* f, uint64_t base) {
+        LogHeader header;
+        memcpy(header.magic, magic(), sizeof(header.magic));
+        header.baseChecksum = base;
+        return fwrite(&header, sizeof(header), 1, f) == 1;
+    }
+
+    bool append(const string& payload) {
+        uint32_t length = (uint32_t)payload.size();
+        uint32_t check = recordChecksum(payload.data(), payload.size());
+
+        bool full;
+        {
+            lock_guard<mutex> guard(lock);
+            if (!file || failed) return false;
+            pending.append((const char*)&length, sizeof(length));
+            pending.append((const char*)&check, sizeof(check));
+            pending.append(payload);
+            appendedRecords++;
+            full = appendedRecords - durableRecords >= groupSize;
+        }
+        if (full) wakeFlusher.notify_one();
+        return true;
+    }
+
+    // Writes out everything pending. Called with `guard` held; releases it
+    // around the I/O so other threads can keep appending to the next group.
+    bool flushLocked(unique_lock<mutex>& guard) {
+        if (failed) return false;
+        if (pending.empty()) {
+            durableRecords = appendedRecords;
+            return true;
+        }
+
+        string batch;
+        batch.swap(pending);
+        uint64_t upTo = appendedRecords;
+        flushing = true;
+        guard.unlock();
+
+        bool ok = writeBatch(batch.data(), batch.size()) && syncFile(file);
+        bool torn = false;
+        if (!ok) {
+            // Cut off whatever part of the batch reached the file, so replay
+            // does not stop at a torn record in front of later, good ones.
+            clearerr(file);
+            torn = !truncateFile(logPath, logBytes) || fseek(file, (long)logBytes, SEEK_SET) != 0;
+        }
+
+        guard.lock();
+        flushing = false;
+        if (torn) failed = true;
+        if (ok) {
+            durableRecords = upTo;
+            logBytes += batch.size();
+            syncCount++;
+        }
+        else {
+            // Records appended during the write sit behind the failed batch.
+            batch.append(pending);
+            pending.swap(batch);
+        }
+        flushed.notify_all();
+        return ok;
+    }
+
+    void flusherLoop() {
+        unique_lock<mutex> guard(lock);
+        while (!stopping) {
+            wakeFlusher.wait_for(guard, flushInterval);
+            if (file && !flushing && !failed && !pending.empty()) flushLocked(guard);
+        }
+    }
+
+    void apply(uint8_t op, Decoder& in, RecoveryReport& report) {
+        bool applied = true;
+        switch (op) {
+        case OP_COURSE: {
+            string id = in.str(), name = in.str();
+            int credits = in.i32();
+            vector<string> prereqs = in.ids();
+            if (!in.ok()) break;
+            Course course(id, name, credits);
+            for (const string& p : prereqs) course.addPrerequisite(p);
+            applied = dm->addCourse(course);
+            break;
+        }
+        case OP_STUDENT: {
+            string id = in.str(), name = in.str();
+            int credits = in.i32();
+            vector<string> enrolled = in.ids(), completed = in.ids();
+            if (!in.ok()) break;
+            Student student(id, name);
+            HandleSet e, c;
+            for (const string& course : enrolled) e.insert(Symbols::courses().intern(course));
+            for (const string& course : completed) c.insert(Symbols::courses().intern(course));
+            student.restoreState(e, c, credits);
+            dm->addStudent(student);
+            break;
+        }
+        case OP_FACULTY: {
+            string id = in.str(), name = in.str();
+            int maxCourses = in.i32();
+            vector<string> assigned = in.ids();
+            if (!in.ok()) break;
+            Faculty fac(id, name, maxCourses);
+            for (const string& course : assigned) fac.assignCourse(course);
+            dm->addFaculty(fac);
+            break;
+        }
+        case OP_ROOM: {
+            string id = in.str();
+            int capacity = in.i32();
+            string type = in.str();
+            if (in.ok()) dm->addRoom(Room(id, capacity, type));
+            break;
+        }
+        case OP_LAB: {
+            string id = in.str(), course = in.str();
+            int capacity = in.i32();
+            vector<string> students = in.ids();
+            if (!in.ok()) break;
+            Lab lab(id, course, capacity);
+            for (const string& s : students) lab.enrollStudent(s);
+            dm->addLab(lab);
+            break;
+        }
+        case OP_ENROLL:
+        case OP_COMPLETE:
+        case OP_DROP: {
+            string studentID = in.str(), courseID = in.str();
+            int credits = in.i32();
+            Student* student = in.ok() ? dm->getStudent(studentID) : nullptr;
+            if (!student) { applied = false; break; }
+            if (op == OP_ENROLL) student->enrollCourse(courseID, credits);
+            else if (op == OP_COMPLETE) student->completeCourse(courseID, credits);
+            else student->dropCourse(courseID, credits);
+            break;
+        }
+        case OP_ASSIGN:
+        case OP_UNASSIGN: {
+            string facultyID = in.str(), courseID = in.str();
+            Faculty* fac = in.ok() ? dm->getFaculty(facultyID) : nullptr;
+            if (!fac) { applied = false; break; }
+            if (op == OP_ASSIGN) fac->assignCourse(courseID);
+            else fac->removeCourse(courseID);
+            break;
+        }
+        case OP_PREREQUISITES: {
+            string courseID = in.str();
+            vector<string> prereqs = in.ids();
+            Course* course = in.ok() ? dm->getCourse(courseID) : nullptr;
+            if (!course) { applied = false; break; }
+            applied = course->setPrerequisites(set<string>(prereqs.begin(), prereqs.end()));
+            break;
+        }
+        case OP_LAB_JOIN:
+        case OP_LAB_LEAVE: {
+            string labID = in.str(), studentID = in.str();
+            Lab* lab = in.ok() ? dm->getLab(labID) : nullptr;
+            if (!lab) { applied = false; break; }
+            if (op == OP_LAB_JOIN) lab->enrollStudent(studentID);
+            else lab->removeStudent(studentID);
+            break;
+        }
+        case OP_CLEAR:
+            if (in.ok()) dm->clearAll();
+            break;
+        default:
+            applied = false;
+        }
+
+        if (applied && in.ok()) report.recordsReplayed++;
+        else report.recordsSkipped++;
+    }
+
+    // Replays records from the log, returning the length of the valid prefix.
+    uint64_t replay(RecoveryReport& report) {
+        MappedFile mapped;
+        if (!mapped.open(logPath) || mapped.size() < sizeof(LogHeader)) return 0;
+
+        LogHeader header;
+        memcpy(&header, mapped.data(), sizeof(header));
+        if (memcmp(header.magic, magic(), sizeof(header.magic)) != 0) {
+            report.error = "not a mutation log: " + logPath;
+            return 0;
+        }
+        if (header.baseChecksum != baseChecksum) {
+            report.staleLogIgnored = true;
+            return 0;
+        }
+
+        const char* data = mapped.data();
+        uint64_t offset = sizeof(LogHeader);
+        dm->beginBatch();
+        while (mapped.size() - offset >= 2 * sizeof(uint32_t)) {
+            uint32_t length, check;
+            memcpy(&length, data + offset, sizeof(length));
+            memcpy(&check, data + offset + sizeof(length), sizeof(check));
+            const char* payload = data + offset + 2 * sizeof(uint32_t);
+            if (length == 0 || length > mapped.size() - offset - 2 * sizeof(uint32_t)) break;
+            if (recordChecksum(payload, length) != check) break;
+
+            Decoder in(payload + 1, length - 1);
+            apply((uint8_t)payload[0], in, report);
+            offset += 2 * sizeof(uint32_t) + length;
+        }
+        dm->endBatch();
+        report.tailTruncated = offset < mapped.size();
+        return offset;
+    }
+
+    bool startLog(uint64_t validLength) {
+        if (validLength < sizeof(LogHeader)) {
+            file = openLog(logPath, "wb");
+            if (!file || !writeHeader(file, baseChecksum) || !syncFile(file)) return false;
+            logBytes = sizeof(LogHeader);
+        }
+        else {
+            if (!truncateFile(logPath, validLength)) return false;
+            file = openLog(logPath, "ab");
+            if (!file) return false;
+            logBytes = validLength;
+        }
+        return true;
+    }
+
+    bool record(Op op, const string& body) {
+        string payload;
+        payload.reserve(body.size() + 1);
+        payload.push_back((char)op);
+        payload.append(body);
+        return append(payload);
+    }
+
+    static string pairBody(const string& a, const string& b) {
+        string body;
+        Encoder out(body);
+        out.str(a);
+        out.str(b);
+        return body;
+    }
+
+    static string membershipBody(Handle student, Handle course, int credits) {
+        string body = pairBody(Symbols::students().name(student), Symbols::courses().name(course));
+        Encoder(body).i32(credits);
+        return body;
+    }
+
+protected:
+    // Writes one batch to the end of the log. Tests override this to inject
+    // failed and short writes.
+    virtual bool writeBatch(const char* data, size_t length) {
+        return fwrite(data, 1, length, file) == length;
+    }
+
+public:
+    MutationLog()
+        : dm(nullptr), file(nullptr), baseChecksum(0), logBytes(0), compactionThreshold(4 << 20),
+          appendedRecords(0), durableRecords(0), syncCount(0), flushing(false), failed(false),
+          stopping(false), groupSize(256), flushInterval(10) {}
+
+    virtual ~MutationLog() { close(); }
+
+    bool isOpen() const { return file != nullptr; }
+    // True once a torn write could not be cut back off the log. Every later
+    // append and sync() fails until the log is reopened.
+    bool hasFailed() {
+        lock_guard<mutex> guard(lock);
+        return failed;
+    }
+    const string& getLogPath() const { return logPath; }
+    uint64_t getLogBytes() const { return logBytes; }
+    uint64_t getSyncCount() const { return syncCount; }
+
+    // Records per group before the flusher is woken early, and the longest a
+    // record may wait in memory before it is written out.
+    void setGroupCommit(size_t records, int intervalMs) {
+        groupSize = records ? records : 1;
+        flushInterval = chrono::milliseconds(intervalMs > 0 ? intervalMs : 1);
+    }
+    void setCompactionThreshold(uint64_t bytes) { compactionThreshold = bytes; }
+
+    // Loads <base>.snap, replays <base>.wal on top of it, then starts journaling
+    // every further change made to `manager`.
+    RecoveryReport open(DataManager& manager, const string& basePath) {
+        close();
+        RecoveryReport report;
+        dm = &manager;
+        snapshotPath = basePath + ".snap";
+        logPath = basePath + ".wal";
+        baseChecksum = 0;
+        failed = false;
+        pending.clear();
+        appendedRecords = durableRecords = 0;
+
+        FILE* probe = fopen(snapshotPath.c_str(), "rb");
+        if (probe) {
+            fclose(probe);
+            MappedSnapshot snapshot;
+            if (!snapshot.open(snapshotPath)) {
+                report.error = "snapshot: " + snapshot.error();
+                return report;
+            }
+            snapshot.loadInto(manager);
+            baseChecksum = snapshot.checksum();
+            report.snapshotLoaded = true;
+        }
+
+        uint64_t validLength = replay(report);
+        if (!report.error.empty()) return report;
+
+        if (!startLog(validLength)) {
+            report.error = "cannot open " + logPath + " for writing";
+            if (file) fclose(file);
+            file = nullptr;
+            return report;
+        }
+
+        stopping = false;
+        flusher = thread(&MutationLog::flusherLoop, this);
+        dm->addObserver(this);
+        return report;
+    }
+
+    // Blocks until every record appended so far is on disk. Concurrent callers
+    // share one write + fsync. Returns false if that write failed; the records
+    // stay pending and a later sync() retries them.
+    bool sync() {
+        unique_lock<mutex> guard(lock);
+        if (!file || failed) return false;
+        uint64_t target = appendedRecords;
+        while (durableRecords < target) {
+            if (flushing) {
+                flushed.wait(guard);
+            }
+            else if (!flushLocked(guard)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool needsCompaction() const { return file && logBytes >= compactionThreshold; }
+
+    // Folds the log into a fresh snapshot and starts an empty log on top of it.
+    // Call from a point where no other thread is mutating the DataManager.
+    bool compact() {
+        if (!file || !sync()) return false;
+
+        string tempSnapshot = snapshotPath + ".tmp";
+        SnapshotWriter writer;
+        if (!writer.write(*dm, tempSnapshot) || !syncPath(tempSnapshot)) return false;
+
+        MappedSnapshot written;
+        if (!written.open(tempSnapshot)) return false;
+        uint64_t newBase = written.checksum();
+        written.close();
+
+        string tempLog = logPath + ".tmp";
+        FILE* fresh = fopen(tempLog.c_str(), "wb");
+        if (!fresh) return false;
+        bool ok = writeHeader(fresh, newBase) && syncFile(fresh);
+        fclose(fresh);
+        if (!ok) return false;
+
+        // Once the snapshot is in place the old log no longer matches it, so a
+        // crash between the two renames still recovers correctly.
+        if (!replaceFile(tempSnapshot, snapshotPath) || !syncDirectory(snapshotPath)) return false;
+
+        unique_lock<mutex> guard(lock);
+        while (flushing) flushed.wait(guard);
+        fclose(file);
+        baseChecksum = newBase;
+        logBytes = sizeof(LogHeader);
+        if (replaceFile(tempLog, logPath)) {
+            file = openLog(logPath, "ab");
+            return file != nullptr && syncDirectory(logPath);
+        }
+
+        // The old log is still in place, but recovery now treats it as stale.
+        // Every record in it is in the snapshot, so restart it there; a crash
+        // before the header is down leaves a log too short to replay.
+        remove(tempLog.c_str());
+        file = openLog(logPath, "wb");
+        if (file && !(writeHeader(file, newBase) && syncFile(file))) {
+            fclose(file);
+            file = nullptr;
+        }
+        return file != nullptr;
+    }
+
+    void close() {
+        // The observer and the flusher are registered together at the end of
+        // open(); tear both down even if a failed compaction lost the file.
+        if (flusher.joinable()) {
+            dm->removeObserver(this);
+            if (file) sync();
+            {
+                lock_guard<mutex> guard(lock);
+                stopping = true;
+            }
+            wakeFlusher.notify_one();
+            flusher.join();
+        }
+        if (file) fclose(file);
+        file = nullptr;
+    }
+
+    void onCourseAdded(const Course& course) {
+        string body;
+        Encoder out(body);
+        out.str(course.getID());
+        out.str(course.getName());
+        out.i32(course.getCredits());
+        out.ids(course.getPrerequisiteHandles(), Symbols::courses());
+        record(OP_COURSE, body);
+    }
+
+    void onStudentAdded(const Student& student) {
+        string body;
+        Encoder out(body);
+        out.str(student.getID());
+        out.str(student.getName());
+        out.i32(student.getCurrentCredits());
+        out.ids(student.getEnrolledHandles(), Symbols::courses());
+        out.ids(student.getCompletedHandles(), Symbols::courses());
+        record(OP_STUDENT, body);
+    }
+
+    void onFacultyAdded(const Faculty& fac) {
+        string body;
+        Encoder out(body);
+        out.str(fac.getID());
+        out.str(fac.getName());
+        out.i32(fac.getMaxCourses());
+        out.ids(fac.getAssignedHandles(), Symbols::courses());
+        record(OP_FACULTY, body);
+    }
+
+    void onRoomAdded(const Room& room) {
+        string body;
+        Encoder out(body);
+        out.str(room.getID());
+        out.i32(room.getCapacity());
+        out.str(room.getType());
+        record(OP_ROOM, body);
+    }
+
+    void onLabAdded(const Lab& lab) {
+        string body;
+        Encoder out(body);
+        out.str(lab.getID());
+        out.str(lab.getAssociatedCourse());
+        out.i32(lab.getCapacity());
+        out.ids(lab.getEnrolledHandles(), Symbols::students());
+        record(OP_LAB, body);
+    }
+
+    void onEnrolled(Handle student, Handle course, int credits) {
+        record(OP_ENROLL, membershipBody(student, course, credits));
+    }
+    void onCompleted(Handle student, Handle course, int credits) {
+        record(OP_COMPLETE, membershipBody(student, course, credits));
+    }
+    void onDropped(Handle student, Handle course, int credits) {
+        record(OP_DROP, membershipBody(student, course, credits));
+    }
+
+    void onAssigned(Handle fac, Handle course) {
+        record(OP_ASSIGN, pairBody(Symbols::faculty().name(fac), Symbols::courses().name(course)));
+    }
+    void onUnassigned(Handle fac, Handle course) {
+        record(OP_UNASSIGN, pairBody(Symbols::faculty().name(fac), Symbols::courses().name(course)));
+    }
+
+    void onPrerequisitesUpdated(const Course& course) {
+        string body;
+        Encoder out(body);
+        out.str(course.getID());
+        out.ids(course.getPrerequisiteHandles(), Symbols::courses());
+        record(OP_PREREQUISITES, body);
+    }
+
+    void onLabJoined(Handle lab, Handle student) {
+        record(OP_LAB_JOIN, pairBody(Symbols::labs().name(lab), Symbols::students().name(student)));
+    }
+    void onLabLeft(Handle lab, Handle student) {
+        record(OP_LAB_LEAVE, pairBody(Symbols::labs().name(lab), Symbols::students().name(student)));
+    }
+
+    void onCleared() { record(OP_CLEAR, string()); }
+};
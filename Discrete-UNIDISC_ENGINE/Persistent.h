@@ -0,0 +1,155 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <iterator>
+
+using namespace std;
+
+// Copy-on-write vector stored as a 32-way trie of shared nodes. Copying one is
+// O(1): both copies share every node. A write copies only the nodes on the
+// path to its element (and that element's leaf) that are still shared, so a
+// change to a copy costs O(log32 n) and leaves the other copies untouched.
+//
+// Elements never move while their leaf is owned by one vector, so pointers
+// from mutableAt() stay valid until the vector is next copied.
+template<typename T>
+class PersistentVector {
+private:
+    static const size_t SHIFT = 5;
+    static const size_t WIDTH = 1 << SHIFT;
+    static const size_t MASK = WIDTH - 1;
+
+    struct Node {
+        vector<shared_ptr<Node>> children; // branch nodes
+        vector<T> items;                   // leaf nodes, capacity WIDTH
+    };
+
+    shared_ptr<Node> root;
+    size_t shift; // depth of the trie times SHIFT
+    size_t count;
+
+    static void own(shared_ptr<Node>& node) {
+        if (node.use_count() > 1) {
+            shared_ptr<Node> copy = make_shared<Node>();
+            copy->children = node->children;
+            copy->items.reserve(WIDTH);
+            copy->items.assign(node->items.begin(), node->items.end());
+            node = copy;
+        }
+    }
+
+    static void ownAll(shared_ptr<Node>& node) {
+        own(node);
+        for (shared_ptr<Node>& child : node->children) ownAll(child);
+    }
+
+    size_t capacity() const { return root ? (size_t)1 << (shift + SHIFT) : 0; }
+
+    const Node* leafFor(size_t i) const {
+        const Node* node = root.get();
+        for (size_t level = shift; level > 0; level -= SHIFT) {
+            node = node->children[(i >> level) & MASK].get();
+        }
+        return node;
+    }
+
+public:
+    PersistentVector() : shift(0), count(0) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    const T& at(size_t i) const { return leafFor(i)->items[i & MASK]; }
+    const T& operator[](size_t i) const { return at(i); }
+
+    // Copies whatever part of the path to element i is still shared.
+    T& mutableAt(size_t i) {
+        shared_ptr<Node>* node = &root;
+        own(*node);
+        for (size_t level = shift; level > 0; level -= SHIFT) {
+            node = &(*node)->children[(i >> level) & MASK];
+            own(*node);
+        }
+        return (*node)->items[i & MASK];
+    }
+
+    void push_back(const T& value) {
+        if (!root) {
+            root = make_shared<Node>();
+            root->items.reserve(WIDTH);
+        }
+        else if (count == capacity()) {
+            shared_ptr<Node> grown = make_shared<Node>();
+            grown->children.push_back(root);
+            root = grown;
+            shift += SHIFT;
+        }
+
+        shared_ptr<Node>* node = &root;
+        own(*node);
+        for (size_t level = shift; level > 0; level -= SHIFT) {
+            size_t slot = (count >> level) & MASK;
+            if (slot == (*node)->children.size()) {
+                shared_ptr<Node> fresh = make_shared<Node>();
+                if (level == SHIFT) fresh->items.reserve(WIDTH);
+                (*node)->children.push_back(fresh);
+            }
+            node = &(*node)->children[slot];
+            own(*node);
+        }
+        (*node)->items.push_back(value);
+        count++;
+    }
+
+    void resize(size_t n, const T& value) {
+        while (count < n) push_back(value);
+    }
+
+    void clear() {
+        root.reset();
+        shift = 0;
+        count = 0;
+    }
+
+    // Gives this vector private copies of every shared node, so later writes
+    // never copy. Needed before writers on several threads share the vector.
+    void detach() {
+        if (root) ownAll(root);
+    }
+
+    // Walks leaf by leaf, so stepping costs O(1) except at leaf boundaries.
+    class const_iterator {
+    private:
+        const PersistentVector* owner;
+        size_t index;
+        const T* leaf;
+
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const T* pointer;
+        typedef const T& reference;
+
+        const_iterator(const PersistentVector* v, size_t i) : owner(v), index(i), leaf(nullptr) {
+            if (index < owner->count) leaf = owner->leafFor(index)->items.data();
+        }
+
+        const T& operator*() const { return leaf[index & MASK]; }
+        const T* operator->() const { return &leaf[index & MASK]; }
+
+        const_iterator& operator++() {
+            index++;
+            if ((index & MASK) == 0 && index < owner->count) leaf = owner->leafFor(index)->items.data();
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const { return index == other.index; }
+        bool operator!=(const const_iterator& other) const { return index != other.index; }
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, count); }
+};
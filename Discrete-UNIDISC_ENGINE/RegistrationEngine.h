@@ -0,0 +1,229 @@
+#pragma once
+
+#include "Core.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+// Thread-safe enroll/drop/complete and lab seat path over a DataManager.
+//
+// Each request locks only its student's stripe, so requests for different
+// students run in parallel; the DataManager locks the course's stripe while
+// it updates that course's roster index. Lab seats are counted with an atomic
+// counter per lab, claimed under the lab's stripe once membership is checked,
+// so a lab can never be over-filled and a duplicate join never holds a seat.
+//
+// Records must not be added to the DataManager while requests are in flight;
+// call refresh() after adding students, courses or labs. The engine holds the
+// DataManager's publishing for its lifetime, so its writers never publish;
+// readers running alongside see the versions handed out by publish().
+class RegistrationEngine {
+public:
+    enum Status {
+        OK,
+        UNKNOWN_STUDENT,
+        UNKNOWN_COURSE,
+        UNKNOWN_LAB,
+        ALREADY_ENROLLED,
+        NOT_ENROLLED,
+        MISSING_PREREQUISITES,
+        LAB_FULL,
+        ALREADY_IN_LAB,
+        NOT_IN_LAB
+    };
+
+    static const char* describe(Status status) {
+        switch (status) {
+        case OK: return "ok";
+        case UNKNOWN_STUDENT: return "unknown student";
+        case UNKNOWN_COURSE: return "unknown course";
+        case UNKNOWN_LAB: return "unknown lab";
+        case ALREADY_ENROLLED: return "already enrolled";
+        case NOT_ENROLLED: return "not enrolled";
+        case MISSING_PREREQUISITES: return "missing prerequisites";
+        case LAB_FULL: return "lab is full";
+        case ALREADY_IN_LAB: return "already in lab";
+        case NOT_IN_LAB: return "not in lab";
+        }
+        return "unknown status";
+    }
+
+private:
+    struct Stripe {
+        mutex lock;
+        char pad[64]; // keep neighbouring stripes off the same cache line
+    };
+
+    static const size_t STRIPES = 256;
+
+    DataManager& dm;
+    unique_ptr<Stripe[]> studentStripes;
+    unique_ptr<Stripe[]> labStripes;
+    unique_ptr<atomic<int>[]> labSeats; // seats taken, indexed by lab handle
+    size_t labSlots;
+
+    mutex& studentLock(Handle student) { return studentStripes[student % STRIPES].lock; }
+    mutex& labLock(Handle lab) { return labStripes[lab % STRIPES].lock; }
+
+    Status change(Handle studentHandle, Handle courseHandle, DataManager::EnrollmentChange::Kind kind) {
+        Student* student = dm.getStudent(studentHandle);
+        if (!student) return UNKNOWN_STUDENT;
+        const Course* course = dm.view().getCourse(courseHandle);
+        if (!course) return UNKNOWN_COURSE;
+
+        lock_guard<mutex> guard(studentLock(studentHandle));
+        bool enrolled = student->getEnrolledHandles().contains(courseHandle);
+
+        switch (kind) {
+        case DataManager::EnrollmentChange::ENROLL: {
+            if (enrolled) return ALREADY_ENROLLED;
+            const EnrollmentBits& bits = dm.getEnrollmentBits();
+            if (!BitOps::isSubset(bits.prerequisitesOf(courseHandle), bits.completedCourses(studentHandle),
+                bits.courseWords())) {
+                return MISSING_PREREQUISITES;
+            }
+            student->enrollCourse(courseHandle, course->getCredits());
+            break;
+        }
+        case DataManager::EnrollmentChange::COMPLETE:
+            if (!enrolled) return NOT_ENROLLED;
+            student->completeCourse(courseHandle, course->getCredits());
+            break;
+        case DataManager::EnrollmentChange::DROP:
+            if (!enrolled) return NOT_ENROLLED;
+            student->dropCourse(courseHandle, course->getCredits());
+            break;
+        }
+        return OK;
+    }
+
+public:
+    explicit RegistrationEngine(DataManager& manager)
+        : dm(manager), studentStripes(new Stripe[STRIPES]), labStripes(new Stripe[STRIPES]), labSlots(0) {
+        dm.holdPublishing();
+        refresh();
+    }
+
+    // Publishes whatever changed since the last publish().
+    ~RegistrationEngine() { dm.releasePublishing(); }
+
+    // Re-sizes indexes and seat counters after records were added. Not thread-safe.
+    void refresh() {
+        dm.reserveIndexes();
+        labSlots = Symbols::labs().size();
+        labSeats.reset(new atomic<int>[labSlots]);
+        for (size_t h = 0; h < labSlots; h++) {
+            const Lab* lab = dm.view().getLab((Handle)h);
+            labSeats[h].store(lab ? (int)lab->getEnrolledHandles().size() : 0);
+        }
+    }
+
+    // Enrolls after checking that every prerequisite has been completed.
+    Status enroll(Handle student, Handle course) { return change(student, course, DataManager::EnrollmentChange::ENROLL); }
+    Status drop(Handle student, Handle course) { return change(student, course, DataManager::EnrollmentChange::DROP); }
+    Status complete(Handle student, Handle course) { return change(student, course, DataManager::EnrollmentChange::COMPLETE); }
+
+    Status enroll(const string& student, const string& course) {
+        return enroll(Symbols::students().find(student), Symbols::courses().find(course));
+    }
+    Status drop(const string& student, const string& course) {
+        return drop(Symbols::students().find(student), Symbols::courses().find(course));
+    }
+    Status complete(const string& student, const string& course) {
+        return complete(Symbols::students().find(student), Symbols::courses().find(course));
+    }
+
+    // Takes a seat in a lab section of a course the student is enrolled in.
+    Status joinLab(Handle studentHandle, Handle labHandle) {
+        if (!dm.view().getStudent(studentHandle)) return UNKNOWN_STUDENT;
+        Lab* lab = labHandle < labSlots ? dm.getLab(labHandle) : nullptr;
+        if (!lab) return UNKNOWN_LAB;
+
+        lock_guard<mutex> guard(studentLock(studentHandle));
+        if (!dm.view().getStudent(studentHandle)->getEnrolledHandles().contains(lab->getAssociatedCourseHandle())) {
+            return NOT_ENROLLED;
+        }
+
+        lock_guard<mutex> labGuard(labLock(labHandle));
+        if (lab->getEnrolledHandles().contains(studentHandle)) return ALREADY_IN_LAB;
+
+        atomic<int>& seats = labSeats[labHandle];
+        if (seats.fetch_add(1) >= lab->getCapacity()) {
+            seats.fetch_sub(1);
+            return LAB_FULL;
+        }
+        lab->enrollStudent(studentHandle);
+        return OK;
+    }
+
+    Status leaveLab(Handle studentHandle, Handle labHandle) {
+        Lab* lab = labHandle < labSlots ? dm.getLab(labHandle) : nullptr;
+        if (!lab) return UNKNOWN_LAB;
+
+        lock_guard<mutex> guard(studentLock(studentHandle));
+        lock_guard<mutex> labGuard(labLock(labHandle));
+        if (!lab->getEnrolledHandles().contains(studentHandle)) return NOT_IN_LAB;
+        lab->removeStudent(studentHandle);
+        labSeats[labHandle].fetch_sub(1);
+        return OK;
+    }
+
+    int seatsTaken(Handle lab) const { return lab < labSlots ? labSeats[lab].load() : 0; }
+
+    // Publishes a new catalog version for readers. Every student stripe is
+    // held for the duration, so no enrollment change is half-applied in it.
+    // The version is built from the previous one and costs about what changed
+    // since; readers keep using the previous version meanwhile and never wait.
+    shared_ptr<const CatalogVersion> publish() {
+        vector<unique_lock<mutex>> held;
+        held.reserve(STRIPES);
+        for (size_t i = 0; i < STRIPES; i++) held.push_back(unique_lock<mutex>(studentStripes[i].lock));
+        return dm.publish();
+    }
+
+    // Checks, once requests have stopped, that no lab is over capacity or out of
+    // step with its seat counter and that every course roster index matches
+    // the students' own enrollment sets. Describes the first problem found.
+    bool verifyInvariants(string& failure) const {
+        for (const Lab& lab : dm.getAllLabs()) {
+            int size = (int)lab.getEnrolledHandles().size();
+            if (size > lab.getCapacity()) {
+                failure = "lab " + lab.getID() + " over capacity";
+                return false;
+            }
+            if (size != seatsTaken(lab.getHandle())) {
+                failure = "lab " + lab.getID() + " seat counter out of step";
+                return false;
+            }
+        }
+
+        size_t rosterEntries = 0;
+        for (const Course& course : dm.getAllCourses()) {
+            for (Handle student : dm.getEnrolledStudents(course.getHandle())) {
+                const Student* record = dm.view().getStudent(student);
+                if (!record || !record->getEnrolledHandles().contains(course.getHandle()) ||
+                    !dm.getEnrollmentBits().isEnrolled(student, course.getHandle())) {
+                    failure = "roster of " + course.getID() + " lists a student who is not enrolled";
+                    return false;
+                }
+                rosterEntries++;
+            }
+        }
+
+        size_t enrollments = 0;
+        for (const Student& student : dm.getAllStudents()) {
+            for (Handle course : student.getEnrolledHandles()) {
+                if (dm.view().getCourse(course)) enrollments++;
+            }
+        }
+        if (enrollments != rosterEntries) {
+            failure = "roster index is missing enrollments";
+            return false;
+        }
+        return true;
+    }
+};
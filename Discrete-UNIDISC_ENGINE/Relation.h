@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Core.h"
+#include "Arena.h"
+#include "SparseRelation.h"
 #include <string>
 #include <set>
 #include <map>
@@ -8,8 +10,31 @@
 #include <algorithm>
 
 class RelationsModule {
+public:
+    // A failed property check, by name: which property failed and the
+    // counterexample RelationCheck describes for it.
+    struct Counterexample {
+        enum Property { NONE, REFLEXIVE, SYMMETRIC, ANTISYMMETRIC, TRANSITIVE };
+
+        Property property;
+        string a, b, c;
+
+        Counterexample() : property(NONE) {}
+        bool found() const { return property != NONE; }
+
+        string describe() const {
+            switch (property) {
+            case REFLEXIVE: return "(" + a + ", " + a + ") is missing";
+            case SYMMETRIC: return "(" + a + ", " + b + ") without (" + b + ", " + a + ")";
+            case ANTISYMMETRIC: return "(" + a + ", " + b + ") and (" + b + ", " + a + ")";
+            case TRANSITIVE: return "(" + a + ", " + b + ") and (" + b + ", " + c + ") without (" + a + ", " + c + ")";
+            default: return "none";
+            }
+        }
+    };
+
 private:
-    DataManager* dm;
+    const DataManager* dm;
 
     typedef pair<string, string> Pair;
     typedef set<Pair> Relation;
@@ -19,125 +44,195 @@ private:
     Relation courseRoomRelation;
     Relation prerequisiteRelation;
 
+    struct NameLess {
+        bool operator()(const string* a, const string* b) const { return *a < *b; }
+    };
+
+    static SparseRelation indexed(const Relation& R, const set<string>& domain, NameIndex& names) {
+        for (const string& elem : domain) names.intern(elem);
+        vector<SparseRelation::Edge> pairs;
+        pairs.reserve(R.size());
+        for (const Pair& p : R) pairs.push_back(SparseRelation::Edge(names.intern(p.first), names.intern(p.second)));
+        return SparseRelation(names.size(), names.size(), pairs);
+    }
+
+    static Counterexample named(const RelationCheck& check, Counterexample::Property property, const NameIndex& names) {
+        Counterexample failure;
+        if (check.holds) return failure;
+        failure.property = property;
+        failure.a = names.name(check.a);
+        failure.b = names.name(check.b);
+        if (property == Counterexample::TRANSITIVE) failure.c = names.name(check.c);
+        return failure;
+    }
+
+    set<string> closureNames(const uint64_t* row) const {
+        set<string> names;
+        BitOps::forEachSetBit(row, dm->getEnrollmentBits().courseWords(), [&](Handle course) {
+            names.insert(Symbols::courses().name(course));
+        });
+        return names;
+    }
+
+
 public:
-    RelationsModule() {
-        dm = DataManager::getInstance();
+    explicit RelationsModule(DataManager* manager) {
+        dm = manager;
         buildRelations();
     }
 
-    void buildRelations() {
+    void buildRelations() { buildRelations(*dm->snapshot()); }
+
+    void buildRelations(const CatalogVersion& version) {
         studentCourseRelation.clear();
         facultyCourseRelation.clear();
         courseRoomRelation.clear();
         prerequisiteRelation.clear();
 
-        for (auto& pair : dm->getAllStudents()) {
-            Student& student = pair.second;
-            for (const string& courseID : student.getEnrolledCourses()) {
-                studentCourseRelation.insert({ student.getID(), courseID });
+        const CatalogColumns& columns = version.columns;
+        for (size_t row = 0; row < columns.studentCount(); row++) {
+            for (Handle course : columns.enrolled(row)) {
+                studentCourseRelation.insert({ columns.studentID(row), Symbols::courses().name(course) });
             }
         }
 
-        for (auto& pair : dm->getAllFaculty()) {
-            Faculty& faculty = pair.second;
-            for (const string& courseID : faculty.getAssignedCourses()) {
-                facultyCourseRelation.insert({ faculty.getID(), courseID });
+        for (size_t row = 0; row < columns.facultyCount(); row++) {
+            for (Handle course : columns.assigned(row)) {
+                facultyCourseRelation.insert({ columns.facultyID(row), Symbols::courses().name(course) });
             }
         }
         
-        for (auto& pair : dm->getAllCourses()) {
-            Course& course = pair.second;
-            for (const string& prereq : course.getPrerequisites()) {
-                prerequisiteRelation.insert({ course.getID(), prereq });
+        for (size_t row = 0; row < columns.courseCount(); row++) {
+            for (Handle prereq : columns.prerequisites(row)) {
+                prerequisiteRelation.insert({ columns.courseID(row), Symbols::courses().name(prereq) });
             }
         }
     }
 
-    bool isReflexive(const Relation& R, const set<string>& domain) {
-        for (const string& elem : domain) {
-            if (R.find({ elem, elem }) == R.end()) {
-                return false;
-            }
-        }
-        return true;
+    // Direct and indirect prerequisites of a course, from the closure the
+    // DataManager keeps current as prerequisites change.
+    set<string> allPrerequisitesOf(const string& courseID) {
+        return closureNames(dm->getEnrollmentBits().allPrerequisitesOf(Symbols::courses().find(courseID)));
     }
 
-    bool isSymmetric(const Relation& R) {
-        for (const Pair& p : R) {
-            if (R.find({ p.second, p.first }) == R.end()) {
-                return false;
-            }
-        }
-        return true;
+    // Courses that need this one directly or indirectly.
+    set<string> coursesRequiring(const string& courseID) {
+        return closureNames(dm->getEnrollmentBits().coursesRequiring(Symbols::courses().find(courseID)));
     }
 
-    bool isTransitive(const Relation& R) {
-        for (const Pair& p1 : R) {
-            for (const Pair& p2 : R) {
-                if (p1.second == p2.first) {
-                    if (R.find({ p1.first, p2.second }) == R.end()) {
-                        return false;
-                    }
-                }
-            }
-        }
-        return true;
+    // Property checks number the elements of R (and of the domain, if any)
+    // and run on the sparse form: O(|R|) per check apart from transitivity,
+    // which costs at most one word per 64 elements for each pair of R.
+    // 0 threads means one per hardware thread.
+    Counterexample findNonReflexive(const Relation& R, const set<string>& domain) {
+        NameIndex names;
+        SparseRelation sparse = indexed(R, domain, names);
+        vector<uint32_t> ids;
+        for (const string& elem : domain) ids.push_back(names.find(elem));
+        return named(sparse.checkReflexive(ids), Counterexample::REFLEXIVE, names);
+    }
+
+    Counterexample findNonSymmetric(const Relation& R, unsigned threads = 0) {
+        NameIndex names;
+        return named(indexed(R, set<string>(), names).checkSymmetric(threads), Counterexample::SYMMETRIC, names);
+    }
+
+    Counterexample findNonAntisymmetric(const Relation& R, unsigned threads = 0) {
+        NameIndex names;
+        return named(indexed(R, set<string>(), names).checkAntisymmetric(threads), Counterexample::ANTISYMMETRIC, names);
+    }
+
+    Counterexample findNonTransitive(const Relation& R, unsigned threads = 0) {
+        NameIndex names;
+        return named(indexed(R, set<string>(), names).checkTransitive(threads), Counterexample::TRANSITIVE, names);
+    }
+
+    // First of reflexivity, antisymmetry and transitivity to fail.
+    Counterexample findNonPartialOrder(const Relation& R, const set<string>& domain, unsigned threads = 0) {
+        NameIndex names;
+        SparseRelation sparse = indexed(R, domain, names);
+        vector<uint32_t> ids;
+        for (const string& elem : domain) ids.push_back(names.find(elem));
+        Counterexample failure = named(sparse.checkReflexive(ids), Counterexample::REFLEXIVE, names);
+        if (!failure.found()) failure = named(sparse.checkAntisymmetric(threads), Counterexample::ANTISYMMETRIC, names);
+        if (!failure.found()) failure = named(sparse.checkTransitive(threads), Counterexample::TRANSITIVE, names);
+        return failure;
     }
 
+    bool isReflexive(const Relation& R, const set<string>& domain) { return !findNonReflexive(R, domain).found(); }
+    bool isSymmetric(const Relation& R) { return !findNonSymmetric(R).found(); }
+    bool isTransitive(const Relation& R) { return !findNonTransitive(R).found(); }
+
     bool isEquivalenceRelation(const Relation& R, const set<string>& domain) {
         return isReflexive(R, domain) && isSymmetric(R) && isTransitive(R);
     }
 
-    Relation composeRelations(const Relation& R1, const Relation& R2) {
-        Relation result;
+    // Names are mapped to dense IDs and the join runs as a sparse product;
+    // pairs of R2 whose first element never occurs in R1 are skipped.
+    Relation composeRelations(const Relation& R1, const Relation& R2, unsigned threads = 0) {
+        NameIndex left, middle, right;
+        vector<SparseRelation::Edge> first, second;
+        for (const Pair& p : R1) first.push_back(SparseRelation::Edge(left.intern(p.first), middle.intern(p.second)));
+        for (const Pair& p : R2) {
+            uint32_t m = middle.find(p.first);
+            if (m < middle.size()) second.push_back(SparseRelation::Edge(m, right.intern(p.second)));
+        }
 
-        for (const Pair& p1 : R1) {
-            for (const Pair& p2 : R2) {
-                if (p1.second == p2.first) {
-                    result.insert({ p1.first, p2.second });
-                }
+        SparseRelation product = SparseRelation(left.size(), middle.size(), first)
+            .compose(SparseRelation(middle.size(), right.size(), second), threads);
+        Relation result;
+        for (size_t a = 0; a < product.rows(); a++) {
+            for (const uint32_t* c = product.rowBegin(a); c != product.rowEnd(a); ++c) {
+                result.insert(Pair(left.name((uint32_t)a), right.name(*c)));
             }
         }
-
         return result;
     }
 
-    bool isPartialOrder(const Relation& R, const set<string>& domain) {
-     
-        if (!isReflexive(R, domain)) return false;
-
-        for (const Pair& p : R) {
-            if (p.first != p.second && R.find({ p.second, p.first }) != R.end()) {
-                return false;
-            }
+    // Enrollments and teaching assignments of a catalog version, with
+    // student and faculty rows of its columns and course handles.
+    static SparseRelation studentCourseMatrix(const CatalogColumns& columns) {
+        vector<SparseRelation::Edge> pairs;
+        for (size_t row = 0; row < columns.studentCount(); row++) {
+            for (Handle course : columns.enrolled(row)) pairs.push_back(SparseRelation::Edge((uint32_t)row, course));
         }
+        return SparseRelation(columns.studentCount(), Symbols::courses().size(), pairs);
+    }
 
-        if (!isTransitive(R)) return false;
-
-        return true;
+    static SparseRelation facultyCourseMatrix(const CatalogColumns& columns) {
+        vector<SparseRelation::Edge> pairs;
+        for (size_t row = 0; row < columns.facultyCount(); row++) {
+            for (Handle course : columns.assigned(row)) pairs.push_back(SparseRelation::Edge((uint32_t)row, course));
+        }
+        return SparseRelation(columns.facultyCount(), Symbols::courses().size(), pairs);
     }
+
+    bool isPartialOrder(const Relation& R, const set<string>& domain) { return !findNonPartialOrder(R, domain).found(); }
     
     void detectIndirectConflicts() {
         cout << "\n=== DETECTING INDIRECT COURSE CONFLICTS ===" << endl;
         cout << "Using relation composition to find hidden conflicts...\n" << endl;
         
-        buildRelations();
+        // The whole report reads one catalog version, so enrollments changing
+        // mid-report cannot produce conflicts that never existed.
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
+        const CatalogColumns& columns = version->columns;
+        buildRelations(*version);
         
         int conflictCount = 0;
         cout << "--- Type 1: Prerequisite Conflicts ---" << endl;
-        for (auto& studentPair : dm->getAllStudents()) {
-            Student& student = studentPair.second;
-            set<string> enrolled = student.getEnrolledCourses();
+        for (size_t row = 0; row < columns.studentCount(); row++) {
+            HandleRange enrolled = columns.enrolled(row);
             
-            for (const string& courseID : enrolled) {
-                Course* course = dm->getCourse(courseID);
-                if (!course) continue;
+            for (Handle course : enrolled) {
+                size_t courseRow = columns.courseRow(course);
+                if (courseRow == CatalogColumns::NO_ROW) continue;
                 
-                for (const string& prereq : course->getPrerequisites()) {
-                    if (enrolled.find(prereq) != enrolled.end()) {
-                        cout << "CONFLICT: Student " << student.getID() 
-                             << " enrolled in " << courseID 
-                             << " and its prerequisite " << prereq 
+                for (Handle prereq : columns.prerequisites(courseRow)) {
+                    if (enrolled.contains(prereq)) {
+                        cout << "CONFLICT: Student " << columns.studentID(row) 
+                             << " enrolled in " << Symbols::courses().name(course) 
+                             << " and its prerequisite " << Symbols::courses().name(prereq) 
                              << " simultaneously!" << endl;
                         conflictCount++;
                     }
@@ -145,37 +240,43 @@ public:
             }
         }
         
+        // The Type 2 index is bump-allocated from this arena and freed in one go on return.
+        MonotonicArena arena;
+
         cout << "\n--- Type 2: Common Prerequisite Conflicts ---" << endl;
-        map<string, set<string>> prereqToAdvanced;
+        ArenaMap<const string*, ArenaVector<Handle>, NameLess> prereqToAdvanced{
+            NameLess(), ArenaAllocator<pair<const string* const, ArenaVector<Handle>>>(arena) };
         
-        for (auto& coursePair : dm->getAllCourses()) {
-            Course& course = coursePair.second;
-            for (const string& prereq : course.getPrerequisites()) {
-                prereqToAdvanced[prereq].insert(course.getID());
+        // Course rows are in ID order, so each list of advanced courses comes out sorted.
+        for (size_t row = 0; row < columns.courseCount(); row++) {
+            for (Handle prereq : columns.prerequisites(row)) {
+                const string* name = &Symbols::courses().name(prereq);
+                auto it = prereqToAdvanced.find(name);
+                if (it == prereqToAdvanced.end()) {
+                    it = prereqToAdvanced.emplace(name, ArenaVector<Handle>(ArenaAllocator<Handle>(arena))).first;
+                }
+                it->second.push_back(columns.courseHandle(row));
             }
         }
         
-        for (auto& studentPair : dm->getAllStudents()) {
-            Student& student = studentPair.second;
-            set<string> enrolled = student.getEnrolledCourses();
+        for (size_t row = 0; row < columns.studentCount(); row++) {
+            HandleRange enrolled = columns.enrolled(row);
             
             for (const auto& prereqPair : prereqToAdvanced) {
-                const string& prereq = prereqPair.first;
-                const set<string>& advancedCourses = prereqPair.second;
+                const string& prereq = *prereqPair.first;
+                const ArenaVector<Handle>& advancedCourses = prereqPair.second;
                 
-                set<string> studentAdvanced;
-                for (const string& adv : advancedCourses) {
-                    if (enrolled.find(adv) != enrolled.end()) {
-                        studentAdvanced.insert(adv);
-                    }
+                size_t studentAdvanced = 0;
+                for (Handle adv : advancedCourses) {
+                    if (enrolled.contains(adv)) studentAdvanced++;
                 }
                 
-                if (studentAdvanced.size() > 2) {
-                    cout << "INDIRECT CONFLICT: Student " << student.getID() 
-                         << " enrolled in " << studentAdvanced.size() 
+                if (studentAdvanced > 2) {
+                    cout << "INDIRECT CONFLICT: Student " << columns.studentID(row) 
+                         << " enrolled in " << studentAdvanced 
                          << " courses requiring " << prereq << ": ";
-                    for (const string& c : studentAdvanced) {
-                        cout << c << " ";
+                    for (Handle c : advancedCourses) {
+                        if (enrolled.contains(c)) cout << Symbols::courses().name(c) << " ";
                     }
                     cout << endl;
                     conflictCount++;
@@ -184,17 +285,15 @@ public:
         }
         
         cout << "\n--- Type 3: Faculty Assignment Conflicts ---" << endl;
-        Relation studentToFaculty = composeRelations(studentCourseRelation, facultyCourseRelation);
-        
-        map<string, set<string>> studentFacultyMap;
-        for (const Pair& p : studentToFaculty) {
-            studentFacultyMap[p.first].insert(p.second);
-        }
-        
-        for (const auto& sfPair : studentFacultyMap) {
-            if (sfPair.second.size() > 3) {
-                cout << "Student " << sfPair.first 
-                     << " has courses from " << sfPair.second.size() 
+        // Student -> course joined with course -> faculty, the transpose of
+        // the assignments; each student row lists its distinct faculty.
+        SparseRelation studentToFaculty = studentCourseMatrix(columns).compose(facultyCourseMatrix(columns).transpose());
+        for (size_t row = 0; row < studentToFaculty.rows(); row++) {
+            size_t facultyCount = studentToFaculty.rowSize(row);
+            
+            if (facultyCount > 3) {
+                cout << "Student " << columns.studentID(row) 
+                     << " has courses from " << facultyCount 
                      << " different faculty (possible scheduling conflict)" << endl;
                 conflictCount++;
             }
@@ -202,49 +301,28 @@ public:
         
         cout << "\n--- Type 4: Transitive Prerequisite Violations ---" << endl;
         
-        Relation transitiveClosure = prerequisiteRelation;
-        bool changed = true;
-        int iterations = 0;
-        const int MAX_ITER = 100;
-        
-        while (changed && iterations < MAX_ITER) {
-            changed = false;
-            iterations++;
-            Relation newPairs = transitiveClosure;
-            
-            for (const Pair& p1 : transitiveClosure) {
-                for (const Pair& p2 : transitiveClosure) {
-                    if (p1.second == p2.first) {
-                        Pair newPair = {p1.first, p2.second};
-                        if (transitiveClosure.find(newPair) == transitiveClosure.end()) {
-                            newPairs.insert(newPair);
-                            changed = true;
-                        }
-                    }
-                }
-            }
-            transitiveClosure = newPairs;
-        }
-        
-        for (auto& studentPair : dm->getAllStudents()) {
-            Student& student = studentPair.second;
+        // One bit row of direct and indirect prerequisites per course, checked
+        // word by word against the student's completed courses.
+        const EnrollmentBits& bits = version->bits;
+        vector<Handle> missing;
+        for (size_t row = 0; row < columns.studentCount(); row++) {
+            const uint64_t* completed = bits.completedCourses(columns.studentHandle(row));
             
-            for (const string& enrolledCourse : student.getEnrolledCourses()) {
-                set<string> allPrereqs;
-                for (const Pair& p : transitiveClosure) {
-                    if (p.first == enrolledCourse) {
-                        allPrereqs.insert(p.second);
-                    }
+            for (Handle course : columns.enrolled(row)) {
+                const uint64_t* required = bits.allPrerequisitesOf(course);
+                missing.clear();
+                for (size_t w = 0; w < bits.courseWords(); w++) {
+                    uint64_t open = required[w] & ~completed[w];
+                    for (; open; open &= open - 1) missing.push_back((Handle)(w * 64 + BitOps::lowestBit(open)));
                 }
-                
-                // Check if all are completed
-                for (const string& prereq : allPrereqs) {
-                    if (student.getCompletedCourses().find(prereq) == student.getCompletedCourses().end()) {
-                        cout << "TRANSITIVE VIOLATION: Student " << student.getID()
-                             << " enrolled in " << enrolledCourse
-                             << " without completing indirect prerequisite " << prereq << endl;
-                        conflictCount++;
-                    }
+                sort(missing.begin(), missing.end(), [](Handle a, Handle b) {
+                    return Symbols::courses().name(a) < Symbols::courses().name(b);
+                });
+                for (Handle prereq : missing) {
+                    cout << "TRANSITIVE VIOLATION: Student " << columns.studentID(row)
+                         << " enrolled in " << Symbols::courses().name(course)
+                         << " without completing indirect prerequisite " << Symbols::courses().name(prereq) << endl;
+                    conflictCount++;
                 }
             }
         }
@@ -278,21 +356,25 @@ public:
 
         cout << "\n--- Relation Properties ---" << endl;
         set<string> students;
-        for (auto& pair : dm->getAllStudents()) {
-            students.insert(pair.first);
+        for (const Student& student : dm->getAllStudents()) {
+            students.insert(student.getID());
         }
 
+        auto verdict = [](const Counterexample& failure) {
+            return failure.found() ? "No: " + failure.describe() : string("Yes");
+        };
         cout << "Student-Course Relation:" << endl;
-        cout << "  Reflexive: " << (isReflexive(studentCourseRelation, students) ? "Yes" : "No") << endl;
-        cout << "  Symmetric: " << (isSymmetric(studentCourseRelation) ? "Yes" : "No") << endl;
-        cout << "  Transitive: " << (isTransitive(studentCourseRelation) ? "Yes" : "No") << endl;
+        cout << "  Reflexive: " << verdict(findNonReflexive(studentCourseRelation, students)) << endl;
+        cout << "  Symmetric: " << verdict(findNonSymmetric(studentCourseRelation)) << endl;
+        cout << "  Transitive: " << verdict(findNonTransitive(studentCourseRelation)) << endl;
         
         cout << "\nPrerequisite Relation:" << endl;
         set<string> courses;
-        for (auto& pair : dm->getAllCourses()) {
-            courses.insert(pair.first);
+        for (const Course& course : dm->getAllCourses()) {
+            courses.insert(course.getID());
         }
-        cout << "  Is Partial Order: " << (isPartialOrder(prerequisiteRelation, courses) ? "Yes (with reflexive pairs)" : "No") << endl;
+        Counterexample orderFailure = findNonPartialOrder(prerequisiteRelation, courses);
+        cout << "  Is Partial Order: " << (orderFailure.found() ? verdict(orderFailure) : "Yes (with reflexive pairs)") << endl;
 
         if (!studentCourseRelation.empty() && !facultyCourseRelation.empty()) {
             Relation composed = composeRelations(studentCourseRelation, facultyCourseRelation);
@@ -0,0 +1,339 @@
+#pragma once
+
+#include "BitMatrix.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+
+using namespace std;
+
+// Compressed set of 32-bit handles. Handles are grouped by their high 16 bits
+// into containers of up to 65536 values, each stored in whichever form is
+// smallest for its contents:
+//   ARRAY   sorted 16-bit values, for up to 4096 members
+//   BITMAP  1024 64-bit words, for denser containers
+//   RUN     (start, length - 1) pairs, for long consecutive ranges
+// A sparse course roster costs two bytes per student, and binary operations
+// skip every container the other side does not have.
+//
+// The *Count() functions compute cardinalities without building a result.
+class RoaringBitmap {
+private:
+    enum : uint32_t { ARRAY_LIMIT = 4096, BITMAP_WORDS = 1024 };
+
+    struct Container {
+        enum Kind { ARRAY, BITMAP, RUN };
+
+        Kind kind;
+        uint32_t cardinality;
+        vector<uint16_t> values; // ARRAY members, or RUN start/length pairs
+        vector<uint64_t> words;  // BITMAP members
+
+        Container() : kind(ARRAY), cardinality(0) {}
+
+        bool contains(uint16_t low) const {
+            switch (kind) {
+            case ARRAY:
+                return binary_search(values.begin(), values.end(), low);
+            case BITMAP:
+                return (words[low >> 6] >> (low & 63)) & 1;
+            case RUN: {
+                size_t lo = 0, hi = values.size() / 2;
+                while (lo < hi) {
+                    size_t mid = (lo + hi) / 2;
+                    if (values[2 * mid] <= low) lo = mid + 1;
+                    else hi = mid;
+                }
+                return lo > 0 && low - values[2 * (lo - 1)] <= values[2 * (lo - 1) + 1];
+            }
+            }
+            return false;
+        }
+
+        template<typename F>
+        void forEach(uint32_t high, F fn) const {
+            switch (kind) {
+            case ARRAY:
+                for (uint16_t v : values) fn(high | v);
+                break;
+            case BITMAP:
+                for (size_t w = 0; w < BITMAP_WORDS; w++) {
+                    uint64_t bits = words[w];
+                    while (bits) {
+                        fn(high | (uint32_t)(w * 64 + BitOps::lowestBit(bits)));
+                        bits &= bits - 1;
+                    }
+                }
+                break;
+            case RUN:
+                for (size_t r = 0; r < values.size(); r += 2) {
+                    for (uint32_t v = values[r]; v <= (uint32_t)values[r] + values[r + 1]; v++) fn(high | v);
+                }
+                break;
+            }
+        }
+
+        // Dense copy of any container, for mixed-kind operations.
+        void fillWords(vector<uint64_t>& out) const {
+            if (kind == BITMAP) { out = words; return; }
+            out.assign(BITMAP_WORDS, 0);
+            forEach(0, [&](uint32_t v) { out[v >> 6] |= 1ULL << (v & 63); });
+        }
+
+        // Picks ARRAY or BITMAP for a freshly computed BITMAP result.
+        void settle() {
+            if (kind != BITMAP || cardinality > ARRAY_LIMIT) return;
+            vector<uint16_t> members;
+            members.reserve(cardinality);
+            forEach(0, [&](uint32_t v) { members.push_back((uint16_t)v); });
+            kind = ARRAY;
+            values.swap(members);
+            vector<uint64_t>().swap(words);
+        }
+
+        static Container fromWords(vector<uint64_t>& dense) {
+            Container c;
+            c.kind = BITMAP;
+            c.words.swap(dense);
+            c.cardinality = (uint32_t)BitOps::count(c.words.data(), BITMAP_WORDS);
+            c.settle();
+            return c;
+        }
+
+        static Container fromArray(vector<uint16_t>& members) {
+            Container c;
+            c.cardinality = (uint32_t)members.size();
+            if (c.cardinality > ARRAY_LIMIT) {
+                c.kind = BITMAP;
+                c.words.assign(BITMAP_WORDS, 0);
+                for (uint16_t v : members) c.words[v >> 6] |= 1ULL << (v & 63);
+            }
+            else {
+                c.values.swap(members);
+            }
+            return c;
+        }
+
+        size_t bytes() const { return values.size() * sizeof(uint16_t) + words.size() * sizeof(uint64_t); }
+    };
+
+    enum Op { AND, OR, ANDNOT };
+
+    vector<uint16_t> keys; // high 16 bits of each container, ascending
+    vector<Container> containers;
+    size_t total;
+
+    static Container combine(const Container& a, const Container& b, Op op) {
+        if (a.kind == Container::ARRAY && b.kind == Container::ARRAY) {
+            vector<uint16_t> out;
+            switch (op) {
+            case AND:
+                set_intersection(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), back_inserter(out));
+                break;
+            case OR:
+                set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), back_inserter(out));
+                break;
+            case ANDNOT:
+                set_difference(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), back_inserter(out));
+                break;
+            }
+            return Container::fromArray(out);
+        }
+        if (op != OR && a.kind == Container::ARRAY) {
+            vector<uint16_t> out;
+            for (uint16_t v : a.values) {
+                if (b.contains(v) == (op == AND)) out.push_back(v);
+            }
+            return Container::fromArray(out);
+        }
+
+        vector<uint64_t> left, right;
+        a.fillWords(left);
+        b.fillWords(right);
+        switch (op) {
+        case AND: BitOps::andInto(left.data(), right.data(), BITMAP_WORDS); break;
+        case OR: BitOps::orInto(left.data(), right.data(), BITMAP_WORDS); break;
+        case ANDNOT: BitOps::andNotInto(left.data(), right.data(), BITMAP_WORDS); break;
+        }
+        return Container::fromWords(left);
+    }
+
+    static size_t andCount(const Container& a, const Container& b) {
+        if (a.kind == Container::ARRAY && b.kind == Container::ARRAY) {
+            // Branch-free merge: both cursors advance on a match.
+            size_t count = 0, i = 0, j = 0;
+            const uint16_t* x = a.values.data();
+            const uint16_t* y = b.values.data();
+            while (i < a.values.size() && j < b.values.size()) {
+                uint16_t u = x[i], v = y[j];
+                count += u == v;
+                i += u <= v;
+                j += v <= u;
+            }
+            return count;
+        }
+        if (a.kind == Container::ARRAY || b.kind == Container::ARRAY) {
+            const Container& small = a.kind == Container::ARRAY ? a : b;
+            const Container& other = a.kind == Container::ARRAY ? b : a;
+            size_t count = 0;
+            for (uint16_t v : small.values) count += other.contains(v);
+            return count;
+        }
+        if (a.kind == Container::BITMAP && b.kind == Container::BITMAP) {
+            return BitOps::andCount(a.words.data(), b.words.data(), BITMAP_WORDS);
+        }
+        vector<uint64_t> left, right;
+        a.fillWords(left);
+        b.fillWords(right);
+        return BitOps::andCount(left.data(), right.data(), BITMAP_WORDS);
+    }
+
+    static RoaringBitmap combine(const RoaringBitmap& a, const RoaringBitmap& b, Op op) {
+        RoaringBitmap result;
+        size_t i = 0, j = 0;
+        while (i < a.keys.size() || j < b.keys.size()) {
+            bool fromA = j == b.keys.size() || (i < a.keys.size() && a.keys[i] < b.keys[j]);
+            bool fromB = i == a.keys.size() || (j < b.keys.size() && b.keys[j] < a.keys[i]);
+            if (fromA) {
+                if (op != AND) result.append(a.keys[i], a.containers[i]);
+                i++;
+            }
+            else if (fromB) {
+                if (op == OR) result.append(b.keys[j], b.containers[j]);
+                j++;
+            }
+            else {
+                result.append(a.keys[i], combine(a.containers[i], b.containers[j], op));
+                i++;
+                j++;
+            }
+        }
+        return result;
+    }
+
+    void append(uint16_t key, const Container& c) {
+        if (c.cardinality == 0) return;
+        keys.push_back(key);
+        containers.push_back(c);
+        total += c.cardinality;
+    }
+
+public:
+    RoaringBitmap() : total(0) {}
+
+    // Builds from handles in ascending order, e.g. a HandleSet.
+    template<typename It>
+    static RoaringBitmap fromSorted(It first, It last) {
+        RoaringBitmap result;
+        vector<uint16_t> members;
+        while (first != last) {
+            uint16_t key = (uint16_t)(*first >> 16);
+            members.clear();
+            for (; first != last && (uint16_t)(*first >> 16) == key; ++first) members.push_back((uint16_t)*first);
+            result.append(key, Container::fromArray(members));
+        }
+        return result;
+    }
+
+    // Builds from a dense bit row such as an EnrollmentBits roster.
+    static RoaringBitmap fromWords(const uint64_t* row, size_t words) {
+        RoaringBitmap result;
+        for (size_t start = 0; start < words; start += BITMAP_WORDS) {
+            size_t n = min((size_t)BITMAP_WORDS, words - start);
+            if (!BitOps::any(row + start, n)) continue;
+            vector<uint64_t> dense(row + start, row + start + n);
+            dense.resize(BITMAP_WORDS, 0);
+            result.append((uint16_t)(start / BITMAP_WORDS), Container::fromWords(dense));
+        }
+        return result;
+    }
+
+    size_t size() const { return total; }
+    bool empty() const { return total == 0; }
+
+    bool contains(uint32_t value) const {
+        auto it = lower_bound(keys.begin(), keys.end(), (uint16_t)(value >> 16));
+        return it != keys.end() && *it == (uint16_t)(value >> 16) &&
+            containers[it - keys.begin()].contains((uint16_t)value);
+    }
+
+    void add(uint32_t value) {
+        uint16_t key = (uint16_t)(value >> 16);
+        size_t at = lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+        if (at == keys.size() || keys[at] != key) {
+            keys.insert(keys.begin() + at, key);
+            containers.insert(containers.begin() + at, Container());
+        }
+        Container& c = containers[at];
+        uint16_t low = (uint16_t)value;
+        if (c.contains(low)) return;
+
+        if (c.kind == Container::BITMAP) {
+            c.words[low >> 6] |= 1ULL << (low & 63);
+            c.cardinality++;
+        }
+        else if (c.kind == Container::ARRAY && c.cardinality < ARRAY_LIMIT) {
+            c.values.insert(lower_bound(c.values.begin(), c.values.end(), low), low);
+            c.cardinality++;
+        }
+        else {
+            vector<uint16_t> single(1, low);
+            Container one = Container::fromArray(single);
+            c = combine(c, one, OR);
+        }
+        total++;
+    }
+
+    // Re-encodes containers whose members form few long ranges as RUN.
+    void runOptimize() {
+        for (Container& c : containers) {
+            if (c.kind == Container::RUN) continue;
+            vector<uint16_t> runs;
+            c.forEach(0, [&](uint32_t v) {
+                size_t n = runs.size();
+                if (n && (uint32_t)runs[n - 2] + runs[n - 1] + 1 == v) runs[n - 1]++;
+                else { runs.push_back((uint16_t)v); runs.push_back(0); }
+            });
+            if (runs.size() * sizeof(uint16_t) < c.bytes()) {
+                c.kind = Container::RUN;
+                c.values.swap(runs);
+                vector<uint64_t>().swap(c.words);
+            }
+        }
+    }
+
+    template<typename F>
+    void forEach(F fn) const {
+        for (size_t i = 0; i < keys.size(); i++) containers[i].forEach((uint32_t)keys[i] << 16, fn);
+    }
+
+    size_t bytes() const {
+        size_t sum = keys.size() * sizeof(uint16_t);
+        for (const Container& c : containers) sum += c.bytes();
+        return sum;
+    }
+
+    RoaringBitmap operator&(const RoaringBitmap& other) const { return combine(*this, other, AND); }
+    RoaringBitmap operator|(const RoaringBitmap& other) const { return combine(*this, other, OR); }
+    RoaringBitmap operator-(const RoaringBitmap& other) const { return combine(*this, other, ANDNOT); }
+
+    static size_t andCount(const RoaringBitmap& a, const RoaringBitmap& b) {
+        size_t count = 0, i = 0, j = 0;
+        while (i < a.keys.size() && j < b.keys.size()) {
+            if (a.keys[i] < b.keys[j]) i++;
+            else if (b.keys[j] < a.keys[i]) j++;
+            else count += andCount(a.containers[i++], b.containers[j++]);
+        }
+        return count;
+    }
+    static size_t orCount(const RoaringBitmap& a, const RoaringBitmap& b) { return a.size() + b.size() - andCount(a, b); }
+    static size_t andNotCount(const RoaringBitmap& a, const RoaringBitmap& b) { return a.size() - andCount(a, b); }
+
+    bool operator==(const RoaringBitmap& other) const {
+        if (total != other.total || keys != other.keys) return false;
+        return andCount(*this, other) == total;
+    }
+    bool operator!=(const RoaringBitmap& other) const { return !(*this == other); }
+};
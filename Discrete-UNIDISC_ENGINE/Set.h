@@ -1,6 +1,11 @@
 #pragma once
 
 #include "Core.h"
+#include "Roaring.h"
+#include "Subsets.h"
+#include "SetExpression.h"
+#include "CoEnrollment.h"
+#include "Sketches.h"
 #include <vector>
 #include <string>
 #include <set>
@@ -8,153 +13,230 @@
 #include <iostream>
 #include <algorithm>
 #include <cmath>
+#include <thread>
+#include <mutex>
 
 class SetOperationsModule {
 private:
-    DataManager* dm;
-
-    template<typename T>
-    set<T> setUnion(const set<T>& a, const set<T>& b) {
-        set<T> result = a;
-        result.insert(b.begin(), b.end());
-        return result;
-    }
-
-    template<typename T>
-    set<T> setIntersection(const set<T>& a, const set<T>& b) {
-        set<T> result;
-        set_intersection(a.begin(), a.end(), b.begin(), b.end(),
-            inserter(result, result.begin()));
-        return result;
-    }
-
-    template<typename T>
-    set<T> setDifference(const set<T>& a, const set<T>& b) {
-        set<T> result;
-        set_difference(a.begin(), a.end(), b.begin(), b.end(),
-            inserter(result, result.begin()));
-        return result;
-    }
-
-    template<typename T>
-    vector<set<T>> powerSet(const set<T>& s) {
-        vector<T> vec(s.begin(), s.end());
-        vector<set<T>> result;
-
-        int n = vec.size();
-        int powerSetSize = pow(2, n);
-
-        for (int i = 0; i < powerSetSize && i < 1000; i++) { 
-            set<T> subset;
-            for (int j = 0; j < n; j++) {
-                if (i & (1 << j)) {
-                    subset.insert(vec[j]);
-                }
-            }
-            result.push_back(subset);
-        }
-
-        return result;
+    const DataManager* dm;
+    CourseSketches sketches;
+
+    set<string> studentNames(const RoaringBitmap& students) {
+        set<string> names;
+        students.forEach([&](Handle h) {
+            names.insert(Symbols::students().name(h));
+        });
+        return names;
     }
 
 public:
-    SetOperationsModule() {
-        dm = DataManager::getInstance();
+    explicit SetOperationsModule(DataManager* manager) : sketches(manager) {
+        dm = manager;
     }
 
     set<string> getStudentSet() {
         set<string> students;
-        for (auto& pair : dm->getAllStudents()) {
-            students.insert(pair.first);
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
+        const CatalogColumns& columns = version->columns;
+        for (size_t row = 0; row < columns.studentCount(); row++) {
+            students.insert(students.end(), columns.studentID(row));
         }
         return students;
     }
 
     set<string> getCourseSet() {
         set<string> courses;
-        for (auto& pair : dm->getAllCourses()) {
-            courses.insert(pair.first);
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
+        const CatalogColumns& columns = version->columns;
+        for (size_t row = 0; row < columns.courseCount(); row++) {
+            courses.insert(courses.end(), columns.courseID(row));
         }
         return courses;
     }
 
-    set<string> studentsInMultipleCourses(const vector<string>& courseIDs) {
-        if (courseIDs.empty()) return set<string>();
-
-        set<string> result;
-        bool first = true;
+    // Roster of a course as a compressed bitmap over student handles.
+    RoaringBitmap studentsOf(const string& courseID) {
+        const HandleSet& roster = dm->getEnrolledStudents(courseID);
+        return RoaringBitmap::fromSorted(roster.begin(), roster.end());
+    }
 
+    vector<HandleRange> rostersOf(const vector<string>& courseIDs) {
+        vector<HandleRange> rosters;
         for (const string& courseID : courseIDs) {
-            set<string> enrolled;
+            const vector<Handle>& roster = dm->getEnrolledStudents(courseID).data();
+            rosters.push_back(HandleRange(roster.data(), roster.data() + roster.size()));
+        }
+        return rosters;
+    }
 
-            for (auto& pair : dm->getAllStudents()) {
-                Student& student = pair.second;
-                if (student.getEnrolledCourses().find(courseID) !=
-                    student.getEnrolledCourses().end()) {
-                    enrolled.insert(student.getID());
-                }
-            }
+    // Students in every one of the courses, by galloping k-way intersection
+    // of the sorted rosters; costs about as much as the smallest roster.
+    RoaringBitmap intersectionOf(const vector<string>& courseIDs) {
+        vector<Handle> both = SortedIntersection::all(rostersOf(courseIDs));
+        return RoaringBitmap::fromSorted(both.begin(), both.end());
+    }
 
-            if (first) {
-                result = enrolled;
-                first = false;
-            }
-            else {
-                result = setIntersection(result, enrolled);
-            }
+    RoaringBitmap unionOf(const vector<string>& courseIDs) {
+        RoaringBitmap result;
+        for (const string& courseID : courseIDs) {
+            result = result | studentsOf(courseID);
         }
-
         return result;
     }
 
+    set<string> studentsInMultipleCourses(const vector<string>& courseIDs) {
+        return studentNames(intersectionOf(courseIDs));
+    }
+
     set<string> studentsInAnyCourse(const vector<string>& courseIDs) {
-        set<string> result;
+        return studentNames(unionOf(courseIDs));
+    }
 
-        for (const string& courseID : courseIDs) {
-            for (auto& pair : dm->getAllStudents()) {
-                Student& student = pair.second;
-                if (student.getEnrolledCourses().find(courseID) !=
-                    student.getEnrolledCourses().end()) {
-                    result.insert(student.getID());
-                }
-            }
+    set<string> studentDifference(const string& courseA, const string& courseB) {
+        return studentNames(studentsOf(courseA) - studentsOf(courseB));
+    }
+
+    // Cardinality-only variants; none of them builds the result set.
+    size_t overlapCount(const string& courseA, const string& courseB) {
+        return SortedIntersection::count(rostersOf({ courseA, courseB }));
+    }
+
+    size_t intersectionCount(const vector<string>& courseIDs) {
+        return SortedIntersection::count(rostersOf(courseIDs));
+    }
+
+    size_t unionCount(const vector<string>& courseIDs) {
+        if (courseIDs.size() == 2) return RoaringBitmap::orCount(studentsOf(courseIDs[0]), studentsOf(courseIDs[1]));
+        return unionOf(courseIDs).size();
+    }
+
+    size_t differenceCount(const string& courseA, const string& courseB) {
+        return RoaringBitmap::andNotCount(studentsOf(courseA), studentsOf(courseB));
+    }
+
+    // Students matching a set expression such as
+    // (enrolled(CS101) & enrolled(MATH101)) \ completed(CS102); see SetQuery.
+    // Returns false and sets `error` if the expression does not compile.
+    bool studentsMatching(const string& expression, set<string>& students, string& error) {
+        SetQuery query(dm);
+        if (!query.compile(expression)) {
+            error = query.error();
+            return false;
         }
+        students = studentNames(query.evaluate());
+        return true;
+    }
 
-        return result;
+    bool countMatching(const string& expression, size_t& count, string& error) {
+        SetQuery query(dm);
+        if (!query.compile(expression)) {
+            error = query.error();
+            return false;
+        }
+        count = query.count();
+        return true;
     }
 
-    set<string> studentDifference(const string& courseA, const string& courseB) {
-        set<string> studentsA, studentsB;
+    // Approximate answers from per-course MinHash and HyperLogLog sketches,
+    // kept current as students enroll and drop; see CourseSketches.
+    double approximateJaccard(const string& courseA, const string& courseB) {
+        return sketches.jaccard(courseA, courseB);
+    }
 
-        for (auto& pair : dm->getAllStudents()) {
-            Student& student = pair.second;
-            if (student.getEnrolledCourses().find(courseA) !=
-                student.getEnrolledCourses().end()) {
-                studentsA.insert(student.getID());
-            }
-            if (student.getEnrolledCourses().find(courseB) !=
-                student.getEnrolledCourses().end()) {
-                studentsB.insert(student.getID());
+    double approximateOverlap(const string& courseA, const string& courseB) {
+        return sketches.overlap(courseA, courseB);
+    }
+
+    double approximateDistinctStudents(const vector<string>& courseIDs) {
+        return sketches.distinctStudents(courseIDs);
+    }
+
+    struct CourseOverlap {
+        string courseA;
+        string courseB;
+        size_t shared;
+
+        CourseOverlap(const string& a, const string& b, size_t n) : courseA(a), courseB(b), shared(n) {}
+    };
+
+    // Students shared by every pair of the given courses, for pairs sharing at
+    // least `minShared`. Each roster is compressed once and reused for all of
+    // its pairs.
+    vector<CourseOverlap> overlapReport(const vector<string>& courseIDs, size_t minShared = 1) {
+        vector<RoaringBitmap> rosters;
+        rosters.reserve(courseIDs.size());
+        for (const string& courseID : courseIDs) rosters.push_back(studentsOf(courseID));
+
+        vector<CourseOverlap> report;
+        for (size_t a = 0; a < rosters.size(); a++) {
+            for (size_t b = a + 1; b < rosters.size(); b++) {
+                size_t shared = RoaringBitmap::andCount(rosters[a], rosters[b]);
+                if (shared > 0 && shared >= minShared) report.push_back(CourseOverlap(courseIDs[a], courseIDs[b], shared));
             }
         }
-
-        return setDifference(studentsA, studentsB);
+        return report;
     }
 
-    vector<set<string>> generatePowerSet(int maxStudents = 5) {
-        set<string> students = getStudentSet();
+    // A non-empty subset of the given courses whose credits add up to exactly
+    // `credits`, or an empty list if there is none. The running total changes
+    // by one course per step. With several threads each searches its own
+    // share of the subsets, and whichever finds a match first stops the rest.
+    vector<string> coursesTotalling(const vector<string>& courseIDs, int credits, unsigned threads = 1) {
+        vector<int> courseCredits;
+        for (const string& courseID : courseIDs) {
+            const Course* course = dm->getCourse(courseID);
+            courseCredits.push_back(course ? course->getCredits() : 0);
+        }
 
-        if (students.size() > maxStudents) {
-            set<string> limited;
-            int count = 0;
-            for (const string& s : students) {
-                limited.insert(s);
-                if (++count >= maxStudents) break;
+        GraySubsets subsets(courseIDs.size());
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        vector<int> running(threads, 0);
+        vector<uint64_t> found;
+        mutex foundLock;
+
+        subsets.walkParallel(threads, [&](const SubsetStep& step, unsigned worker) {
+            int& total = running[worker];
+            if (step.changed == SubsetStep::NONE) {
+                total = 0;
+                for (size_t i = 0; i < courseIDs.size(); i++) {
+                    if (step.contains(i)) total += courseCredits[i];
+                }
             }
-            students = limited;
+            else {
+                total += step.added ? courseCredits[step.changed] : -courseCredits[step.changed];
+            }
+            if (total != credits || step.size == 0) return true;
+
+            lock_guard<mutex> guard(foundLock);
+            if (found.empty()) found.assign(step.members, step.members + BitOps::wordsFor(max(courseIDs.size(), (size_t)1)));
+            return false;
+        });
+
+        vector<string> result;
+        for (size_t i = 0; i < courseIDs.size() && !found.empty(); i++) {
+            if ((found[i >> 6] >> (i & 63)) & 1) result.push_back(courseIDs[i]);
+        }
+        return result;
+    }
+
+    // Streams the power set of the first `maxStudents` students in ID order,
+    // in Gray-code order, without materializing it: visit(step, students)
+    // sees each subset as membership bits over `students` and returns false
+    // to stop. Returns the number of subsets visited.
+    template<typename F>
+    uint64_t generatePowerSet(int maxStudents, F visit) {
+        vector<string> students;
+        for (const string& s : getStudentSet()) {
+            if ((int)students.size() >= maxStudents) break;
+            students.push_back(s);
         }
 
-        return powerSet(students);
+        uint64_t visited = 0;
+        GraySubsets(students.size()).walk([&](const SubsetStep& step) {
+            visited++;
+            return visit(step, students);
+        });
+        return visited;
     }
 
     void demonstrate() {
@@ -188,8 +270,8 @@ public:
 
         if (students.size() > 0 && students.size() <= 5) {
             cout << "\n--- Power Set Example ---" << endl;
-            vector<set<string>> ps = generatePowerSet(students.size());
-            cout << "Power set size: " << ps.size() << " subsets" << endl;
+            uint64_t subsets = generatePowerSet((int)students.size(), [](const SubsetStep&, const vector<string>&) { return true; });
+            cout << "Power set size: " << subsets << " subsets" << endl;
             cout << "Expected: 2^" << students.size() << " = "
                 << (int)pow(2, students.size()) << endl;
         }
@@ -0,0 +1,390 @@
+#pragma once
+
+#include "Core.h"
+#include "Roaring.h"
+#include "Arena.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+using namespace std;
+
+// Set-algebra query over students, e.g.
+//   (enrolled(CS101) ∩ enrolled(MATH101)) \ completed(CS102)
+//
+//   expr  := inter { ("∪" | "|" | "\" | "-") inter }     left to right
+//   inter := atom { ("∩" | "&") atom }                   binds tighter
+//   atom  := "(" expr ")" | "all" | enrolled(ID) | completed(ID) | lab(ID)
+//
+// compile() parses the text into an operator tree and plans it: nested
+// unions and intersections are flattened, A \ B \ C becomes A \ (B ∪ C),
+// and operands are ordered by estimated size, smallest first under an
+// intersection. Evaluation is one fused pass: every result word is computed
+// straight from the leaves' roster bits, with no intermediate sets. When the
+// result is bounded by a roster (an intersection, or the left side of a
+// difference), only the words that roster touches are visited.
+//
+// compile() pins the manager's current CatalogVersion and every later step
+// reads that version only, so a compiled query may be evaluated on any thread
+// while writers carry on, and gives the same answer until it is recompiled.
+// Lab rosters are not part of a version and are copied at compile() instead.
+// Bits are laid out by the version's student rows (see EnrollmentBits), so
+// enrolled() and completed() read its roster rows directly and only lab()
+// and all() are built per evaluation.
+class SetQuery {
+public:
+    enum Kind { ALL, ENROLLED, COMPLETED, LAB, AND, OR, ANDNOT };
+
+private:
+    struct Node {
+        Kind kind;
+        Handle handle;
+        string id;
+        vector<int> children; // ANDNOT: exactly two, left minus right
+        size_t estimate;
+        vector<Handle> members; // LAB: the roster as of compile()
+        const uint64_t* row;    // leaves, once bound
+
+        Node(Kind k) : kind(k), handle(INVALID_HANDLE), estimate(0), row(nullptr) {}
+        bool leaf() const { return kind < AND; }
+    };
+
+    const DataManager* dm;
+    shared_ptr<const CatalogVersion> version; // pinned by compile()
+    vector<Node> nodes;
+    int root;
+    string lastError;
+
+    string text;
+    size_t pos;
+
+    // ---- parsing ----
+
+    void skipSpace() {
+        while (pos < text.size() && isspace((unsigned char)text[pos])) pos++;
+    }
+
+    bool accept(const char* token) {
+        skipSpace();
+        size_t n = strlen(token);
+        if (text.compare(pos, n, token) != 0) return false;
+        pos += n;
+        return true;
+    }
+
+    int fail(const string& message) {
+        if (lastError.empty()) lastError = message + " at position " + to_string(pos + 1);
+        return -1;
+    }
+
+    int add(Node node) {
+        nodes.push_back(node);
+        return (int)nodes.size() - 1;
+    }
+
+    int binary(Kind kind, int left, int right) {
+        Node node(kind);
+        node.children.push_back(left);
+        node.children.push_back(right);
+        return add(node);
+    }
+
+    int parseExpression() {
+        int left = parseIntersection();
+        while (left >= 0) {
+            Kind kind;
+            if (accept("\xE2\x88\xAA") || accept("|")) kind = OR;
+            else if (accept("\\") || accept("-")) kind = ANDNOT;
+            else break;
+            int right = parseIntersection();
+            if (right < 0) return -1;
+            left = binary(kind, left, right);
+        }
+        return left;
+    }
+
+    int parseIntersection() {
+        int left = parseAtom();
+        while (left >= 0 && (accept("\xE2\x88\xA9") || accept("&"))) {
+            int right = parseAtom();
+            if (right < 0) return -1;
+            left = binary(AND, left, right);
+        }
+        return left;
+    }
+
+    int parseAtom() {
+        if (accept("(")) {
+            int inner = parseExpression();
+            if (inner < 0) return -1;
+            if (!accept(")")) return fail("expected ')'");
+            return inner;
+        }
+
+        skipSpace();
+        size_t start = pos;
+        while (pos < text.size() && (isalpha((unsigned char)text[pos]))) pos++;
+        string word = text.substr(start, pos - start);
+        for (char& c : word) c = (char)tolower((unsigned char)c);
+
+        if (word == "all") return add(Node(ALL));
+
+        Kind kind;
+        if (word == "enrolled") kind = ENROLLED;
+        else if (word == "completed") kind = COMPLETED;
+        else if (word == "lab") kind = LAB;
+        else {
+            pos = start;
+            return fail(word.empty() ? "expected a set" : "unknown set '" + word + "'");
+        }
+
+        if (!accept("(")) return fail("expected '(' after " + word);
+        skipSpace();
+        size_t idStart = pos;
+        while (pos < text.size() && text[pos] != ')' && !isspace((unsigned char)text[pos])) pos++;
+        string id = text.substr(idStart, pos - idStart);
+        if (!accept(")")) return fail("expected ')' after " + word + " ID");
+
+        size_t after = pos;
+        pos = idStart;
+        Node node(kind);
+        node.id = id;
+        if (kind == LAB) {
+            node.handle = Symbols::labs().find(id);
+            const Lab* lab = dm->getLab(node.handle);
+            if (!lab) return fail("unknown lab " + id);
+            node.members = lab->getEnrolledHandles().data();
+        }
+        else {
+            node.handle = Symbols::courses().find(id);
+            if (version->columns.courseRow(node.handle) == CatalogColumns::NO_ROW) return fail("unknown course " + id);
+        }
+        pos = after;
+        return add(node);
+    }
+
+    // ---- planning ----
+
+    // Rewrites the tree in place; binary() may grow `nodes`, so nodes are
+    // always reached by index here.
+    void flatten(int n) {
+        for (size_t i = 0; i < nodes[n].children.size(); i++) flatten(nodes[n].children[i]);
+        if (nodes[n].kind == ANDNOT) {
+            // (A \ B) \ C  ->  A \ (B ∪ C)
+            int left = nodes[n].children[0];
+            if (nodes[left].kind == ANDNOT) {
+                int inner = nodes[left].children[0];
+                int removed = binary(OR, nodes[left].children[1], nodes[n].children[1]);
+                flatten(removed);
+                nodes[n].children[0] = inner;
+                nodes[n].children[1] = removed;
+            }
+            return;
+        }
+        if (nodes[n].kind != AND && nodes[n].kind != OR) return;
+
+        vector<int> merged;
+        for (int c : nodes[n].children) {
+            if (nodes[c].kind == nodes[n].kind) merged.insert(merged.end(), nodes[c].children.begin(), nodes[c].children.end());
+            else merged.push_back(c);
+        }
+        nodes[n].children = merged;
+    }
+
+    size_t estimate(int n) {
+        Node& node = nodes[n];
+        const EnrollmentBits& bits = version->bits;
+        size_t everyone = version->columns.studentCount();
+        switch (node.kind) {
+        case ALL: node.estimate = everyone; break;
+        case ENROLLED: node.estimate = BitOps::count(bits.enrolledStudents(node.handle), bits.studentWords()); break;
+        case COMPLETED: node.estimate = BitOps::count(bits.completedStudents(node.handle), bits.studentWords()); break;
+        case LAB: node.estimate = node.members.size(); break;
+        case AND:
+            node.estimate = everyone;
+            for (int c : node.children) node.estimate = min(node.estimate, estimate(c));
+            break;
+        case OR:
+            node.estimate = 0;
+            for (int c : node.children) node.estimate += estimate(c);
+            node.estimate = min(node.estimate, everyone);
+            break;
+        case ANDNOT:
+            node.estimate = estimate(node.children[0]);
+            estimate(node.children[1]);
+            break;
+        }
+
+        vector<int>& children = nodes[n].children;
+        if (nodes[n].kind == AND || nodes[n].kind == OR) {
+            bool ascending = nodes[n].kind == AND;
+            stable_sort(children.begin(), children.end(), [&](int a, int b) {
+                return ascending ? nodes[a].estimate < nodes[b].estimate : nodes[a].estimate > nodes[b].estimate;
+            });
+        }
+        return nodes[n].estimate;
+    }
+
+    // Leaf whose roster contains the whole result of n, or -1.
+    int driver(int n) const {
+        const Node& node = nodes[n];
+        switch (node.kind) {
+        case ALL: case OR: return -1;
+        case ENROLLED: case COMPLETED: case LAB: return n;
+        case ANDNOT: return driver(node.children[0]);
+        case AND:
+            for (int c : node.children) {
+                int d = driver(c);
+                if (d >= 0) return d;
+            }
+            return -1;
+        }
+        return -1;
+    }
+
+    // ---- evaluation ----
+
+    void bind(MonotonicArena& arena) {
+        const EnrollmentBits& bits = version->bits;
+        size_t words = bits.studentWords();
+        for (Node& node : nodes) {
+            if (!node.leaf()) continue;
+            if (node.kind == ENROLLED) {
+                node.row = bits.enrolledStudents(node.handle);
+                continue;
+            }
+            if (node.kind == COMPLETED) {
+                node.row = bits.completedStudents(node.handle);
+                continue;
+            }
+
+            uint64_t* row = arena.allocateArray<uint64_t>(words);
+            fill(row, row + words, 0);
+            auto mark = [&](Handle h) {
+                size_t r = bits.studentRow(h);
+                if (r != INVALID_HANDLE) row[r >> 6] |= 1ULL << (r & 63);
+            };
+            if (node.kind == ALL) {
+                const CatalogColumns& columns = version->columns;
+                for (size_t r = 0; r < columns.studentCount(); r++) mark(columns.studentHandle(r));
+            }
+            else {
+                for (Handle h : node.members) mark(h);
+            }
+            node.row = row;
+        }
+    }
+
+    uint64_t word(int n, size_t w) const {
+        const Node& node = nodes[n];
+        switch (node.kind) {
+        case AND: {
+            uint64_t acc = ~0ULL;
+            for (int c : node.children) {
+                acc &= word(c, w);
+                if (!acc) break;
+            }
+            return acc;
+        }
+        case OR: {
+            uint64_t acc = 0;
+            for (int c : node.children) {
+                acc |= word(c, w);
+                if (acc == ~0ULL) break;
+            }
+            return acc;
+        }
+        case ANDNOT: {
+            uint64_t acc = word(node.children[0], w);
+            return acc ? acc & ~word(node.children[1], w) : 0;
+        }
+        default:
+            return node.row[w];
+        }
+    }
+
+    template<typename F>
+    void run(F emit) {
+        size_t words = version->bits.studentWords();
+        MonotonicArena arena;
+        bind(arena);
+
+        int d = driver(root);
+        const uint64_t* bound = d < 0 ? nullptr : nodes[d].row;
+        for (size_t w = 0; w < words; w++) {
+            if (bound && !bound[w]) continue;
+            uint64_t bitsOut = word(root, w);
+            if (bitsOut) emit(w, bitsOut);
+        }
+    }
+
+    string describe(int n) const {
+        const Node& node = nodes[n];
+        switch (node.kind) {
+        case ALL: return "all";
+        case ENROLLED: return "enrolled(" + node.id + ")";
+        case COMPLETED: return "completed(" + node.id + ")";
+        case LAB: return "lab(" + node.id + ")";
+        default: break;
+        }
+        const char* op = node.kind == AND ? " & " : node.kind == OR ? " | " : " \\ ";
+        string out = "(";
+        for (size_t i = 0; i < node.children.size(); i++) {
+            if (i) out += op;
+            out += describe(node.children[i]);
+        }
+        return out + ")";
+    }
+
+public:
+    explicit SetQuery(const DataManager* manager) : dm(manager), root(-1), pos(0) {}
+
+    // Pins the current version, then parses and plans an expression against
+    // it. On failure error() says what and where.
+    bool compile(const string& expression) {
+        version = dm->snapshot();
+        nodes.clear();
+        lastError.clear();
+        text = expression;
+        pos = 0;
+        root = parseExpression();
+        skipSpace();
+        if (root >= 0 && pos < text.size()) root = fail("unexpected '" + text.substr(pos, 1) + "'");
+        if (root < 0) return false;
+
+        flatten(root);
+        estimate(root);
+        return true;
+    }
+
+    const string& error() const { return lastError; }
+    bool valid() const { return root >= 0; }
+
+    // The planned tree, operands in evaluation order.
+    string plan() const { return valid() ? describe(root) : string(); }
+    size_t estimatedSize() const { return valid() ? nodes[root].estimate : 0; }
+
+    // Cardinality of the result, without building it.
+    size_t count() {
+        size_t total = 0;
+        if (valid()) run([&](size_t, uint64_t bits) { total += BitOps::popcount(bits); });
+        return total;
+    }
+
+    RoaringBitmap evaluate() {
+        vector<Handle> members;
+        if (valid()) {
+            const EnrollmentBits& rows = version->bits;
+            run([&](size_t w, uint64_t bits) {
+                while (bits) {
+                    members.push_back(rows.studentAt(w * 64 + BitOps::lowestBit(bits)));
+                    bits &= bits - 1;
+                }
+            });
+            sort(members.begin(), members.end());
+        }
+        return RoaringBitmap::fromSorted(members.begin(), members.end());
+    }
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "Core.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <mutex>
+#include <algorithm>
+
+using namespace std;
+
+// Student handles hashed to 64 well-mixed bits (splitmix64 finalizer).
+inline uint64_t sketchHash(Handle student) {
+    uint64_t x = (uint64_t)student + 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// One-permutation MinHash: the low bits of a hash pick one of SLOTS buckets
+// and each bucket keeps the smallest remaining hash bits it has seen. Two
+// sketches estimate the Jaccard similarity of their sets as the share of
+// buckets, among those not empty in both, holding the same minimum; the
+// standard error is about sqrt(J(1-J)/SLOTS). Merging is a per-bucket min.
+class MinHashSketch {
+public:
+    enum { SLOTS = 256, SLOT_BITS = 8 };
+
+private:
+    uint64_t mins[SLOTS];
+
+    static uint64_t empty() { return ~0ULL; }
+
+public:
+    MinHashSketch() { clear(); }
+
+    void clear() { fill(mins, mins + SLOTS, empty()); }
+
+    void add(uint64_t hash) {
+        uint64_t& slot = mins[hash & (SLOTS - 1)];
+        slot = min(slot, hash >> SLOT_BITS);
+    }
+
+    // Whether removing an element with this hash could change the sketch.
+    bool defines(uint64_t hash) const { return mins[hash & (SLOTS - 1)] == hash >> SLOT_BITS; }
+
+    void merge(const MinHashSketch& other) {
+        for (int i = 0; i < SLOTS; i++) mins[i] = min(mins[i], other.mins[i]);
+    }
+
+    static double jaccard(const MinHashSketch& a, const MinHashSketch& b) {
+        int matches = 0, used = 0;
+        for (int i = 0; i < SLOTS; i++) {
+            if (a.mins[i] == empty() && b.mins[i] == empty()) continue;
+            used++;
+            if (a.mins[i] == b.mins[i]) matches++;
+        }
+        return used ? (double)matches / used : 0.0;
+    }
+};
+
+// HyperLogLog distinct counter with 2^PRECISION one-byte registers: the top
+// bits of a hash pick a register, which keeps the largest trailing-zero run
+// (plus one) seen in the remaining bits. Standard error is 1.04 / sqrt(2^P),
+// about 1.6% at P = 12; small counts fall back to linear counting. Merging
+// is a per-register max, so the sketch of a union is the merge of sketches.
+class HyperLogLog {
+public:
+    enum { PRECISION = 12, REGISTERS = 1 << PRECISION };
+
+private:
+    uint8_t registers[REGISTERS];
+
+    static size_t index(uint64_t hash) { return (size_t)(hash >> (64 - PRECISION)); }
+
+    static uint8_t rank(uint64_t hash) {
+        uint64_t rest = (hash & ((1ULL << (64 - PRECISION)) - 1)) | (1ULL << (64 - PRECISION));
+        return (uint8_t)(BitOps::lowestBit(rest) + 1);
+    }
+
+public:
+    HyperLogLog() { clear(); }
+
+    void clear() { fill(registers, registers + REGISTERS, (uint8_t)0); }
+
+    void add(uint64_t hash) {
+        uint8_t& r = registers[index(hash)];
+        r = max(r, rank(hash));
+    }
+
+    bool defines(uint64_t hash) const { return registers[index(hash)] == rank(hash); }
+
+    void merge(const HyperLogLog& other) {
+        for (int i = 0; i < REGISTERS; i++) registers[i] = max(registers[i], other.registers[i]);
+    }
+
+    double estimate() const {
+        double sum = 0;
+        int zeros = 0;
+        for (int i = 0; i < REGISTERS; i++) {
+            sum += 1.0 / (double)(1ULL << registers[i]);
+            if (registers[i] == 0) zeros++;
+        }
+        double m = REGISTERS;
+        double raw = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+        if (raw <= 2.5 * m && zeros > 0) return m * log(m / zeros);
+        return raw;
+    }
+};
+
+// A MinHash and a HyperLogLog sketch of every course's current roster, kept
+// up to date through the DataManager's mutation feed. Enrollments update the
+// sketches in place. Neither sketch can forget an element, so a drop or
+// completion only marks the course for a rebuild from its roster, and only
+// when the leaving student actually defined a bucket or register; rebuilds
+// happen on the next query. Nothing is built until a course is first queried.
+//
+// Queries take microseconds whatever the roster sizes, at the error rates
+// given above. Updates are safe from concurrent writers; queries may rebuild
+// from rosters, so like other roster reads they belong between writes.
+class CourseSketches : public MutationObserver {
+private:
+    struct Entry {
+        MinHashSketch minHash;
+        HyperLogLog distinct;
+        bool stale;
+
+        Entry() : stale(true) {}
+    };
+
+    DataManager* dm;
+    vector<Entry> entries; // by course handle
+    vector<char> knownStudents;
+    bool built;
+    mutable mutex lock;
+
+    CourseSketches(const CourseSketches&);
+    CourseSketches& operator=(const CourseSketches&);
+
+    void rebuild(Handle course, Entry& e) {
+        e.minHash.clear();
+        e.distinct.clear();
+        for (Handle student : dm->getEnrolledStudents(course)) {
+            uint64_t hash = sketchHash(student);
+            e.minHash.add(hash);
+            e.distinct.add(hash);
+        }
+        e.stale = false;
+    }
+
+    // Caller holds the lock. Sizes the table up front so that pointers from
+    // fresh() stay valid for the whole query.
+    void prepare() {
+        if (!built) {
+            knownStudents.assign(Symbols::students().size(), 0);
+            for (const Student& student : dm->getAllStudents()) knownStudents[student.getHandle()] = 1;
+            built = true;
+        }
+        if (entries.size() < Symbols::courses().size()) entries.resize(Symbols::courses().size());
+    }
+
+    const Entry* fresh(const string& courseID) {
+        Handle course = Symbols::courses().find(courseID);
+        if (course >= entries.size() || !dm->view().getCourse(course)) return nullptr;
+        Entry& e = entries[course];
+        if (e.stale) rebuild(course, e);
+        return &e;
+    }
+
+    void leave(Handle student, Handle course) {
+        lock_guard<mutex> guard(lock);
+        if (!built || course >= entries.size()) return;
+        Entry& e = entries[course];
+        uint64_t hash = sketchHash(student);
+        if (e.minHash.defines(hash) || e.distinct.defines(hash)) e.stale = true;
+    }
+
+public:
+    explicit CourseSketches(DataManager* manager) : dm(manager), built(false) {
+        dm->addObserver(this);
+    }
+
+    ~CourseSketches() { dm->removeObserver(this); }
+
+    void onEnrolled(Handle student, Handle course, int) {
+        lock_guard<mutex> guard(lock);
+        if (!built || course >= entries.size() || entries[course].stale) return;
+        Entry& e = entries[course];
+        uint64_t hash = sketchHash(student);
+        e.minHash.add(hash);
+        e.distinct.add(hash);
+    }
+
+    void onCompleted(Handle student, Handle course, int) { leave(student, course); }
+    void onDropped(Handle student, Handle course, int) { leave(student, course); }
+
+    void onStudentAdded(const Student& student) {
+        lock_guard<mutex> guard(lock);
+        if (!built) return;
+        Handle h = student.getHandle();
+        if (h >= knownStudents.size()) knownStudents.resize(h + 1, 0);
+        bool replaced = knownStudents[h];
+        knownStudents[h] = 1;
+
+        // A replaced record may have left courses without a drop notification.
+        if (replaced) {
+            for (Entry& e : entries) e.stale = true;
+            return;
+        }
+        uint64_t hash = sketchHash(h);
+        for (Handle course : student.getEnrolledHandles()) {
+            if (course >= entries.size() || entries[course].stale) continue;
+            Entry& e = entries[course];
+            e.minHash.add(hash);
+            e.distinct.add(hash);
+        }
+    }
+
+    void onCleared() {
+        lock_guard<mutex> guard(lock);
+        entries.clear();
+        knownStudents.clear();
+        built = false;
+    }
+
+    // Estimated Jaccard similarity |A ∩ B| / |A ∪ B| of two course rosters;
+    // 0 for unknown or empty courses.
+    double jaccard(const string& courseA, const string& courseB) {
+        lock_guard<mutex> guard(lock);
+        prepare();
+        const Entry* a = fresh(courseA);
+        const Entry* b = fresh(courseB);
+        return a && b ? MinHashSketch::jaccard(a->minHash, b->minHash) : 0.0;
+    }
+
+    // Estimated students in both courses: J / (1 + J) x (|A| + |B|), with the
+    // exact roster sizes.
+    double overlap(const string& courseA, const string& courseB) {
+        double j = jaccard(courseA, courseB);
+        return j / (1 + j) * (dm->getEnrolledStudents(courseA).size() + dm->getEnrolledStudents(courseB).size());
+    }
+
+    // Estimated distinct students enrolled in any of the courses.
+    double distinctStudents(const vector<string>& courseIDs) {
+        lock_guard<mutex> guard(lock);
+        prepare();
+        HyperLogLog total;
+        for (const string& courseID : courseIDs) {
+            const Entry* e = fresh(courseID);
+            if (e) total.merge(e->distinct);
+        }
+        return total.estimate();
+    }
+};
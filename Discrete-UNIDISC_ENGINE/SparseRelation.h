@@ -0,0 +1,333 @@
+#pragma once
+
+#include "BitMatrix.h"
+#include <vector>
+#include <string>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <atomic>
+#include <unordered_map>
+
+using namespace std;
+
+// Outcome of a property check on a relation over one ID space. When the
+// property fails, a, b and c give a counterexample:
+//   reflexive      (a, a) is missing
+//   symmetric      (a, b) is present, (b, a) is not
+//   antisymmetric  (a, b) and (b, a) are both present, a != b
+//   transitive     (a, b) and (b, c) are present, (a, c) is not
+// The row checks report the counterexample with the smallest a, whatever
+// the thread count.
+struct RelationCheck {
+    bool holds;
+    uint32_t a, b, c;
+
+    RelationCheck() : holds(true), a(0), b(0), c(0) {}
+    RelationCheck(uint32_t x, uint32_t y, uint32_t z) : holds(false), a(x), b(y), c(z) {}
+};
+
+// Binary relation between two dense ID spaces (rows 0..rows-1, columns
+// 0..columns-1) in compressed sparse row form: the columns related to row r
+// are columns[offsets[r] .. offsets[r + 1]), sorted and distinct.
+//
+// Building sorts the pairs with two counting passes, and transpose() is the
+// same counting sort the other way round, both O(pairs + rows + columns).
+// compose() is a sparse boolean product (Gustavson): a row of R ∘ S is the
+// union of the S rows named by the R row, gathered with a dense marker. Rows
+// are split into contiguous ranges of equal work and computed on separate
+// threads, so cost is the number of (a, b, c) join triples, never |R| x |S|.
+class SparseRelation {
+public:
+    typedef pair<uint32_t, uint32_t> Edge;
+
+private:
+    size_t rowCount;
+    size_t columnCount;
+    vector<size_t> offsets;
+    vector<uint32_t> columns;
+
+    struct Slice {
+        vector<size_t> lengths;
+        vector<uint32_t> columns;
+    };
+
+    void multiply(const SparseRelation& other, size_t first, size_t last, Slice& out) const {
+        vector<uint32_t> seenInRow(other.columnCount, 0); // row + 1 that last touched each column
+        vector<uint32_t> touched;
+        for (size_t r = first; r < last; r++) {
+            touched.clear();
+            for (size_t i = offsets[r]; i < offsets[r + 1]; i++) {
+                uint32_t middle = columns[i];
+                if (middle >= other.rowCount) continue;
+                for (size_t j = other.offsets[middle]; j < other.offsets[middle + 1]; j++) {
+                    uint32_t c = other.columns[j];
+                    if (seenInRow[c] != r + 1) {
+                        seenInRow[c] = (uint32_t)(r + 1);
+                        touched.push_back(c);
+                    }
+                }
+            }
+            sort(touched.begin(), touched.end());
+            out.columns.insert(out.columns.end(), touched.begin(), touched.end());
+            out.lengths.push_back(touched.size());
+        }
+    }
+
+    // Runs check(worker, row, result) over the rows split into one range per
+    // thread and returns the failure at the lowest row. A worker stops at its
+    // first failure, or once another worker has failed at a lower row.
+    template<typename F>
+    RelationCheck firstFailure(unsigned threads, F check) const {
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        threads = (unsigned)max((size_t)1, min((size_t)threads, rowCount));
+        vector<RelationCheck> found(threads);
+        atomic<size_t> cutoff(rowCount);
+        auto scan = [&](unsigned t) {
+            size_t last = rowCount * (t + 1) / threads;
+            for (size_t r = rowCount * t / threads; r < last && r < cutoff.load(memory_order_relaxed); r++) {
+                if (check(t, r, found[t])) continue;
+                size_t seen = cutoff.load();
+                while (r < seen && !cutoff.compare_exchange_weak(seen, r)) {}
+                return;
+            }
+        };
+        if (threads == 1) scan(0);
+        else {
+            vector<thread> pool;
+            for (unsigned t = 0; t < threads; t++) pool.push_back(thread(scan, t));
+            for (thread& t : pool) t.join();
+        }
+        for (const RelationCheck& f : found) {
+            if (!f.holds) return f;
+        }
+        return RelationCheck();
+    }
+
+public:
+    SparseRelation() : rowCount(0), columnCount(0), offsets(1, 0) {}
+
+    // Pairs may repeat and come in any order; every ID must be below its bound.
+    SparseRelation(size_t rows, size_t cols, const vector<Edge>& pairs) : rowCount(rows), columnCount(cols) {
+        // Bucket by column, then stably by row: rows come out sorted by column.
+        vector<size_t> byColumn(cols + 1, 0);
+        for (const Edge& e : pairs) byColumn[e.second + 1]++;
+        for (size_t c = 0; c < cols; c++) byColumn[c + 1] += byColumn[c];
+        vector<uint32_t> rowOf(pairs.size());
+        for (const Edge& e : pairs) rowOf[byColumn[e.second]++] = e.first;
+
+        offsets.assign(rows + 1, 0);
+        for (const Edge& e : pairs) offsets[e.first + 1]++;
+        for (size_t r = 0; r < rows; r++) offsets[r + 1] += offsets[r];
+        vector<uint32_t> sorted(pairs.size());
+        vector<size_t> next(offsets.begin(), offsets.end() - 1);
+        size_t p = 0;
+        for (size_t c = 0; c < cols; c++) {
+            for (; p < byColumn[c]; p++) sorted[next[rowOf[p]]++] = (uint32_t)c;
+        }
+
+        // Drop repeats in place.
+        columns.reserve(sorted.size());
+        size_t begin = 0;
+        for (size_t r = 0; r < rows; r++) {
+            size_t end = offsets[r + 1];
+            offsets[r] = columns.size();
+            for (size_t i = begin; i < end; i++) {
+                if (i == begin || sorted[i] != sorted[i - 1]) columns.push_back(sorted[i]);
+            }
+            begin = end;
+        }
+        offsets[rows] = columns.size();
+    }
+
+    size_t rows() const { return rowCount; }
+    size_t columnsCount() const { return columnCount; }
+    size_t pairCount() const { return columns.size(); }
+
+    const uint32_t* rowBegin(size_t r) const { return columns.data() + offsets[r]; }
+    const uint32_t* rowEnd(size_t r) const { return columns.data() + offsets[r + 1]; }
+    size_t rowSize(size_t r) const { return offsets[r + 1] - offsets[r]; }
+
+    bool contains(size_t r, uint32_t c) const {
+        return r < rowCount && binary_search(rowBegin(r), rowEnd(r), c);
+    }
+
+    SparseRelation transpose() const {
+        SparseRelation t;
+        t.rowCount = columnCount;
+        t.columnCount = rowCount;
+        t.offsets.assign(columnCount + 1, 0);
+        for (uint32_t c : columns) t.offsets[c + 1]++;
+        for (size_t c = 0; c < columnCount; c++) t.offsets[c + 1] += t.offsets[c];
+        t.columns.resize(columns.size());
+        vector<size_t> next(t.offsets.begin(), t.offsets.end() - 1);
+        for (size_t r = 0; r < rowCount; r++) {
+            for (size_t i = offsets[r]; i < offsets[r + 1]; i++) t.columns[next[columns[i]]++] = (uint32_t)r;
+        }
+        return t;
+    }
+
+    // { (a, c) : (a, b) in this, (b, c) in other }. 0 threads means one per
+    // hardware thread.
+    SparseRelation compose(const SparseRelation& other, unsigned threads = 0) const {
+        vector<size_t> work(rowCount + 1, 0);
+        for (size_t r = 0; r < rowCount; r++) {
+            size_t rowWork = 1;
+            for (size_t i = offsets[r]; i < offsets[r + 1]; i++) {
+                if (columns[i] < other.rowCount) rowWork += other.rowSize(columns[i]);
+            }
+            work[r + 1] = work[r] + rowWork;
+        }
+
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        threads = (unsigned)max((size_t)1, min((size_t)threads, rowCount));
+        vector<size_t> bounds(1, 0);
+        for (unsigned t = 1; t < threads; t++) {
+            size_t target = work[rowCount] / threads * t;
+            bounds.push_back(max(bounds.back(), (size_t)(lower_bound(work.begin(), work.end(), target) - work.begin())));
+        }
+        bounds.push_back(rowCount);
+
+        vector<Slice> slices(threads);
+        if (threads == 1) multiply(other, 0, rowCount, slices[0]);
+        else {
+            vector<thread> pool;
+            for (unsigned t = 0; t < threads; t++) {
+                pool.push_back(thread([&, t]() { multiply(other, bounds[t], bounds[t + 1], slices[t]); }));
+            }
+            for (thread& t : pool) t.join();
+        }
+
+        SparseRelation result;
+        result.rowCount = rowCount;
+        result.columnCount = other.columnCount;
+        for (const Slice& slice : slices) {
+            for (size_t length : slice.lengths) result.offsets.push_back(result.offsets.back() + length);
+            result.columns.insert(result.columns.end(), slice.columns.begin(), slice.columns.end());
+        }
+        return result;
+    }
+
+    // ---- property checks, for relations whose columns are row IDs ----
+
+    // Every ID of `domain` relates to itself; the first one that does not,
+    // in domain order, is the counterexample.
+    RelationCheck checkReflexive(const vector<uint32_t>& domain) const {
+        for (uint32_t a : domain) {
+            if (!contains(a, a)) return RelationCheck(a, a, 0);
+        }
+        return RelationCheck();
+    }
+
+    // Each row must be contained in the same row of the transpose; rows are
+    // sorted, so that is one merge per row.
+    RelationCheck checkSymmetric(unsigned threads = 0) const {
+        SparseRelation t = transpose();
+        return firstFailure(threads, [&](unsigned, size_t a, RelationCheck& out) {
+            const uint32_t* other = a < t.rowCount ? t.rowBegin(a) : nullptr;
+            const uint32_t* otherEnd = a < t.rowCount ? t.rowEnd(a) : nullptr;
+            for (const uint32_t* b = rowBegin(a); b != rowEnd(a); ++b) {
+                while (other != otherEnd && *other < *b) ++other;
+                if (other == otherEnd || *other != *b) {
+                    out = RelationCheck((uint32_t)a, *b, 0);
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+
+    // A row and the same row of the transpose may share only the diagonal.
+    RelationCheck checkAntisymmetric(unsigned threads = 0) const {
+        SparseRelation t = transpose();
+        return firstFailure(threads, [&](unsigned, size_t a, RelationCheck& out) {
+            if (a >= t.rowCount) return true;
+            const uint32_t* other = t.rowBegin(a);
+            for (const uint32_t* b = rowBegin(a); b != rowEnd(a); ++b) {
+                while (other != t.rowEnd(a) && *other < *b) ++other;
+                if (other != t.rowEnd(a) && *other == *b && *b != a) {
+                    out = RelationCheck((uint32_t)a, *b, 0);
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+
+    // For every (a, b), row b must be a subset of row a. Row a is spread into
+    // a per-worker bitset; a row b with fewer entries than the bitset has words
+    // is probed entry by entry, a longer one is kept as a bitset of its own and
+    // compared word by word. Such rows number at most pairs / words, so those
+    // bitsets take O(pairs) words, and each (a, b) costs at most one word per
+    // 64 IDs however long row b is.
+    RelationCheck checkTransitive(unsigned threads = 0) const {
+        const uint32_t LIGHT = 0xFFFFFFFFu;
+        size_t ids = max(rowCount, columnCount);
+        size_t words = BitOps::wordsFor(ids);
+        vector<uint32_t> heavy(rowCount, LIGHT);
+        vector<uint64_t> heavyBits;
+        for (size_t b = 0; b < rowCount; b++) {
+            if (rowSize(b) < words) continue;
+            heavy[b] = (uint32_t)(heavyBits.size() / words);
+            heavyBits.resize(heavyBits.size() + words, 0);
+            uint64_t* row = &heavyBits[heavy[b] * words];
+            for (const uint32_t* c = rowBegin(b); c != rowEnd(b); ++c) row[*c >> 6] |= 1ULL << (*c & 63);
+        }
+
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        vector<vector<uint64_t>> marks(threads, vector<uint64_t>(words, 0));
+        return firstFailure(threads, [&](unsigned t, size_t a, RelationCheck& out) {
+            uint64_t* mark = marks[t].data();
+            for (const uint32_t* b = rowBegin(a); b != rowEnd(a); ++b) mark[*b >> 6] |= 1ULL << (*b & 63);
+
+            bool closed = true;
+            for (const uint32_t* b = rowBegin(a); closed && b != rowEnd(a); ++b) {
+                if (*b >= rowCount) continue;
+                if (heavy[*b] != LIGHT) {
+                    const uint64_t* row = &heavyBits[heavy[*b] * words];
+                    for (size_t w = 0; w < words && closed; w++) {
+                        uint64_t extra = row[w] & ~mark[w];
+                        if (extra) {
+                            out = RelationCheck((uint32_t)a, *b, (uint32_t)(w * 64 + BitOps::lowestBit(extra)));
+                            closed = false;
+                        }
+                    }
+                    continue;
+                }
+                for (const uint32_t* c = rowBegin(*b); c != rowEnd(*b); ++c) {
+                    if (!((mark[*c >> 6] >> (*c & 63)) & 1)) {
+                        out = RelationCheck((uint32_t)a, *b, *c);
+                        closed = false;
+                        break;
+                    }
+                }
+            }
+
+            for (const uint32_t* b = rowBegin(a); b != rowEnd(a); ++b) mark[*b >> 6] = 0;
+            return closed;
+        });
+    }
+};
+
+// Dense IDs for names, in first-seen order, for relations kept over strings.
+class NameIndex {
+private:
+    unordered_map<string, uint32_t> ids;
+    vector<const string*> names;
+
+public:
+    uint32_t intern(const string& name) {
+        auto it = ids.emplace(name, (uint32_t)names.size()).first;
+        if (it->second == names.size()) names.push_back(&it->first);
+        return it->second;
+    }
+
+    // The ID of a name, or size() if it has none.
+    uint32_t find(const string& name) const {
+        auto it = ids.find(name);
+        return it == ids.end() ? (uint32_t)names.size() : it->second;
+    }
+
+    size_t size() const { return names.size(); }
+    const string& name(uint32_t id) const { return *names[id]; }
+};
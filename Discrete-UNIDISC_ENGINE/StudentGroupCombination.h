@@ -54,14 +54,14 @@ private:
     }
 
 public:
-    CombinationsModule() {
-        dm = DataManager::getInstance();
+    explicit CombinationsModule(DataManager* manager) {
+        dm = manager;
     }
 
     vector<vector<string>> formProjectGroups(int groupSize) {
         vector<string> studentIDs;
-        for (auto& pair : dm->getAllStudents()) {
-            studentIDs.push_back(pair.first);
+        for (const Student& student : dm->getAllStudents()) {
+            studentIDs.push_back(student.getID());
         }
 
         if (studentIDs.empty() || groupSize <= 0 || groupSize > studentIDs.size()) {
@@ -81,11 +81,8 @@ public:
 
         
         vector<string> enrolledStudents;
-        for (auto& pair : dm->getAllStudents()) {
-            Student& student = pair.second;
-            if (student.getEnrolledCourses().find(courseID) != student.getEnrolledCourses().end()) {
-                enrolledStudents.push_back(student.getID());
-            }
+        for (Handle h : dm->getEnrolledStudents(courseID)) {
+            enrolledStudents.push_back(Symbols::students().name(h));
         }
 
         if (enrolledStudents.empty()) {
@@ -94,11 +91,8 @@ public:
         }
 
         vector<Lab*> courseLabs;
-        for (auto& pair : dm->getAllLabs()) {
-            Lab& lab = pair.second;
-            if (lab.getAssociatedCourse() == courseID) {
-                courseLabs.push_back(&lab);
-            }
+        for (Handle h : dm->getCourseLabs(courseID)) {
+            courseLabs.push_back(dm->getLab(h));
         }
 
         if (courseLabs.empty()) {
@@ -138,8 +132,8 @@ public:
 
         
         vector<string> studentIDs;
-        for (auto& pair : dm->getAllStudents()) {
-            studentIDs.push_back(pair.first);
+        for (const Student& student : dm->getAllStudents()) {
+            studentIDs.push_back(student.getID());
         }
 
         int courseIndex = 0;
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "BitMatrix.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+using namespace std;
+
+// One position of a subset walk: which elements are in the current subset
+// and how it differs from the subset visited just before.
+struct SubsetStep {
+    static const size_t NONE = (size_t)-1;
+
+    uint64_t rank;          // position in Gray-code order
+    size_t changed;         // element added or removed by this step, or NONE
+    bool added;
+    const uint64_t* members; // membership bits, one per element
+    size_t size;            // number of elements in the subset
+
+    bool contains(size_t element) const { return (members[element >> 6] >> (element & 63)) & 1; }
+};
+
+// Streams the subsets of n elements in reflected Gray-code order: subset k
+// has the bits of k ^ (k >> 1), so consecutive subsets differ by exactly one
+// element (the lowest set bit of k) and a visitor can keep running totals
+// with one update per step instead of rebuilding each subset.
+//
+// Nothing is materialized, so memory is O(n) whatever the subset count. The
+// visitor returns false to stop early. Subsets are ranked with 64-bit
+// integers, so a walk covers at most 2^63 of them; with more than 63 elements
+// only the first 63 ever change, which no walk will finish anyway.
+class GraySubsets {
+private:
+    size_t n;
+
+    static uint64_t gray(uint64_t k) { return k ^ (k >> 1); }
+
+    static int changedBit(uint64_t k) { return BitOps::lowestBit(k); }
+
+public:
+    explicit GraySubsets(size_t elements) : n(elements) {}
+
+    size_t elements() const { return n; }
+
+    // 2^n, capped at 2^63.
+    uint64_t count() const { return n >= 63 ? (uint64_t)1 << 63 : (uint64_t)1 << n; }
+
+    // Visits subsets with ranks in [first, last). The first visit reports the
+    // whole subset at `first` with changed == NONE; every later one is a
+    // single insert or remove. Returns false if the visitor stopped the walk.
+    template<typename F>
+    bool walk(uint64_t first, uint64_t last, F visit) const {
+        last = min(last, count());
+        if (first >= last) return true;
+
+        vector<uint64_t> members(BitOps::wordsFor(max(n, (size_t)1)), 0);
+        uint64_t start = gray(first);
+        members[0] = start;
+        SubsetStep step;
+        step.rank = first;
+        step.changed = SubsetStep::NONE;
+        step.added = false;
+        step.members = members.data();
+        step.size = BitOps::popcount(start);
+        if (!visit(step)) return false;
+
+        for (uint64_t k = first + 1; k < last; k++) {
+            int bit = changedBit(k);
+            members[0] ^= 1ULL << bit;
+            step.rank = k;
+            step.changed = (size_t)bit;
+            step.added = (members[0] >> bit) & 1;
+            if (step.added) step.size++;
+            else step.size--;
+            if (!visit(step)) return false;
+        }
+        return true;
+    }
+
+    template<typename F>
+    bool walk(F visit) const { return walk(0, count(), visit); }
+
+    // Splits the ranks into one contiguous range per thread and walks them
+    // concurrently; visit(step, worker) must be safe to call from several
+    // threads, typically by keeping per-worker state indexed by `worker`.
+    // When any visitor returns false the other workers stop at their next
+    // step. Returns false if the walk was stopped.
+    template<typename F>
+    bool walkParallel(unsigned threads, F visit) const {
+        if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+        uint64_t total = count();
+        if (threads > total) threads = (unsigned)total;
+
+        atomic<bool> stopped(false);
+        vector<thread> pool;
+        for (unsigned w = 0; w < threads; w++) {
+            uint64_t first = total / threads * w + min<uint64_t>(w, total % threads);
+            uint64_t last = first + total / threads + (w < total % threads ? 1 : 0);
+            pool.push_back(thread([&, w, first, last]() {
+                bool finished = walk(first, last, [&](const SubsetStep& step) {
+                    if (stopped.load(memory_order_relaxed)) return false;
+                    return (bool)visit(step, w);
+                });
+                if (!finished) stopped = true;
+            }));
+        }
+        for (thread& t : pool) t.join();
+        return !stopped;
+    }
+};
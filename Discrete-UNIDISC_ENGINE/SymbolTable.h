@@ -0,0 +1,278 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <atomic>
+#include <memory>
+
+using namespace std;
+
+// Dense integer handle for an interned entity ID (course, student, faculty, room, lab).
+typedef uint32_t Handle;
+const Handle INVALID_HANDLE = 0xFFFFFFFFu;
+
+// Maps string IDs to dense handles 0..n-1 in first-seen order.
+// Strings are only needed at the I/O boundary; everything else works on handles.
+//
+// Safe to share between threads (the tables are process-wide and several
+// DataManagers may intern at once). Only intern() takes a lock. Names live in
+// fixed-size chunks whose directory is allocated up front and never moves,
+// and the ID -> handle index is an open-addressed table of atomic slots that
+// is only ever added to, so find(), name() and size() never lock. A name is
+// stored before its slot and counted after it, so any handle size() or a
+// slot reports resolves both ways. When the index grows, the bigger copy is
+// filled before it is swapped in and the old one is kept for readers still
+// probing it.
+class SymbolTable {
+private:
+    static const size_t CHUNK_SHIFT = 12;
+    static const size_t CHUNK_SIZE = (size_t)1 << CHUNK_SHIFT;
+    static const size_t MAX_CHUNKS = (size_t)1 << 14; // room for 64M names
+
+    // Slot = (hash tag << 32) | (handle + 1), 0 while empty. At most half full.
+    struct Index {
+        size_t mask;
+        unique_ptr<atomic<uint64_t>[]> slots;
+
+        explicit Index(size_t capacity) : mask(capacity - 1), slots(new atomic<uint64_t>[capacity]) {
+            for (size_t i = 0; i < capacity; i++) slots[i].store(0, memory_order_relaxed);
+        }
+
+        void insert(uint64_t hash, Handle h) {
+            size_t i = (size_t)hash & mask;
+            while (slots[i].load(memory_order_relaxed)) i = (i + 1) & mask;
+            slots[i].store((hash & 0xFFFFFFFF00000000ULL) | ((uint64_t)h + 1), memory_order_release);
+        }
+    };
+
+    mutable mutex lock; // serializes intern()
+    unique_ptr<atomic<string*>[]> chunks;
+    atomic<size_t> count;
+    atomic<Index*> index;
+    vector<unique_ptr<Index>> indexes; // every index published, current last
+
+    SymbolTable(const SymbolTable&);
+    SymbolTable& operator=(const SymbolTable&);
+
+    static uint64_t hashOf(const string& id) {
+        uint64_t h = (uint64_t)std::hash<string>()(id) * 0x9E3779B97F4A7C15ULL;
+        return h ^ (h >> 32);
+    }
+
+    // Name of a handle that may not be counted yet; its slot or index publishes it.
+    const string& stored(Handle h) const {
+        return chunks[h >> CHUNK_SHIFT].load(memory_order_acquire)[h & (CHUNK_SIZE - 1)];
+    }
+
+    // Publishes a bigger index holding handles 0..n-1.
+    void grow(size_t capacity, size_t n) {
+        unique_ptr<Index> bigger(new Index(capacity));
+        for (size_t h = 0; h < n; h++) bigger->insert(hashOf(stored((Handle)h)), (Handle)h);
+        index.store(bigger.get(), memory_order_release);
+        indexes.push_back(move(bigger));
+    }
+
+public:
+    SymbolTable() : chunks(new atomic<string*>[MAX_CHUNKS]), count(0), index(nullptr) {
+        for (size_t i = 0; i < MAX_CHUNKS; i++) chunks[i].store(nullptr);
+        grow(1024, 0);
+    }
+
+    ~SymbolTable() {
+        for (size_t i = 0; i < MAX_CHUNKS; i++) delete[] chunks[i].load();
+    }
+
+    Handle intern(const string& id) {
+        lock_guard<mutex> guard(lock);
+        Handle existing = find(id);
+        if (existing != INVALID_HANDLE) return existing;
+
+        size_t h = count.load(memory_order_relaxed);
+        string* chunk = chunks[h >> CHUNK_SHIFT].load(memory_order_relaxed);
+        if (!chunk) {
+            chunk = new string[CHUNK_SIZE];
+            chunks[h >> CHUNK_SHIFT].store(chunk, memory_order_release);
+        }
+        chunk[h & (CHUNK_SIZE - 1)] = id;
+
+        Index* current = index.load(memory_order_relaxed);
+        if ((h + 1) * 2 > current->mask + 1) grow((current->mask + 1) * 2, h + 1);
+        else current->insert(hashOf(id), (Handle)h);
+        count.store(h + 1, memory_order_release);
+        return (Handle)h;
+    }
+
+    // Returns INVALID_HANDLE for IDs that were never interned.
+    Handle find(const string& id) const {
+        uint64_t hash = hashOf(id);
+        const Index* current = index.load(memory_order_acquire);
+        for (size_t i = (size_t)hash & current->mask;; i = (i + 1) & current->mask) {
+            uint64_t slot = current->slots[i].load(memory_order_acquire);
+            if (!slot) return INVALID_HANDLE;
+            Handle h = (Handle)(slot & 0xFFFFFFFFu) - 1;
+            if ((slot >> 32) == (hash >> 32) && stored(h) == id) return h;
+        }
+    }
+
+    const string& name(Handle h) const {
+        static const string empty;
+        if (h >= count.load(memory_order_acquire)) return empty;
+        return stored(h);
+    }
+
+    size_t size() const { return count.load(memory_order_acquire); }
+};
+
+// Process-wide symbol tables, one per entity kind.
+struct Symbols {
+    static SymbolTable& courses() { static SymbolTable table; return table; }
+    static SymbolTable& students() { static SymbolTable table; return table; }
+    static SymbolTable& faculty() { static SymbolTable table; return table; }
+    static SymbolTable& rooms() { static SymbolTable table; return table; }
+    static SymbolTable& labs() { static SymbolTable table; return table; }
+};
+
+// Sorted vector of handles used as a compact set.
+class HandleSet {
+private:
+    vector<Handle> items;
+
+public:
+    typedef vector<Handle>::const_iterator const_iterator;
+
+    bool insert(Handle h) {
+        auto it = lower_bound(items.begin(), items.end(), h);
+        if (it != items.end() && *it == h) return false;
+        items.insert(it, h);
+        return true;
+    }
+
+    bool erase(Handle h) {
+        auto it = lower_bound(items.begin(), items.end(), h);
+        if (it == items.end() || *it != h) return false;
+        items.erase(it);
+        return true;
+    }
+
+    bool contains(Handle h) const {
+        return binary_search(items.begin(), items.end(), h);
+    }
+
+    // Bulk-load helper: h must be greater than every handle already present.
+    void appendSorted(Handle h) { items.push_back(h); }
+
+    size_t size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+    void clear() { items.clear(); }
+
+    const_iterator begin() const { return items.begin(); }
+    const_iterator end() const { return items.end(); }
+    const vector<Handle>& data() const { return items; }
+
+    bool operator==(const HandleSet& other) const { return items == other.items; }
+    bool operator!=(const HandleSet& other) const { return items != other.items; }
+};
+
+// Handle -> uint32_t map for one owner's share of a process-wide table.
+// Handles are global, so an owner holding a few thousand of them may see
+// values anywhere up to the table size; slots live in pages of PAGE_SIZE
+// allocated on first write, so memory follows the handles actually stored.
+// Copies share pages and a write copies its page if it is still shared.
+class HandleMap {
+private:
+    static const size_t PAGE_SHIFT = 10;
+    static const size_t PAGE_SIZE = (size_t)1 << PAGE_SHIFT;
+
+    typedef vector<uint32_t> Page;
+    vector<shared_ptr<Page>> pages;
+
+public:
+    enum : uint32_t { NONE = 0xFFFFFFFFu };
+
+    uint32_t get(Handle h) const {
+        size_t p = h >> PAGE_SHIFT;
+        return p < pages.size() && pages[p] ? (*pages[p])[h & (PAGE_SIZE - 1)] : (uint32_t)NONE;
+    }
+
+    void put(Handle h, uint32_t value) {
+        size_t p = h >> PAGE_SHIFT;
+        if (p >= pages.size()) pages.resize(p + 1);
+        if (!pages[p]) pages[p] = make_shared<Page>(PAGE_SIZE, (uint32_t)NONE);
+        else if (pages[p].use_count() > 1) pages[p] = make_shared<Page>(*pages[p]);
+        (*pages[p])[h & (PAGE_SIZE - 1)] = value;
+    }
+
+    // Bytes held in pages, counting shared pages in full.
+    size_t bytes() const {
+        size_t total = pages.size() * sizeof(shared_ptr<Page>);
+        for (const shared_ptr<Page>& page : pages) {
+            if (page) total += PAGE_SIZE * sizeof(uint32_t);
+        }
+        return total;
+    }
+
+    void clear() { pages.clear(); }
+};
+
+inline set<string> toNameSet(const HandleSet& handles, const SymbolTable& table) {
+    set<string> result;
+    for (Handle h : handles) {
+        result.insert(table.name(h));
+    }
+    return result;
+}
+
+// Read-only view of a HandleSet that iterates as string IDs, without copying.
+// Valid as long as the record that owns the set is alive and unmodified.
+class IdSetView {
+private:
+    const HandleSet* handles;
+    const SymbolTable* table;
+
+public:
+    class const_iterator {
+    private:
+        HandleSet::const_iterator it;
+        const SymbolTable* table;
+
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef string value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const string* pointer;
+        typedef const string& reference;
+
+        const_iterator(HandleSet::const_iterator i, const SymbolTable* t) : it(i), table(t) {}
+
+        const string& operator*() const { return table->name(*it); }
+        const string* operator->() const { return &table->name(*it); }
+        Handle handle() const { return *it; }
+
+        const_iterator& operator++() { ++it; return *this; }
+        const_iterator operator++(int) { const_iterator old = *this; ++it; return old; }
+
+        bool operator==(const const_iterator& other) const { return it == other.it; }
+        bool operator!=(const const_iterator& other) const { return it != other.it; }
+    };
+
+    IdSetView(const HandleSet& h, const SymbolTable& t) : handles(&h), table(&t) {}
+
+    const_iterator begin() const { return const_iterator(handles->begin(), table); }
+    const_iterator end() const { return const_iterator(handles->end(), table); }
+    size_t size() const { return handles->size(); }
+    bool empty() const { return handles->empty(); }
+
+    bool contains(Handle h) const { return handles->contains(h); }
+    bool contains(const string& id) const {
+        Handle h = table->find(id);
+        return h != INVALID_HANDLE && handles->contains(h);
+    }
+
+    const HandleSet& getHandles() const { return *handles; }
+    set<string> toSet() const { return toNameSet(*handles, *table); }
+};
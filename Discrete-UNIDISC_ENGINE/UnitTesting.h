@@ -11,16 +11,41 @@
 #include "AutomatedProofVerification.h"
 #include "ConsistencyChecker.h"
 #include "AlgorithmicEfficiency.h"
+#include "CatalogSnapshot.h"
+#include "CsvImporter.h"
+#include "MutationLog.h"
 
 #include <iostream>
 #include <vector>
 #include <string>
 #include <chrono>
 #include <iomanip>
+#include <fstream>
+#include <thread>
 
 using namespace std;
 using namespace std::chrono;
 
+// Journal whose next writes fail after putting half the batch on disk, the
+// way a full disk tears a record.
+class FailingMutationLog : public MutationLog {
+private:
+    int failuresLeft;
+
+protected:
+    bool writeBatch(const char* data, size_t length) {
+        if (failuresLeft == 0) return MutationLog::writeBatch(data, length);
+        failuresLeft--;
+        MutationLog::writeBatch(data, length / 2);
+        return false;
+    }
+
+public:
+    FailingMutationLog() : failuresLeft(0) {}
+
+    void failNextWrites(int count) { failuresLeft = count; }
+};
+
 class UnitTestingModule {
 private:
     DataManager* dm;
@@ -98,16 +123,14 @@ private:
     }
 
 public:
-    UnitTestingModule() : testsRun(0), testsPassed(0), testsFailed(0) {
-        dm = DataManager::getInstance();
-    }
+    explicit UnitTestingModule(DataManager* manager) : dm(manager), testsRun(0), testsPassed(0), testsFailed(0) {}
 
     void testSchedulingModule() {
         cout << "\n========================================" << endl;
         cout << "TESTING MODULE 1: COURSE SCHEDULING" << endl;
         cout << "========================================\n" << endl;
 
-        SchedulingModule scheduling;
+        SchedulingModule scheduling(dm);
 
         
         Course* course = dm->getCourse("CS101");
@@ -120,6 +143,24 @@ public:
         
         Course* cs102 = dm->getCourse("CS102");
         assert_equal((int)cs102->getPrerequisites().size(), 1, "CS102 has 1 prerequisite");
+        assert_true(cs102->requiresCourse("CS101"), "CS102 requires CS101");
+
+        
+        Student* s101 = dm->getStudent("S101");
+        assert_true(s101->hasCompleted("CS101") && s101->isEnrolled("CS102") && !s101->isEnrolled("CS101"),
+            "Enrollment membership queries");
+
+
+        vector<string> available = scheduling.predictAvailableCourses("S101");
+        assert_true(find(available.begin(), available.end(), "MATH101") != available.end() &&
+            find(available.begin(), available.end(), "CS201") == available.end(),
+            "Predict available courses from prerequisite bits");
+
+        vector<string> eligible = scheduling.eligibleStudents("CS102");
+        assert_true(eligible.empty(), "No further students eligible for CS102");
+
+        vector<vector<string>> sequences = scheduling.generateValidSequences({ "CS101", "CS102", "MATH101" });
+        assert_equal((int)sequences.size(), 3, "Three valid orderings of CS101, CS102, MATH101");
 
         
         Course* math101 = dm->getCourse("MATH101");
@@ -133,7 +174,7 @@ public:
         cout << "TESTING MODULE 2: STUDENT GROUP COMBINATIONS" << endl;
         cout << "========================================\n" << endl;
 
-        CombinationsModule combinations;
+        CombinationsModule combinations(dm);
 
         
         vector<vector<string>> groups = combinations.formProjectGroups(2);
@@ -156,7 +197,7 @@ public:
         cout << "TESTING MODULE 3: MATHEMATICAL INDUCTION" << endl;
         cout << "========================================\n" << endl;
 
-        InductionModule induction;
+        InductionModule induction(dm);
 
         
         bool baseCase = induction.verifyBaseCase("S101", "CS101");
@@ -178,7 +219,7 @@ public:
         cout << "TESTING MODULE 4: LOGIC & INFERENCE" << endl;
         cout << "========================================\n" << endl;
 
-        LogicEngine logicEngine;
+        LogicEngine logicEngine(dm);
 
         
         logicEngine.addCourseRule("CS102", "CS101");
@@ -204,7 +245,7 @@ public:
         cout << "TESTING MODULE 5: SET OPERATIONS" << endl;
         cout << "========================================\n" << endl;
 
-        SetOperationsModule setOps;
+        SetOperationsModule setOps(dm);
 
         
         set<string> studentSet = setOps.getStudentSet();
@@ -214,6 +255,151 @@ public:
         set<string> courseSet = setOps.getCourseSet();
         assert_equal((int)courseSet.size(), 5, "Course set contains 5 courses");
 
+        
+        set<string> inBoth = setOps.studentsInMultipleCourses({ "CS101", "MATH101" });
+        assert_true(inBoth.size() == 1 && inBoth.count("S102") == 1, "Intersection of course rosters");
+        assert_equal((int)setOps.overlapCount("CS101", "MATH101"), 1, "Overlap count from compressed rosters");
+        assert_true(setOps.unionCount({ "CS101", "MATH101" }) == setOps.studentsInAnyCourse({ "CS101", "MATH101" }).size() &&
+            setOps.differenceCount("CS101", "MATH101") == setOps.studentDifference("CS101", "MATH101").size(),
+            "Cardinality-only variants match the materialized sets");
+
+        RoaringBitmap sparse, dense;
+        for (uint32_t h = 0; h < 200000; h += 7) sparse.add(h);
+        for (uint32_t h = 65536; h < 131072; h++) dense.add(h);
+        dense.runOptimize();
+        size_t expected = 0;
+        for (uint32_t h = 65536; h < 131072; h++) expected += h % 7 == 0;
+        assert_true((sparse & dense).size() == expected && RoaringBitmap::andCount(sparse, dense) == expected &&
+            RoaringBitmap::orCount(sparse, dense) == (sparse | dense).size() && (dense - sparse).size() == 65536 - expected &&
+            dense.contains(70000) && !dense.contains(131072) && dense.bytes() < 64,
+            "Roaring containers agree across array, bitmap and run forms");
+
+        vector<Handle> evens, triples, empty;
+        for (Handle h = 0; h < 3000; h += 2) evens.push_back(h);
+        for (Handle h = 0; h < 3000; h += 3) triples.push_back(h);
+        vector<Handle> sixes = SortedIntersection::all({ HandleRange(evens.data(), evens.data() + evens.size()),
+            HandleRange(triples.data(), triples.data() + triples.size()) });
+        bool multiplesOfSix = sixes.size() == 500;
+        for (Handle h : sixes) if (h % 6) multiplesOfSix = false;
+        assert_true(multiplesOfSix && SortedIntersection::count({ HandleRange(evens.data(), evens.data() + evens.size()),
+            HandleRange(empty.data(), empty.data()) }) == 0 &&
+            setOps.intersectionCount({ "CS101", "MATH101", "CS101" }) == setOps.studentsInMultipleCourses({ "CS101", "MATH101" }).size(),
+            "Galloping k-way intersection of sorted rosters");
+
+        set<uint64_t> seen;
+        bool oneChange = true;
+        uint64_t previous = 0;
+        GraySubsets(5).walk([&](const SubsetStep& step) {
+            if (step.changed != SubsetStep::NONE && BitOps::popcount(step.members[0] ^ previous) != 1) oneChange = false;
+            previous = step.members[0];
+            seen.insert(step.members[0]);
+            return true;
+        });
+        size_t visited = 0;
+        bool stoppedEarly = !GraySubsets(40).walk([&](const SubsetStep&) { return ++visited < 100; });
+        assert_true(seen.size() == 32 && oneChange && stoppedEarly && visited == 100,
+            "Gray-code walk visits every subset once, one change per step");
+
+        atomic<uint64_t> rankSum(0), visits(0);
+        GraySubsets(16).walkParallel(4, [&](const SubsetStep& step, unsigned) {
+            rankSum += step.rank;
+            visits++;
+            return true;
+        });
+        assert_true(visits == 65536 && rankSum == 65536ULL * 65535 / 2, "Parallel subset walk covers every rank exactly once");
+
+        size_t largest = 0;
+        uint64_t streamed = setOps.generatePowerSet(3, [&](const SubsetStep& step, const vector<string>&) {
+            largest = max(largest, step.size);
+            return true;
+        });
+        uint64_t stopped = setOps.generatePowerSet(3, [](const SubsetStep& step, const vector<string>&) { return step.rank < 2; });
+        assert_true(streamed == 8 && largest == 3 && stopped == 3, "Power set streams every subset and stops when asked");
+
+        vector<string> load = setOps.coursesTotalling({ "CS101", "CS102", "CS201", "MATH101", "MATH102" }, 9, 2);
+        int loadCredits = 0;
+        for (const string& courseID : load) loadCredits += dm->getCourse(courseID)->getCredits();
+        assert_true(loadCredits == 9 && setOps.coursesTotalling({ "CS101" }, 100).empty(), "Subset search finds a course load with the target credits");
+
+        set<string> matched, remaining;
+        string queryError;
+        for (const string& s : setOps.studentsInMultipleCourses({ "CS101", "MATH101" })) {
+            if (!dm->getCompletedStudents("CS102").contains(Symbols::students().find(s))) remaining.insert(s);
+        }
+        bool compiled = setOps.studentsMatching("(enrolled(CS101) ∩ enrolled(MATH101)) \\ completed(CS102)", matched, queryError);
+        size_t everyone = 0, nobody = 1;
+        setOps.countMatching("all - (enrolled(CS101) | all)", nobody, queryError);
+        setOps.countMatching("all", everyone, queryError);
+        SetQuery badQuery(dm);
+        assert_true(compiled && matched == remaining && nobody == 0 && everyone == dm->getAllStudents().size() &&
+            !badQuery.compile("enrolled(NO-SUCH-COURSE)") && !badQuery.compile("enrolled(CS101) &") && !badQuery.error().empty(),
+            "Set expressions evaluate like the equivalent set operations");
+
+        SetQuery pinnedQuery(dm);
+        bool pinnedCompiled = pinnedQuery.compile("enrolled(CS101)");
+        size_t pinnedBefore = pinnedQuery.count();
+        Student* latecomer = dm->getStudent("S103");
+        latecomer->enrollCourse("CS101", 3);
+        size_t pinnedAfter = pinnedQuery.count();
+        bool recompiled = pinnedQuery.compile("enrolled(CS101)");
+        size_t fresh = pinnedQuery.count();
+        latecomer->dropCourse("CS101", 3);
+        assert_true(pinnedCompiled && recompiled && pinnedAfter == pinnedBefore && fresh == pinnedBefore + 1,
+            "A compiled set expression keeps reading the version it was compiled against");
+
+        CoEnrollmentMatrix serial(dm), parallel(dm);
+        serial.build(1);
+        parallel.build(3);
+        vector<string> testCourses = { "CS101", "CS102", "CS201", "MATH101", "MATH102" };
+        bool matchesPairwise = true;
+        for (const string& a : testCourses) {
+            for (const string& b : testCourses) {
+                size_t expectedShared = a == b ? dm->getEnrolledStudents(a).size() : setOps.overlapCount(a, b);
+                if (serial.shared(a, b) != expectedShared || parallel.shared(a, b) != expectedShared) matchesPairwise = false;
+            }
+        }
+        vector<CoursePair> topPair = parallel.topPairs(1);
+        vector<CoursePair> allPairs = serial.pairsAtLeast(1);
+        bool topIsLargest = !topPair.empty();
+        for (const CoursePair& pair : allPairs) {
+            if (topIsLargest && pair.shared > topPair[0].shared) topIsLargest = false;
+        }
+        assert_true(matchesPairwise && topIsLargest && allPairs.size() == serial.pairCount() &&
+            parallel.topPairs(allPairs.size() + 5).size() == allPairs.size() && serial.pairsAtLeast(1000).empty(),
+            "Co-enrollment matrix matches pairwise overlaps");
+
+        DataManager tied;
+        vector<string> tiedCourses = { "TEST-TIE-A", "TEST-TIE-B", "TEST-TIE-C", "TEST-TIE-D", "TEST-TIE-E" };
+        Student everyCourse("TEST-TIE-S1", "Tie"), lastTwo("TEST-TIE-S2", "Tie");
+        for (const string& id : tiedCourses) {
+            tied.addCourse(Course(id, "Tie", 3));
+            everyCourse.enrollCourse(id, 3);
+        }
+        lastTwo.enrollCourse("TEST-TIE-D", 3);
+        lastTwo.enrollCourse("TEST-TIE-E", 3);
+        tied.addStudent(everyCourse);
+        tied.addStudent(lastTwo);
+        CoEnrollmentMatrix tiedMatrix(&tied);
+        tiedMatrix.build(1);
+        vector<CoursePair> cutoff = tiedMatrix.topPairs(3);
+        assert_true(cutoff.size() == 3 && cutoff[0].courseA == "TEST-TIE-D" && cutoff[0].shared == 2 &&
+            cutoff[1].courseA == "TEST-TIE-A" && cutoff[1].courseB == "TEST-TIE-B" &&
+            cutoff[2].courseA == "TEST-TIE-A" && cutoff[2].courseB == "TEST-TIE-C",
+            "Top co-enrolled pairs break ties at the cutoff in course ID order");
+
+        unique_ptr<DataManager> sketched = dm->fork();
+        SetOperationsModule sketchOps(sketched.get());
+        vector<string> sketchCourses = { "CS101", "CS102", "CS201", "MATH101", "MATH102" };
+        double before = sketchOps.approximateDistinctStudents(sketchCourses);
+        HandleSet cs101Roster = sketched->getEnrolledStudents("CS101");
+        for (Handle h : cs101Roster) sketched->getStudent(h)->dropCourse("CS101", 3);
+        double afterDrop = sketchOps.approximateDistinctStudents({ "CS101" });
+        for (Handle h : cs101Roster) sketched->getStudent(h)->enrollCourse("CS101", 3);
+        assert_true(fabs(before - setOps.unionCount(sketchCourses)) < 0.5 && afterDrop < 0.5 &&
+            fabs(sketchOps.approximateDistinctStudents({ "CS101" }) - cs101Roster.size()) < 0.5 &&
+            (cs101Roster.empty() || sketchOps.approximateJaccard("CS101", "CS101") == 1.0),
+            "Course sketches track enrollments and drops");
+
         cout << "\nSet Operations Module Tests Complete\n";
     }
 
@@ -222,7 +408,7 @@ public:
         cout << "TESTING MODULE 6: RELATIONS" << endl;
         cout << "========================================\n" << endl;
 
-        RelationsModule relations;
+        RelationsModule relations(dm);
 
         
         set<string> domain = { "A", "B", "C" };
@@ -239,6 +425,68 @@ public:
         bool transitive = relations.isTransitive(transRel);
         assert_true(transitive, "Transitive relation check");
 
+        RelationsModule::Counterexample notTransitive = relations.findNonTransitive({ {"A","B"}, {"B","C"} }, 2);
+        RelationsModule::Counterexample notSymmetric = relations.findNonSymmetric({ {"A","B"}, {"B","A"}, {"B","C"} });
+        RelationsModule::Counterexample notReflexive = relations.findNonReflexive({ {"A","A"}, {"B","B"} }, domain);
+        RelationsModule::Counterexample notOrder = relations.findNonPartialOrder(
+            { {"A","A"}, {"B","B"}, {"C","C"}, {"A","B"}, {"B","A"} }, domain);
+        assert_true(notTransitive.a == "A" && notTransitive.b == "B" && notTransitive.c == "C" &&
+            notSymmetric.a == "B" && notSymmetric.b == "C" && notReflexive.a == "C" &&
+            notOrder.property == RelationsModule::Counterexample::ANTISYMMETRIC &&
+            !relations.findNonTransitive(transRel).found() && relations.isPartialOrder(transRel, set<string>()),
+            "Relation checks return counterexamples");
+
+        set<pair<string, string>> composed = relations.composeRelations(
+            { {"S1","C1"}, {"S1","C2"}, {"S2","C2"} }, { {"C1","F1"}, {"C2","F2"}, {"C3","F3"} });
+        set<pair<string, string>> expectedComposition = { {"S1","F1"}, {"S1","F2"}, {"S2","F2"} };
+        assert_true(composed == expectedComposition, "Relation composition joins on the shared element");
+
+        SparseRelation takes(3, 4, { {0,1}, {2,3}, {0,1}, {0,0} }); // student -> course, one repeat
+        SparseRelation teaches(2, 4, { {0,1}, {1,3} });             // faculty -> course
+        SparseRelation taughtBy = teaches.transpose();
+        SparseRelation studentFaculty = takes.compose(taughtBy, 2);
+        assert_true(takes.pairCount() == 3 && taughtBy.contains(3, 1) && !taughtBy.contains(1, 1) &&
+            studentFaculty.pairCount() == 2 && studentFaculty.contains(0, 0) && studentFaculty.contains(2, 1) &&
+            studentFaculty.rowSize(1) == 0,
+            "Sparse relations transpose and compose by row");
+
+        set<string> cs201Prereqs = relations.allPrerequisitesOf("CS201");
+        set<string> cs101Dependents = relations.coursesRequiring("CS101");
+        vector<size_t> offsets = { 0, 1, 2, 3, 3 };
+        vector<uint32_t> targets = { 1, 2, 0 }; // 0 -> 1 -> 2 -> 0, 3 alone
+        TransitiveClosure cycle;
+        cycle.build(4, offsets, targets, 1);
+        assert_true(cs201Prereqs == set<string>({ "CS101", "CS102" }) && cs101Dependents.count("CS201") &&
+            !cs101Dependents.count("CS101") && cycle.onCycle(0) && cycle.reaches(2, 1) && !cycle.onCycle(3) &&
+            !cycle.reaches(0, 3),
+            "Prerequisite closure follows indirect prerequisites");
+
+        unique_ptr<DataManager> edited = dm->fork();
+        RelationsModule editedRelations(edited.get());
+        bool cycleRejected = !edited->getCourse("CS101")->addPrerequisite("CS201");
+        bool selfRejected = !edited->getCourse("CS102")->setPrerequisites({ "CS102" });
+        edited->getCourse("CS101")->addPrerequisite("MATH102");
+        set<string> grown = editedRelations.allPrerequisitesOf("CS201");
+        edited->getCourse("CS102")->removePrerequisite("CS101");
+        set<string> shrunk = editedRelations.allPrerequisitesOf("CS201");
+        assert_true(cycleRejected && selfRejected && grown == set<string>({ "CS101", "CS102", "MATH101", "MATH102" }) &&
+            shrunk == set<string>({ "CS102" }) && !editedRelations.coursesRequiring("MATH101").count("CS201") &&
+            edited->getCourse("CS101")->requiresCourse("MATH102") && !edited->getCourse("CS101")->requiresCourse("CS201"),
+            "Prerequisite edits update the closure and reject cycles");
+
+        Course looped("CS102", "Data Structures", 3);
+        looped.addPrerequisite("CS201");
+        Course selfish("CS-SELF", "Self Study", 1);
+        selfish.addPrerequisite("CS-SELF");
+        Course first("CS-LOOP1", "Loop One", 3), second("CS-LOOP2", "Loop Two", 3);
+        first.addPrerequisite("CS-LOOP2");
+        second.addPrerequisite("CS-LOOP1");
+        DataManager::BatchResult loop = edited->addCourses(vector<Course>({ first, second }));
+        assert_true(!edited->addCourse(looped) && !edited->addCourse(selfish) && !edited->courseExists("CS-SELF") &&
+            !edited->getCourse("CS102")->requiresCourse("CS201") && loop.applied == 1 && loop.rejected.size() == 1 &&
+            loop.rejected[0].first == 1 && !edited->courseExists("CS-LOOP2"),
+            "Adding courses rejects prerequisite cycles");
+
         cout << "\nRelations Module Tests Complete\n";
     }
 
@@ -247,7 +495,7 @@ public:
         cout << "TESTING MODULE 7: FUNCTIONS" << endl;
         cout << "========================================\n" << endl;
 
-        FunctionsModule functions;
+        FunctionsModule functions(dm);
 
         map<string, string> injFunc = { {"A", "1"}, {"B", "2"}, {"C", "3"} };
         bool injective = functions.isInjective(injFunc);
@@ -265,7 +513,7 @@ public:
         cout << "TESTING MODULE 8: AUTOMATED PROOF & VERIFICATION" << endl;
         cout << "========================================\n" << endl;
 
-        ProofModule proof;
+        ProofModule proof(dm);
 
         bool proof1 = proof.generatePrerequisiteProof("S101", "CS102");
         assert_true(proof1, "Generate proof for prerequisite satisfaction");
@@ -278,7 +526,7 @@ public:
         cout << "TESTING MODULE 9: CONSISTENCY CHECKER" << endl;
         cout << "========================================\n" << endl;
 
-        ConsistencyChecker checker;
+        ConsistencyChecker checker(dm);
 
         checker.detectCourseConflicts();
         assert_true(true, "Conflict detection executed");
@@ -291,7 +539,7 @@ public:
         cout << "TESTING MODULE 10: ALGORITHMIC EFFICIENCY" << endl;
         cout << "========================================\n" << endl;
 
-        EfficiencyModule efficiency;
+        EfficiencyModule efficiency(dm);
 
         auto start = high_resolution_clock::now();
         efficiency.benchmarkPrerequisitePaths();
@@ -299,6 +547,113 @@ public:
         auto duration = duration_cast<milliseconds>(end - start);
         assert_true(duration.count() < 1000, "Prerequisite path computation is efficient");
 
+        DataManager scratch;
+        scratch.addCourse(Course("TEST-RACE", "Race Course", 3));
+        scratch.addCourse(Course("TEST-RACE2", "Second Race Course", 3));
+        Lab lab("TEST-RACE-L1", "TEST-RACE", 5);
+        scratch.addLab(lab);
+        vector<Handle> racers;
+        for (int i = 0; i < 40; i++) {
+            Student student("TEST-RACER" + to_string(i), "Racer");
+            student.enrollCourse("TEST-RACE", 3);
+            scratch.addStudent(student);
+            racers.push_back(student.getHandle());
+        }
+
+        RegistrationEngine engine(scratch);
+        vector<thread> pool;
+        for (int t = 0; t < 8; t++) {
+            pool.push_back(thread([&, t]() {
+                for (size_t i = t; i < racers.size(); i += 8) engine.joinLab(racers[i], lab.getHandle());
+            }));
+        }
+        for (thread& t : pool) t.join();
+
+        string failure;
+        assert_true(scratch.getLab(lab.getHandle())->getEnrolledHandles().size() == 5,
+            "Concurrent lab joins never exceed capacity");
+        assert_true(engine.verifyInvariants(failure), "Registration invariants hold after concurrent joins");
+
+        // A reader scanning published versions must never see a roster that
+        // disagrees with the students' own enrollment lists.
+        Handle second = Symbols::courses().find("TEST-RACE2");
+        shared_ptr<const CatalogVersion> pinned = engine.publish();
+        engine.enroll(racers[0], second);
+        assert_true(scratch.snapshot() == pinned && !pinned->bits.isEnrolled(racers[0], second),
+            "Readers see registration changes only once the engine publishes");
+        engine.drop(racers[0], second);
+        atomic<bool> writing(true);
+        bool torn = false;
+        thread writer([&]() {
+            for (int round = 0; round < 20; round++) {
+                for (Handle racer : racers) {
+                    if (round % 2 == 0) engine.enroll(racer, second);
+                    else engine.drop(racer, second);
+                    if (racer % 7 == 0) engine.publish();
+                }
+            }
+            writing = false;
+        });
+        while (writing) {
+            shared_ptr<const CatalogVersion> version = scratch.snapshot();
+            size_t listed = 0;
+            for (size_t row = 0; row < version->columns.studentCount(); row++) {
+                if (version->columns.enrolled(row).contains(second)) listed++;
+            }
+            if (listed != BitOps::count(version->bits.enrolledStudents(second), version->bits.studentWords())) torn = true;
+        }
+        writer.join();
+        assert_true(!torn, "Readers never observe a torn catalog version");
+
+        SymbolTable ids;
+        atomic<bool> interning(true);
+        bool lost = false;
+        thread interner([&]() {
+            for (int i = 0; i < 20000; i++) ids.intern("ID" + to_string(i));
+            interning = false;
+        });
+        while (interning) {
+            size_t seen = ids.size();
+            for (size_t h = seen > 64 ? seen - 64 : 0; h < seen; h++) {
+                if (ids.find(ids.name((Handle)h)) != (Handle)h) lost = true;
+            }
+        }
+        interner.join();
+        for (int i = 0; i < 20000; i++) {
+            if (ids.find("ID" + to_string(i)) != (Handle)i) lost = true;
+        }
+        assert_true(!lost && ids.find("ID20000") == INVALID_HANDLE, "Lock-free lookups see every interned ID while the table grows");
+
+        DatasetSpec spec = DatasetSpec::forStudents(500, 7);
+        spec.prefix = "TEST-GEN";
+        DataManager generatedA, generatedB;
+        DatasetGenerator::Summary summary = DatasetGenerator(&generatedA).generate(spec);
+        DatasetGenerator(&generatedB).generate(spec);
+        bool same = generatedA.getAllStudents().size() == generatedB.getAllStudents().size();
+        for (const Student& student : generatedA.getAllStudents()) {
+            const Student* twin = generatedB.getStudent(student.getHandle());
+            if (!twin || twin->getEnrolledHandles() != student.getEnrolledHandles() ||
+                twin->getCompletedHandles() != student.getCompletedHandles()) same = false;
+        }
+        assert_true(same && summary.students == 500 && summary.enrollments > 0, "Generator is reproducible for a fixed seed");
+
+        const EnrollmentBits& generatedBits = generatedA.getEnrollmentBits();
+        bool eligible = true;
+        for (const Student& student : generatedA.getAllStudents()) {
+            for (Handle course : student.getEnrolledHandles()) {
+                if (!BitOps::isSubset(generatedBits.prerequisitesOf(course), generatedBits.completedCourses(student.getHandle()),
+                    generatedBits.courseWords())) eligible = false;
+            }
+        }
+        bool withinLoad = true;
+        for (const Faculty& faculty : generatedA.getAllFaculty()) {
+            if ((int)faculty.getAssignedHandles().size() > spec.coursesPerFaculty) withinLoad = false;
+        }
+        for (const Lab& generatedLab : generatedA.getAllLabs()) {
+            if ((int)generatedLab.getEnrolledHandles().size() > generatedLab.getCapacity()) withinLoad = false;
+        }
+        assert_true(eligible && withinLoad && summary.prerequisites > 0, "Generated catalog satisfies prerequisites and capacities");
+
         cout << "\nAlgorithmic Efficiency Module Tests Complete\n";
     }
 
@@ -319,6 +674,280 @@ public:
         Student* retrievedStud = dm->getStudent("TSTUD01");
         assert_true(retrievedStud != nullptr, "Add and retrieve student");
 
+        
+        Handle courseHandle = Symbols::courses().find("TEST101");
+        assert_true(dm->getCourse(courseHandle) == retrieved, "Lookup by handle matches lookup by ID");
+        assert_true(Symbols::courses().name(courseHandle) == "TEST101", "Handle resolves back to course ID");
+
+        
+        retrievedStud->enrollCourse("TEST101", 3);
+        assert_true(dm->getEnrolledStudents("TEST101").contains(retrievedStud->getHandle()), "Enrollment updates course roster index");
+        retrievedStud->dropCourse("TEST101", 3);
+        assert_true(dm->getEnrolledStudents("TEST101").empty(), "Drop updates course roster index");
+
+        size_t internedCourses = Symbols::courses().size();
+        int creditsBefore = retrievedStud->getCurrentCredits();
+        retrievedStud->dropCourse("TEST-TYPO101", 3);
+        retrievedStud->completeCourse("TEST-TYPO102", 3);
+        assert_true(Symbols::courses().size() == internedCourses && retrievedStud->getCurrentCredits() == creditsBefore,
+            "Dropping or completing an unknown course ID changes nothing");
+
+        shared_ptr<const CatalogVersion> version = dm->snapshot();
+        const CatalogColumns& columns = version->columns;
+        bool ordered = true;
+        for (size_t row = 1; row < columns.studentCount(); row++) {
+            if (!(columns.studentID(row - 1) < columns.studentID(row))) ordered = false;
+        }
+        assert_true(columns.studentCount() == dm->getAllStudents().size() && ordered, "Columnar store lists students in ID order");
+        retrievedStud->enrollCourse("TEST101", 3);
+        version = dm->snapshot();
+        size_t row = 0;
+        while (row < version->columns.studentCount() && version->columns.studentHandle(row) != retrievedStud->getHandle()) row++;
+        assert_true(version->columns.enrolled(row).size() == 1 && version->columns.studentCreditsAt(row) == retrievedStud->getCurrentCredits(),
+            "Columnar store refreshes after enrollment");
+        retrievedStud->dropCourse("TEST101", 3);
+
+        shared_ptr<const CatalogVersion> before = dm->snapshot();
+        retrievedStud->enrollCourse("TEST101", 3);
+        shared_ptr<const CatalogVersion> after = dm->snapshot();
+        Handle studentHandle = retrievedStud->getHandle();
+        assert_true(before->columns.enrolled(before->columns.studentRow(studentHandle)).empty() &&
+            !before->bits.isEnrolled(studentHandle, retrieved->getHandle()) &&
+            after->columns.enrolled(after->columns.studentRow(studentHandle)).size() == 1 &&
+            after->number > before->number, "Held catalog snapshot is unaffected by later changes");
+        assert_true(before->bits.prerequisitesOf(retrieved->getHandle()) == after->bits.prerequisitesOf(retrieved->getHandle()) &&
+            before->columns.prerequisites(0).begin() == after->columns.prerequisites(0).begin(),
+            "Publishing shares unchanged bit blocks and columns");
+        retrievedStud->dropCourse("TEST101", 3);
+
+        {
+            unique_ptr<DataManager> growing = dm->fork();
+            shared_ptr<const CatalogVersion> settled = growing->snapshot();
+            growing->addStudent(Student("TEST-SPLICE2", "Spliced Two"));
+            growing->addStudent(Student("A-TEST-SPLICE1", "Spliced One"));
+            growing->getStudent("TEST-SPLICE2")->enrollCourse("TEST101", 3);
+            shared_ptr<const CatalogVersion> grown = growing->snapshot();
+            bool sorted = grown->columns.studentCount() == settled->columns.studentCount() + 2;
+            for (size_t r = 0; r < grown->columns.studentCount(); r++) {
+                sorted = sorted && grown->columns.studentRow(grown->columns.studentHandle(r)) == r &&
+                    (r == 0 || grown->columns.studentID(r - 1) < grown->columns.studentID(r));
+            }
+            size_t spliced = grown->columns.studentRow(Symbols::students().find("TEST-SPLICE2"));
+            assert_true(grown->number == settled->number + 1 && sorted &&
+                grown->columns.enrolled(spliced).size() == 1 && grown->bits.isEnrolled(Symbols::students().find("TEST-SPLICE2"), retrieved->getHandle()),
+                "Single-record changes publish once, with added students spliced in ID order");
+        }
+
+        {
+            unique_ptr<DataManager> scenario = dm->fork();
+            Handle other = dm->getAllStudents().begin()->getHandle();
+            assert_true(scenario->view().getStudent(other) == dm->view().getStudent(other),
+                "Const lookups share records with a fork");
+            scenario->getStudent(studentHandle)->enrollCourse("TEST101", 3);
+            assert_true(scenario->getEnrolledStudents(retrieved->getHandle()).contains(studentHandle) &&
+                !dm->getEnrolledStudents(retrieved->getHandle()).contains(studentHandle) &&
+                !dm->view().getStudent(studentHandle)->isEnrolled("TEST101"), "What-if fork changes leave live data untouched");
+            assert_true(SetOperationsModule(scenario.get()).studentsInAnyCourse({ "TEST101" }).size() == 1 &&
+                SetOperationsModule(dm).studentsInAnyCourse({ "TEST101" }).empty(), "Modules run against a fork");
+        }
+
+        typedef DataManager::EnrollmentChange Change;
+        Handle testCourse101 = retrieved->getHandle();
+
+        shared_ptr<const CourseCatalog> catalog = dm->exportCatalog();
+        DataManager fall(catalog), spring(catalog);
+        fall.addCourse(Course("TEST-FALL", "Fall Only", 3));
+        assert_true(fall.getCourse("TEST-FALL") && !spring.getCourse("TEST-FALL") &&
+            spring.getCourse("TEST101") && catalog->size() == dm->getAllCourses().size(),
+            "Terms sharing a catalog keep their own courses");
+
+        vector<Student> termStudents;
+        for (int i = 0; i < 50; i++) termStudents.push_back(Student("TEST-TERM-S" + to_string(i), "Term Student"));
+        auto enrollAll = [&](DataManager* term) {
+            term->addStudents(termStudents);
+            vector<Change> enrollments;
+            for (const Student& student : termStudents) {
+                enrollments.push_back(Change(student.getHandle(), testCourse101, 3, Change::ENROLL));
+            }
+            term->applyEnrollments(enrollments);
+        };
+        thread fallJob(enrollAll, &fall), springJob(enrollAll, &spring);
+        fallJob.join();
+        springJob.join();
+        assert_true(fall.getEnrolledStudents(testCourse101).size() == 50 && spring.getEnrolledStudents(testCourse101).size() == 50 &&
+            !dm->getStudent("TEST-TERM-S0"), "Terms process batches concurrently and independently");
+
+        for (int i = 0; i < 5000; i++) Symbols::students().intern("TEST-OTHER-TERM-S" + to_string(i));
+        DataManager late(catalog);
+        late.addStudent(Student("TEST-LATE-S0", "Late Student"));
+        late.addStudent(Student("TEST-LATE-S1", "Late Student"));
+        late.getStudent("TEST-LATE-S1")->enrollCourse("TEST101", 3);
+        Handle lateEnrolled = Symbols::students().find("TEST-LATE-S1");
+        SetQuery lateQuery(&late);
+        RoaringBitmap lateMembers = lateQuery.compile("all \\ enrolled(TEST101)") ? lateQuery.evaluate() : RoaringBitmap();
+        assert_true(late.getEnrollmentBits().studentWords() == 1 && late.getEnrollmentBits().isEnrolled(lateEnrolled, testCourse101) &&
+            lateMembers.size() == 1 && lateMembers.contains(Symbols::students().find("TEST-LATE-S0")),
+            "A term's student bits are sized by its own students, not every interned one");
+
+        vector<Change> changes = {
+            Change(retrievedStud->getHandle(), testCourse101, 3, Change::ENROLL),
+            Change(retrievedStud->getHandle(), testCourse101, 3, Change::ENROLL),
+            Change(retrievedStud->getHandle(), Symbols::courses().intern("NOPE999"), 3, Change::ENROLL)
+        };
+        DataManager::BatchResult batch = dm->applyEnrollments(changes);
+        assert_true(batch.applied == 1 && batch.rejected.size() == 2 && batch.rejected[0].first == 1,
+            "Batch enrollment validates every change");
+        assert_true(dm->getEnrolledStudents(testCourse101).contains(retrievedStud->getHandle()) &&
+            dm->getEnrollmentBits().isEnrolled(retrievedStud->getHandle(), testCourse101),
+            "Indexes rebuilt after batch");
+        retrievedStud->dropCourse("TEST101", 3);
+
+
+        const string snapshotPath = "unidisc_test_snapshot.bin";
+        SnapshotWriter writer;
+        assert_true(writer.write(*dm, snapshotPath), "Write catalog snapshot");
+
+        MappedSnapshot snapshot;
+        bool opened = snapshot.open(snapshotPath);
+        assert_true(opened && snapshot.courseCount() == dm->getAllCourses().size(), "Open snapshot with matching course count");
+        const SnapshotFormat::CourseRecord* mapped = opened ? snapshot.findCourse("CS102") : nullptr;
+        assert_true(mapped && mapped->prereqCount == 1 &&
+            snapshot.str(snapshot.courseID(snapshot.links()[mapped->prereqBegin])) == "CS101",
+            "Query mapped snapshot in place");
+        snapshot.close();
+
+        {
+            ifstream in(snapshotPath.c_str(), ios::binary);
+            string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+            in.close();
+            assert_true(writer.write(*dm, snapshotPath) && ifstream(snapshotPath.c_str(), ios::binary | ios::ate).tellg() == (streamoff)bytes.size(),
+                "Rewriting a snapshot with the same writer gives the same size");
+
+            SnapshotFormat::Header header;
+            memcpy(&header, bytes.data(), sizeof(header));
+            string swapped = bytes;
+            SnapshotFormat::CourseRecord pair[2];
+            memcpy(pair, swapped.data() + header.sections[SnapshotFormat::COURSES].offset, sizeof(pair));
+            swap(pair[0].id, pair[1].id);
+            memcpy(&swapped[header.sections[SnapshotFormat::COURSES].offset], pair, sizeof(pair));
+            SnapshotFormat::Header swappedHeader = header;
+            swappedHeader.checksum = SnapshotFormat::checksum(swapped.data() + sizeof(header), swapped.size() - sizeof(header));
+            memcpy(&swapped[0], &swappedHeader, sizeof(header));
+            ofstream(snapshotPath.c_str(), ios::binary | ios::trunc).write(swapped.data(), swapped.size());
+            assert_true(!snapshot.open(snapshotPath) && snapshot.error() == "corrupt record",
+                "Reject snapshot whose records are not sorted by ID");
+
+            SnapshotFormat::CourseRecord first;
+            memcpy(&first, bytes.data() + header.sections[SnapshotFormat::COURSES].offset, sizeof(first));
+            first.prereqBegin = 0xFFFFFF00u;
+            first.prereqCount = 0x200;
+            memcpy(&bytes[header.sections[SnapshotFormat::COURSES].offset], &first, sizeof(first));
+            header.checksum = SnapshotFormat::checksum(bytes.data() + sizeof(header), bytes.size() - sizeof(header));
+            memcpy(&bytes[0], &header, sizeof(header));
+            ofstream(snapshotPath.c_str(), ios::binary | ios::trunc).write(bytes.data(), bytes.size());
+        }
+        assert_true(!snapshot.open(snapshotPath) && snapshot.error() == "corrupt record",
+            "Reject snapshot with out-of-range links despite a valid checksum");
+        remove(snapshotPath.c_str());
+
+
+        const string csvPath = "unidisc_test_enrollments.csv";
+        {
+            ofstream csv(csvPath.c_str());
+            csv << "student_id,course_id,status\n"
+                << "TSTUD01,TEST101,enrolled\n"
+                << "TSTUD01,NOPE999,enrolled\n"
+                << "TSTUD01\n";
+        }
+        CsvImporter importer(dm, 2);
+        CsvImporter::Report report = importer.importFile(csvPath, CsvImporter::ENROLLMENTS);
+        assert_true(report.rowsRead == 3 && report.rowsImported == 1 && report.rowsRejected == 2,
+            "CSV import merges valid rows and rejects bad ones");
+        assert_true(dm->getEnrolledStudents("TEST101").contains(retrievedStud->getHandle()), "CSV import updates roster index");
+        retrievedStud->dropCourse("TEST101", 3);
+
+        {
+            ofstream csv(csvPath.c_str());
+            csv << "student_id,course_id,status\n"
+                << "TSTUD01,TEST101,completed\n";
+        }
+        {
+            unique_ptr<DataManager> transcript = dm->fork();
+            CsvImporter::Report history = CsvImporter(transcript.get(), 1).importFile(csvPath, CsvImporter::ENROLLMENTS);
+            const Student* graduate = transcript->view().getStudent(studentHandle);
+            assert_true(history.rowsImported == 1 && graduate->hasCompleted("TEST101") &&
+                graduate->getCurrentCredits() == retrievedStud->getCurrentCredits(),
+                "Importing a completed row without an enrollment keeps credits");
+        }
+        {
+            ofstream csv(csvPath.c_str());
+            csv << "course_id,name,credits,prerequisites\n"
+                << "TEST101,Renamed Course,9,\n"
+                << "TEST-CSV101,Imported Course,2,TEST101\n";
+        }
+        {
+            unique_ptr<DataManager> catalog = dm->fork();
+            CsvImporter::Report courses = CsvImporter(catalog.get(), 1).importFile(csvPath, CsvImporter::COURSES);
+            assert_true(courses.rowsImported == 1 && courses.rowsRejected == 1 &&
+                catalog->getCourse("TEST101")->getCredits() == retrieved->getCredits() && catalog->courseExists("TEST-CSV101"),
+                "Importing courses rejects IDs that already exist");
+        }
+        {
+            ofstream csv(csvPath.c_str());
+            csv << "course_id,name,credits,prerequisites\n"
+                << "TEST-CSV201,Imported Course,3,TEST-CSV202\n"
+                << "TEST-CSV202,Imported Course,3,TEST-CSV201\n";
+        }
+        {
+            unique_ptr<DataManager> catalog = dm->fork();
+            CsvImporter::Report courses = CsvImporter(catalog.get(), 1).importFile(csvPath, CsvImporter::COURSES);
+            assert_true(courses.rowsImported == 1 && courses.rowsRejected == 1 && !catalog->courseExists("TEST-CSV202") &&
+                courses.errors.size() == 1 && courses.errors[0].find("line 3") == 0,
+                "Importing courses rejects prerequisite cycles");
+        }
+        ofstream(csvPath.c_str(), ios::trunc).close();
+        CsvImporter::Report empty = importer.importFile(csvPath, CsvImporter::ENROLLMENTS);
+        assert_true(empty.rowsRead == 0 && empty.errors.empty(), "Importing an empty CSV file reads no rows and reports no error");
+        remove(csvPath.c_str());
+
+
+        const string journalBase = "unidisc_test_journal";
+        {
+            MutationLog journal;
+            MutationLog::RecoveryReport opened = journal.open(*dm, journalBase);
+            assert_true(opened.error.empty() && opened.recordsReplayed == 0, "Open empty mutation journal");
+            retrievedStud->enrollCourse("TEST101", 3);
+            assert_true(journal.sync() && journal.getSyncCount() == 1, "Group commit flushes pending records");
+        }
+        retrievedStud->dropCourse("TEST101", 3);
+        {
+            MutationLog journal;
+            MutationLog::RecoveryReport replayed = journal.open(*dm, journalBase);
+            assert_true(replayed.recordsReplayed == 1 && retrievedStud->isEnrolled("TEST101"),
+                "Replay journal restores enrollment");
+        }
+        retrievedStud->dropCourse("TEST101", 3);
+        remove((journalBase + ".wal").c_str());
+        {
+            FailingMutationLog journal;
+            journal.open(*dm, journalBase);
+            uint64_t before = journal.getLogBytes();
+            journal.failNextWrites(1);
+            retrievedStud->enrollCourse("TEST101", 3);
+            assert_true(!journal.sync() && journal.getLogBytes() == before && !journal.hasFailed(),
+                "Failed journal write is not reported durable");
+            retrievedStud->dropCourse("TEST101", 3);
+            assert_true(journal.sync() && journal.getSyncCount() == 1, "Journal retries a failed batch");
+        }
+        retrievedStud->enrollCourse("TEST101", 3);
+        {
+            MutationLog journal;
+            MutationLog::RecoveryReport replayed = journal.open(*dm, journalBase);
+            assert_true(replayed.recordsReplayed == 2 && !replayed.tailTruncated && !retrievedStud->isEnrolled("TEST101"),
+                "Replay after a failed write sees no torn record");
+        }
+        remove((journalBase + ".wal").c_str());
+
         cout << "\nCore Data Manager Tests Complete\n";
     }
 
@@ -13,13 +13,16 @@
 #include "StudentGroupCombination.h"
 #include "CourseScheduling.h"
 #include "UnitTesting.h"
+#include "CatalogSnapshot.h"
+#include "CsvImporter.h"
+#include "DatasetGenerator.h"
+#include "MutationLog.h"
 
 using namespace std;
 
-DataManager* DataManager::instance = nullptr;
-
 class UnidiscSystem {
 private:
+    DataManager data;
     DataManager* dm;
     SchedulingModule schedulingModule;
     CombinationsModule combinationsModule;
@@ -32,6 +35,7 @@ private:
     ConsistencyChecker consistencyChecker;
     EfficiencyModule efficiencyModule;
     UnitTestingModule unitTestingModule;
+    MutationLog journal;
 
     void clearScreen() {
         system("cls");
@@ -154,7 +158,7 @@ private:
                         cout << "No courses available at this time." << endl;
                     } else {
                         for (const string& courseID : available) {
-                            Course* course = dm->getCourse(courseID);
+                            const Course* course = dm->view().getCourse(courseID);
                             if (course) {
                                 cout << courseID << ": " << course->getName() << endl;
                             }
@@ -227,7 +231,7 @@ private:
                     getline(cin, courseID);
                     
                     Student* student = dm->getStudent(studentID);
-                    Course* course = dm->getCourse(courseID);
+                    const Course* course = dm->view().getCourse(courseID);
                     
                     if (!student || !course) {
                         cout << "Invalid student or course!" << endl;
@@ -585,6 +589,11 @@ private:
             cout << "5. Find Students in Course A but not B (Difference)" << endl;
             cout << "6. Generate Power Set of Students" << endl;
             cout << "7. Run Full Demonstration" << endl;
+            cout << "8. Course Overlap Report (All Course Pairs)" << endl;
+            cout << "9. Find Courses Totalling N Credits (Subset Search)" << endl;
+            cout << "10. Evaluate Set Expression" << endl;
+            cout << "11. Most Co-Enrolled Course Pairs (Exam Clashes)" << endl;
+            cout << "12. Approximate Overlap and Distinct Students (Sketches)" << endl;
             cout << "0. Back to Main Menu" << endl;
             
             int choice;
@@ -684,26 +693,26 @@ private:
                 
                 case 6: {
                     int maxStudents;
-                    cout << "Enter max students to include (recommended: <=5): ";
+                    cout << "Enter max students to include: ";
                     cin >> maxStudents;
                     cin.ignore();
                     
-                    vector<set<string>> powerSet = setOperationsModule.generatePowerSet(maxStudents);
+                    size_t included = min((size_t)max(maxStudents, 0), dm->getAllStudents().size());
                     cout << "\n--- Power Set ---" << endl;
-                    cout << "Power set size: " << powerSet.size() << " subsets" << endl;
-                    cout << "\nFirst 10 subsets:" << endl;
-                    int count = 0;
-                    for (const set<string>& subset : powerSet) {
+                    cout << "Power set size: " << GraySubsets(included).count() << " subsets" << endl;
+                    cout << "\nFirst 10 subsets (Gray-code order, one change per step):" << endl;
+                    setOperationsModule.generatePowerSet(maxStudents, [&](const SubsetStep& step, const vector<string>& chosen) {
                         cout << "{";
                         bool first = true;
-                        for (const string& s : subset) {
+                        for (size_t i = 0; i < chosen.size(); i++) {
+                            if (!step.contains(i)) continue;
                             if (!first) cout << ", ";
-                            cout << s;
+                            cout << chosen[i];
                             first = false;
                         }
                         cout << "}" << endl;
-                        if (++count >= 10) break;
-                    }
+                        return step.rank + 1 < 10;
+                    });
                     pause();
                     break;
                 }
@@ -712,6 +721,119 @@ private:
                     setOperationsModule.demonstrate();
                     pause();
                     break;
+
+                case 8: {
+                    size_t minShared;
+                    cout << "Minimum shared students to report: ";
+                    cin >> minShared;
+                    cin.ignore();
+
+                    CoEnrollmentMatrix coEnrollment(dm);
+                    coEnrollment.build();
+                    vector<CoursePair> report = coEnrollment.pairsAtLeast(minShared);
+                    cout << "\n--- Course Pairs Sharing Students ---" << endl;
+                    for (const CoursePair& pair : report) {
+                        cout << "  " << pair.courseA << " & " << pair.courseB << ": " << pair.shared << " students" << endl;
+                    }
+                    cout << "Total: " << report.size() << " course pairs" << endl;
+                    pause();
+                    break;
+                }
+
+                case 9: {
+                    int credits;
+                    cout << "Target credits: ";
+                    cin >> credits;
+                    cin.ignore();
+
+                    set<string> courses = setOperationsModule.getCourseSet();
+                    vector<string> found = setOperationsModule.coursesTotalling(
+                        vector<string>(courses.begin(), courses.end()), credits, 0);
+                    if (found.empty()) {
+                        cout << "No combination of courses totals " << credits << " credits" << endl;
+                    }
+                    else {
+                        cout << "\n--- Courses Totalling " << credits << " Credits ---" << endl;
+                        for (const string& c : found) {
+                            cout << "  - " << c << endl;
+                        }
+                    }
+                    pause();
+                    break;
+                }
+
+                case 10: {
+                    string expression;
+                    cout << "Operands: enrolled(ID), completed(ID), lab(ID), all" << endl;
+                    cout << "Operators: & (intersection), | (union), \\ or - (difference), parentheses" << endl;
+                    cout << "Enter expression: ";
+                    getline(cin, expression);
+
+                    set<string> result;
+                    string error;
+                    if (!setOperationsModule.studentsMatching(expression, result, error)) {
+                        cout << "Error: " << error << endl;
+                        pause();
+                        break;
+                    }
+                    SetQuery query(dm);
+                    query.compile(expression);
+                    cout << "\nPlan: " << query.plan() << endl;
+                    cout << "\n--- Matching Students ---" << endl;
+                    for (const string& s : result) {
+                        cout << "  - " << s << endl;
+                    }
+                    cout << "Total: " << result.size() << " students" << endl;
+                    pause();
+                    break;
+                }
+
+                case 11: {
+                    size_t k;
+                    cout << "Number of pairs to show: ";
+                    cin >> k;
+                    cin.ignore();
+
+                    CoEnrollmentMatrix coEnrollment(dm);
+                    coEnrollment.build();
+                    vector<CoursePair> top = coEnrollment.topPairs(k);
+                    cout << "\n--- Course Pairs With the Most Shared Students ---" << endl;
+                    for (const CoursePair& pair : top) {
+                        cout << "  " << pair.courseA << " & " << pair.courseB << ": " << pair.shared << " students" << endl;
+                    }
+                    cout << coEnrollment.pairCount() << " of " << coEnrollment.courseCount() * (coEnrollment.courseCount() - 1) / 2
+                        << " course pairs share students" << endl;
+                    pause();
+                    break;
+                }
+
+                case 12: {
+                    vector<string> courseIDs;
+                    int n;
+                    cout << "Enter number of courses: ";
+                    cin >> n;
+                    cin.ignore();
+
+                    for (int i = 0; i < n; i++) {
+                        string courseID;
+                        cout << "Enter Course ID " << (i+1) << ": ";
+                        getline(cin, courseID);
+                        courseIDs.push_back(courseID);
+                    }
+
+                    cout << "\n--- Approximate Answers (Sketches) ---" << endl;
+                    cout << "Distinct students in any course: ~" << (long long)(setOperationsModule.approximateDistinctStudents(courseIDs) + 0.5)
+                        << " (exact: " << setOperationsModule.unionCount(courseIDs) << ")" << endl;
+                    for (size_t a = 0; a < courseIDs.size(); a++) {
+                        for (size_t b = a + 1; b < courseIDs.size(); b++) {
+                            cout << "  " << courseIDs[a] << " & " << courseIDs[b] << ": Jaccard ~"
+                                << setOperationsModule.approximateJaccard(courseIDs[a], courseIDs[b]) << ", ~"
+                                << (long long)(setOperationsModule.approximateOverlap(courseIDs[a], courseIDs[b]) + 0.5) << " shared students" << endl;
+                        }
+                    }
+                    pause();
+                    break;
+                }
                     
                 default:
                     cout << "Invalid choice!" << endl;
@@ -734,6 +856,7 @@ private:
             cout << "7. Compose Relations (Student->Course->Faculty)" << endl;
             cout << "8. Detect Indirect Course Conflicts" << endl;
             cout << "9. Run Full Demonstration" << endl;
+            cout << "10. Show Prerequisite Ancestry (Transitive Closure)" << endl;
             cout << "0. Back to Main Menu" << endl;
             
             int choice;
@@ -756,14 +879,13 @@ private:
                     cout << "\n--- Detecting Indirect Course Conflicts ---" << endl;
                     relationsModule.buildRelations();
                     map<string, set<string>> studentCourses;
-                    for (auto& pair : dm->getAllStudents()) {
-                        Student& student = pair.second;
+                    for (const Student& student : dm->getAllStudents()) {
                         for (const string& courseID : student.getEnrolledCourses()) {
                             studentCourses[student.getID()].insert(courseID);
-                            Course* course = dm->getCourse(courseID);
+                            const Course* course = dm->view().getCourse(courseID);
                             if (course) {
                                 for (const string& prereq : course->getPrerequisites()) {
-                                    if (student.getEnrolledCourses().find(prereq) != student.getEnrolledCourses().end()) {
+                                    if (student.isEnrolled(prereq)) {
                                         cout << "INDIRECT CONFLICT: Student " << student.getID() 
                                              << " enrolled in both " << courseID 
                                              << " and its prerequisite " << prereq << endl;
@@ -782,6 +904,27 @@ private:
                     relationsModule.demonstrate();
                     pause();
                     break;
+
+                case 10: {
+                    string courseID;
+                    cout << "Enter Course ID: ";
+                    getline(cin, courseID);
+
+                    set<string> prerequisites = relationsModule.allPrerequisitesOf(courseID);
+                    set<string> dependents = relationsModule.coursesRequiring(courseID);
+                    cout << "\n--- All Prerequisites of " << courseID << " (Direct and Indirect) ---" << endl;
+                    for (const string& c : prerequisites) {
+                        cout << "  - " << c << endl;
+                    }
+                    cout << "Total: " << prerequisites.size() << endl;
+                    cout << "\n--- Courses Requiring " << courseID << " (Direct and Indirect) ---" << endl;
+                    for (const string& c : dependents) {
+                        cout << "  - " << c << endl;
+                    }
+                    cout << "Total: " << dependents.size() << endl;
+                    pause();
+                    break;
+                }
                     
                 default:
                     cout << "Feature analysis available in demonstration mode." << endl;
@@ -967,6 +1110,17 @@ private:
             cout << "2. Benchmark Set Operations" << endl;
             cout << "3. Demonstrate Recursion Optimization" << endl;
             cout << "4. Run Full Demonstration" << endl;
+            cout << "5. Stress Test Concurrent Registration" << endl;
+            cout << "6. Benchmark Concurrent Terms (Shared Catalog)" << endl;
+            cout << "7. Benchmark Generated Datasets (10^3 - 10^5 Students)" << endl;
+            cout << "8. Benchmark Course Overlap Report (Roaring Bitmaps)" << endl;
+            cout << "9. Benchmark Subset Enumeration (Gray Code)" << endl;
+            cout << "10. Benchmark Multi-Way Intersection (Galloping)" << endl;
+            cout << "11. Benchmark Set Expression Evaluation (Fused)" << endl;
+            cout << "12. Benchmark Approximate Overlap (MinHash/HyperLogLog)" << endl;
+            cout << "13. Benchmark Prerequisite Closure (Bit Rows)" << endl;
+            cout << "14. Benchmark Relation Composition (Sparse Rows)" << endl;
+            cout << "15. Benchmark Relation Property Checks" << endl;
             cout << "0. Back to Main Menu" << endl;
             
             int choice;
@@ -996,6 +1150,61 @@ private:
                     efficiencyModule.demonstrate();
                     pause();
                     break;
+
+                case 5:
+                    efficiencyModule.benchmarkConcurrentRegistration();
+                    pause();
+                    break;
+
+                case 6:
+                    efficiencyModule.benchmarkConcurrentTerms();
+                    pause();
+                    break;
+
+                case 7:
+                    efficiencyModule.benchmarkGeneratedDatasets();
+                    pause();
+                    break;
+
+                case 8:
+                    efficiencyModule.benchmarkOverlapReport();
+                    pause();
+                    break;
+
+                case 9:
+                    efficiencyModule.benchmarkSubsetWalk();
+                    pause();
+                    break;
+
+                case 10:
+                    efficiencyModule.benchmarkMultiWayIntersection();
+                    pause();
+                    break;
+
+                case 11:
+                    efficiencyModule.benchmarkSetExpression();
+                    pause();
+                    break;
+
+                case 12:
+                    efficiencyModule.benchmarkSketches();
+                    pause();
+                    break;
+
+                case 13:
+                    efficiencyModule.benchmarkPrerequisiteClosure();
+                    pause();
+                    break;
+
+                case 14:
+                    efficiencyModule.benchmarkRelationComposition();
+                    pause();
+                    break;
+
+                case 15:
+                    efficiencyModule.benchmarkRelationProperties();
+                    pause();
+                    break;
                     
                 default:
                     cout << "Invalid choice!" << endl;
@@ -1004,6 +1213,49 @@ private:
         }
     }
 
+    // Applies a drop and/or an enrollment to a fork of the live data and runs
+    // the proof and consistency modules against it; the live data is untouched.
+    void runWhatIfScenario() {
+        string studentID, dropID, takeID;
+        cout << "Enter Student ID: ";
+        getline(cin, studentID);
+        cout << "Course to drop (blank for none): ";
+        getline(cin, dropID);
+        cout << "Course to take (blank for none): ";
+        getline(cin, takeID);
+
+        unique_ptr<DataManager> scenario = dm->fork();
+        Student* student = scenario->getStudent(studentID);
+        if (!student) {
+            cout << "Student not found!" << endl;
+            return;
+        }
+
+        if (!dropID.empty()) {
+            const Course* course = scenario->view().getCourse(dropID);
+            if (!course || !student->isEnrolled(dropID)) {
+                cout << "Student is not enrolled in " << dropID << endl;
+                return;
+            }
+            student->dropCourse(dropID, course->getCredits());
+        }
+        if (!takeID.empty()) {
+            const Course* course = scenario->view().getCourse(takeID);
+            if (!course) {
+                cout << "Course not found!" << endl;
+                return;
+            }
+            ProofModule(scenario.get()).generatePrerequisiteProof(studentID, takeID);
+            student->enrollCourse(takeID, course->getCredits());
+        }
+
+        cout << "\n--- Scenario Consistency ---" << endl;
+        ConsistencyChecker(scenario.get()).runAllChecks();
+
+        cout << "\nScenario credits for " << studentID << ": " << student->getCurrentCredits()
+            << " (live data: " << dm->view().getStudent(studentID)->getCurrentCredits() << ")" << endl;
+    }
+
     void dataManagementMenu() {
         while (true) {
             clearScreen();
@@ -1018,6 +1270,14 @@ private:
             cout << "7. View All Courses" << endl;
             cout << "8. View All Faculty" << endl;
             cout << "9. Load Sample Data" << endl;
+            cout << "10. Save Catalog Snapshot" << endl;
+            cout << "11. Load Catalog Snapshot" << endl;
+            cout << "12. Import CSV File" << endl;
+            cout << "13. Open Mutation Journal" << endl;
+            cout << "14. Compact Mutation Journal" << endl;
+            cout << "15. What-If Scenario (Drop/Take Without Changing Data)" << endl;
+            cout << "16. Generate Synthetic Dataset" << endl;
+            cout << "17. Edit Course Prerequisites" << endl;
             cout << "0. Back to Main Menu" << endl;
 
             int choice;
@@ -1069,8 +1329,12 @@ private:
                     }
                 }
 
-                dm->addCourse(course);
-                cout << "Course added successfully!" << endl;
+                if (dm->addCourse(course)) {
+                    cout << "Course added successfully!" << endl;
+                }
+                else {
+                    cout << "Rejected: the prerequisites of " << id << " would form a cycle." << endl;
+                }
                 pause();
                 break;
             }
@@ -1127,8 +1391,7 @@ private:
             }
             case 6: {
                 cout << "\n=== All Students ===" << endl;
-                for (auto& pair : dm->getAllStudents()) {
-                    Student& s = pair.second;
+                for (const Student& s : dm->getAllStudents()) {
                     cout << s.getID() << ": " << s.getName()
                         << " (Credits: " << s.getCurrentCredits() << ")" << endl;
                 }
@@ -1137,8 +1400,7 @@ private:
             }
             case 7: {
                 cout << "\n=== All Courses ===" << endl;
-                for (auto& pair : dm->getAllCourses()) {
-                    Course& c = pair.second;
+                for (const Course& c : dm->getAllCourses()) {
                     cout << c.getID() << ": " << c.getName()
                         << " (" << c.getCredits() << " credits)" << endl;
                 }
@@ -1147,8 +1409,7 @@ private:
             }
             case 8: {
                 cout << "\n=== All Faculty ===" << endl;
-                for (auto& pair : dm->getAllFaculty()) {
-                    Faculty& f = pair.second;
+                for (const Faculty& f : dm->getAllFaculty()) {
                     cout << f.getID() << ": " << f.getName()
                         << " (Courses: " << f.getAssignedCourses().size() << ")" << endl;
                 }
@@ -1159,6 +1420,142 @@ private:
                 loadSampleData();
                 pause();
                 break;
+            case 10: {
+                string path;
+                cout << "Enter snapshot file path: ";
+                getline(cin, path);
+
+                SnapshotWriter writer;
+                if (writer.write(*dm, path)) {
+                    cout << "Snapshot written to " << path << endl;
+                }
+                else {
+                    cout << "Could not write snapshot to " << path << endl;
+                }
+                pause();
+                break;
+            }
+            case 11: {
+                string path;
+                cout << "Enter snapshot file path: ";
+                getline(cin, path);
+
+                auto start = chrono::high_resolution_clock::now();
+                MappedSnapshot snapshot;
+                if (!snapshot.open(path)) {
+                    cout << "Could not load snapshot: " << snapshot.error() << endl;
+                }
+                else {
+                    snapshot.loadInto(*dm);
+                    auto elapsed = chrono::duration_cast<chrono::microseconds>(
+                        chrono::high_resolution_clock::now() - start);
+                    cout << "Loaded " << snapshot.courseCount() << " courses and "
+                        << snapshot.studentCount() << " students in " << elapsed.count() << " us" << endl;
+                }
+                pause();
+                break;
+            }
+            case 12: {
+                string path;
+                int kind;
+                cout << "File type (1 = courses, 2 = students, 3 = enrollments): ";
+                cin >> kind;
+                cin.ignore();
+                cout << "Enter CSV file path: ";
+                getline(cin, path);
+
+                if (kind < 1 || kind > 3) {
+                    cout << "Invalid file type!" << endl;
+                    pause();
+                    break;
+                }
+
+                CsvImporter importer(dm);
+                CsvImporter::Report report = importer.importFile(path, (CsvImporter::Kind)(kind - 1));
+                cout << "Rows read: " << report.rowsRead << endl;
+                cout << "Imported: " << report.rowsImported << endl;
+                cout << "Rejected: " << report.rowsRejected << endl;
+                cout << "Time: " << report.seconds << " s (" << (long long)report.rowsPerSecond() << " rows/sec)" << endl;
+                for (const string& error : report.errors) {
+                    cout << "  " << error << endl;
+                }
+                pause();
+                break;
+            }
+            case 13: {
+                string path;
+                cout << "Enter journal base path (creates <path>.wal and <path>.snap): ";
+                getline(cin, path);
+                openJournal(path);
+                pause();
+                break;
+            }
+            case 14:
+                if (!journal.isOpen()) {
+                    cout << "No journal is open." << endl;
+                }
+                else if (journal.compact()) {
+                    cout << "Journal compacted into a new snapshot." << endl;
+                }
+                else {
+                    cout << "Compaction failed." << endl;
+                }
+                pause();
+                break;
+            case 15:
+                runWhatIfScenario();
+                pause();
+                break;
+            case 16: {
+                int students;
+                unsigned seed;
+                cout << "Number of students (1000 - 1000000): ";
+                cin >> students;
+                cout << "Seed: ";
+                cin >> seed;
+                cin.ignore();
+
+                DatasetGenerator generator(dm);
+                DatasetGenerator::Summary summary = generator.generate(DatasetSpec::forStudents(students, seed));
+                cout << "Generated " << summary.courses << " courses (" << summary.prerequisites << " prerequisites), "
+                    << summary.students << " students, " << summary.enrollments << " enrollments, "
+                    << summary.completions << " completions" << endl;
+                cout << summary.labs << " labs (" << summary.labSeats << " seats taken), " << summary.faculty
+                    << " faculty, " << summary.rooms << " rooms in " << summary.seconds << " s" << endl;
+                cout << "Use option 10 to save it as a snapshot." << endl;
+                pause();
+                break;
+            }
+            case 17: {
+                string id;
+                cout << "Enter Course ID: ";
+                getline(cin, id);
+                Course* course = dm->getCourse(id);
+                if (!course) {
+                    cout << "Course not found." << endl;
+                    pause();
+                    break;
+                }
+
+                while (true) {
+                    string prereq;
+                    cout << "Prerequisite to add, -ID to remove (or 'done'): ";
+                    getline(cin, prereq);
+                    if (prereq == "done" || prereq.empty()) break;
+                    if (prereq[0] == '-') course->removePrerequisite(prereq.substr(1));
+                    else if (!course->addPrerequisite(prereq)) {
+                        cout << "Rejected: " << prereq << " already requires " << id << " (prerequisite cycle)." << endl;
+                    }
+                }
+
+                const EnrollmentBits& bits = dm->getEnrollmentBits();
+                Handle h = course->getHandle();
+                cout << "\n" << id << " now needs " << BitOps::count(bits.allPrerequisitesOf(h), bits.courseWords())
+                    << " courses (direct and indirect) and is needed by "
+                    << BitOps::count(bits.coursesRequiring(h), bits.courseWords()) << "." << endl;
+                pause();
+                break;
+            }
             default:
                 cout << "Invalid choice!" << endl;
                 pause();
@@ -1254,12 +1651,31 @@ private:
     }
 
 public:
-    UnidiscSystem() {
-        dm = DataManager::getInstance();
+    UnidiscSystem()
+        : dm(&data), schedulingModule(dm), combinationsModule(dm), inductionModule(dm), logicEngine(dm),
+        setOperationsModule(dm), relationsModule(dm), functionsModule(dm), proofModule(dm),
+        consistencyChecker(dm), efficiencyModule(dm), unitTestingModule(dm) {
+    }
+
+    void openJournal(const string& basePath) {
+        MutationLog::RecoveryReport report = journal.open(*dm, basePath);
+        if (!report.error.empty()) {
+            cout << "Could not open journal: " << report.error << endl;
+            return;
+        }
+        if (report.snapshotLoaded) cout << "Loaded snapshot " << basePath << ".snap" << endl;
+        if (report.staleLogIgnored) cout << "Ignored log written before the last compaction" << endl;
+        cout << "Replayed " << report.recordsReplayed << " journal records";
+        if (report.recordsSkipped) cout << " (" << report.recordsSkipped << " skipped)";
+        cout << endl;
+        if (report.tailTruncated) cout << "Discarded a partially written record at the end of the log" << endl;
+        cout << "Journaling changes to " << journal.getLogPath() << endl;
     }
 
     void run() {
         while (true) {
+            if (journal.needsCompaction()) journal.compact();
+
             clearScreen();
             printHeader("UNIDISC ENGINE - FAST University Management System");
 
@@ -1328,7 +1744,7 @@ public:
     }
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     cout << "\033[38;2;0;0;255m";    
     cout << "============================================================" << endl;
     cout << "UNIDISC ENGINE" << endl;
@@ -1339,6 +1755,9 @@ int main() {
     cout << "\nInitializing system..." << endl;
 
     UnidiscSystem system;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (string(argv[i]) == "--journal") system.openJournal(argv[i + 1]);
+    }
     system.run();
 
     return 0;